@@ -42,13 +42,11 @@ start:
     movl $stack_top, %esp
     xorl %ebp, %ebp
 
-    /* Jeśli kiedyś chcemy przekazać magic/mbi:
-       ; pushl %ebx     ; ptr do multiboot info
-       ; pushl %eax     ; magic 0x2BADB002
-       ; call kmain
-       ; add $8, %esp
-    */
+    /* kmain(magic, mbi): %eax = 0x2BADB002, %ebx = multiboot info */
+    pushl %ebx
+    pushl %eax
     call kmain
+    addl $8, %esp
 
 .hang:
     hlt
@@ -46,26 +46,16 @@ static inline int ata_lba_write(uint8_t disk_id, uint32_t lba, const void* buf)
     return ata_write_sector(lba, (const uint8_t*)buf);
 }
 
-/* Odczyt wielu sektorów z rzędu (prosta pętla). */
+/* Odczyt wielu sektorów z rzędu (komendy wielosektorowe). */
 static inline int ata_lba_read_n(uint8_t disk_id, uint32_t lba, uint32_t count, void* buf) {
-    uint8_t* p = (uint8_t*)buf;
-    for (uint32_t i = 0; i < count; i++) {
-        if (ata_lba_read(disk_id, lba + i, p + i * CYG_SECTOR_SIZE) != 0) {
-            return -1;
-        }
-    }
-    return 0;
+    (void)disk_id;
+    return ata_read_n(lba, count, buf);
 }
 
 /* Zapis wielu sektorów. */
 static inline int ata_lba_write_n(uint8_t disk_id, uint32_t lba, uint32_t count, const void* buf) {
-    const uint8_t* p = (const uint8_t*)buf;
-    for (uint32_t i = 0; i < count; i++) {
-        if (ata_lba_write(disk_id, lba + i, p + i * CYG_SECTOR_SIZE) != 0) {
-            return -1;
-        }
-    }
-    return 0;
+    (void)disk_id;
+    return ata_write_n(lba, count, buf);
 }
 
 #endif /* CYGNUS_ATA_H */
\ No newline at end of file
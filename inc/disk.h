@@ -60,6 +60,7 @@ int disk_count(void);
 
 /* UJEDNOLICONA SYGNATURA: count jest uint32_t */
 int disk_read_sectors(int disk_id, uint32_t lba, uint32_t count, void* buf);
+int disk_write_sectors(int disk_id, uint32_t lba, uint32_t count, const void* buf);
 
 /* Skan MBR – wypełnia 4 wpisy; zwraca 0 gdy OK, <0 gdy błąd/sygnatura != 0xAA55 */
 int mbr_scan(int disk_id, mbr_partition_t out_parts[4]);
@@ -67,4 +68,7 @@ int mbr_scan(int disk_id, mbr_partition_t out_parts[4]);
 /* Adapter dla FAT32: MUSI mieć uint64_t lba (jak w fat32_read_sectors_fn) */
 int fat32_read_from_disk(void* dev, uint64_t lba, uint32_t count, void* buf);
 
+/* Zapis dla FAT32 (fat32_write_sectors_fn) – używany przez defrag. */
+int fat32_write_to_disk(void* dev, uint64_t lba, uint32_t count, const void* buf);
+
 #endif /* CYGNUS_DISK_H */
\ No newline at end of file
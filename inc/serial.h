@@ -21,6 +21,7 @@
 #ifndef CYGNUS_SERIAL_H
 #define CYGNUS_SERIAL_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 /* Domyślna baza dla COM1 */
@@ -36,7 +37,13 @@ void serial_init(uint16_t base);
 /* Jeżeli mamy kilka portów, możemy zmienić bazę „w locie”. */
 void serial_set_base(uint16_t base);
 
-/* Wypisanie jednego znaku (blokujące).
+/* Przechodzimy na IRQ4: odbiór i nadawanie przez bufory pierścieniowe.
+ * Wymaga irq_init; przerwania (sti) włącza wołający. Do tego czasu
+ * sterownik odpytuje UART jak dawniej. */
+void serial_enable_irq(void);
+
+/* Wypisanie jednego znaku. Po serial_enable_irq zapis tylko dokłada do
+ * bufora (czeka, gdy ten jest pełny), wcześniej – blokujące.
  * Dla wygody wysyłamy CR przed LF (tj. '\r' przed '\n').
  */
 void serial_write_char(char c);
@@ -44,10 +51,24 @@ void serial_write_char(char c);
 /* Wypisanie łańcucha znaków (blokujące). */
 void serial_write(const char *s);
 
+/* Wypisanie 'n' bajtów (LF → CR+LF). Bez IRQ – porcjami po rozmiarze
+ * FIFO, status linii sprawdzamy raz na porcję, a nie przy każdym bajcie. */
+void serial_write_n(const char *s, size_t n);
+
+/* Jak serial_write_n, ale bajt w bajt (bez CR przed LF) – dane binarne. */
+void serial_write_raw(const void *buf, size_t n);
+
+/* Czeka, aż wszystko z bufora wyjdzie na linię (np. przed resetem). */
+void serial_flush(void);
+
 /* Czy jest znak do odczytu? Zwracamy !=0, jeżeli tak. */
 int  serial_can_read(void);
 
-/* Odczyt jednego znaku (blokujący). */
+/* Odczyt jednego znaku (blokujący; z IRQ śpimy w hlt do przyjścia danych). */
 char serial_read(void);
 
+/* Usypia CPU do najbliższego przerwania, jeżeli nie ma czego czytać
+ * (bez IRQ wraca od razu). */
+void serial_wait_rx(void);
+
 #endif /* CYGNUS_SERIAL_H */
@@ -22,22 +22,48 @@
 #define STD_H
 
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 
-/* I/O na konsolę (UART) */
+/* I/O na konsolę (UART + ewentualne dodatkowe ujścia, patrz niżej) */
 void print(const char *s);     /* drukuje łańcuch (bez formatowania) */
 void putchar(char c);          /* drukuje 1 znak */
 char serial_read(void);        /* blokujący odczyt znaku z UART */
 void gets(char *buf, int max); /* bardzo prosty input (bez historii/edycji) */
 
-/* Minimalny printf dla jądra (UART):
- * wspiera: %s %c %d %u %x %p oraz %%.
+/* Ujście dla formatera: dostaje gotowy tekst kawałkami (do KPRINTF_CHUNK
+ * bajtów naraz, dłuższe %s w całości). Nic nie jest obcinane – formatujemy
+ * strumieniowo. 'ctx' do dowolnego użytku przez ujście. */
+typedef struct ksink {
+    void (*write)(struct ksink *s, const char *buf, size_t n);
+    void *ctx;
+} ksink_t;
+
+#define KPRINTF_CHUNK      64
+#define KPRINTF_MAX_SINKS  6
+
+/* UART (porcjami po FIFO) – domyślnie podpięty do konsoli */
+extern ksink_t g_ksink_serial;
+
+/* Konsola = lista ujść, do których trafia kprintf/print/putchar
+ * (np. UART + bufor logu). add zwraca -1, gdy brak miejsca. */
+int  kprintf_add_sink(ksink_t *s);
+void kprintf_remove_sink(ksink_t *s);
+
+/* printf dla jądra:
+ * wspiera: %s %c %d %i %u %x %X %p oraz %%,
+ * flagi '-' i '0', szerokość (też '*'), precyzję dla %s,
+ * modyfikatory l/ll/z (%llu, %llx, %lld – wartości 64-bitowe).
+ * kprintf pisze na konsolę, kfprintf do wskazanego ujścia.
  */
 void kprintf(const char *fmt, ...);
+int  kvprintf(const char *fmt, va_list ap);
+int  kfprintf(ksink_t *sink, const char *fmt, ...);
+int  kvfprintf(ksink_t *sink, const char *fmt, va_list ap);
 
 /* Formatowanie do bufora:
- * ksnprintf(buf, sz, fmt, ...) zwraca liczbę wypisanych znaków (bez NUL),
- * obcina, jeżeli nie mieścimy się w buforze.
+ * ksnprintf(buf, sz, fmt, ...) zwraca liczbę znaków, jaką dałby pełny
+ * wynik (bez NUL), obcina, jeżeli nie mieścimy się w buforze.
  */
 int kvsnprintf(char *dst, int dstsz, const char *fmt, va_list ap);
 int ksnprintf(char *dst, int dstsz, const char *fmt, ...);
@@ -33,6 +33,24 @@ char *strcpy(char *__restrict dst, const char *__restrict src);
 char *strncpy(char *__restrict dst, const char *__restrict src, size_t n);
 int strcmp(const char *a, const char *b);
 int strncmp(const char *a, const char *b, size_t n); /* <-- ważne */
+/* jak strncmp, ale bez rozróżniania wielkości liter ASCII (nazwy FAT) */
+int strncasecmp(const char *a, const char *b, size_t n);
 char *strcat(char *__restrict dst, const char *__restrict src);
+char *strchr(const char *s, int c);
+char *strrchr(const char *s, int c);
+
+/* memcpy/memset: małe rozmiary pętlą, średnie rep movsd/stosd, duże SSE2,
+ * jeśli CPU je ma (wybór w string_init, po fpu_init). W obsłudze przerwań
+ * SSE2 nie jest używane. */
+typedef struct {
+    const char *name;
+    void *(*cpy)(void *dst, const void *src, size_t n);
+    void *(*set)(void *dst, int c, size_t n);
+} mem_impl_t;
+
+void string_init(void);
+const char *string_impl_name(void);
+/* Wszystkie dostępne implementacje (dla bench); zwraca ich liczbę. */
+unsigned string_impls(const mem_impl_t **out);
 
 #endif /* CYGNUS_STRING_H */
\ No newline at end of file
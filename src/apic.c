@@ -0,0 +1,213 @@
+/*
+ * [Cygnus] - [src/apic.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "apic.h"
+#include "cpu.h"
+#include "idt.h"
+#include "paging.h"
+#include <string.h>
+
+#define CPUID_EDX_APIC (1u << 9)
+#define MSR_APIC_BASE 0x1B
+#define APIC_BASE_ENABLE (1u << 11)
+
+/* rejestry LAPIC (przesunięcia bajtowe) */
+#define LAPIC_ID 0x20
+#define LAPIC_TPR 0x80
+#define LAPIC_SVR 0xF0
+#define LAPIC_SVR_ENABLE (1u << 8)
+
+/* IOAPIC: okno rejestrów */
+#define IOAPIC_REGSEL 0x00
+#define IOAPIC_WIN 0x10
+#define IOAPIC_ID 0x00
+#define IOAPIC_VER 0x01
+#define IOAPIC_RTE(n) (0x10 + 2 * (n))
+
+#define RTE_POLARITY_LOW (1u << 13)
+#define RTE_TRIGGER_LEVEL (1u << 15)
+#define RTE_MASKED (1u << 16)
+
+/* MADT */
+#define MADT_IOAPIC 1
+#define MADT_ISO 2
+#define MPS_POLARITY_LOW 3   /* bity 0-1 flag */
+#define MPS_TRIGGER_LEVEL 3  /* bity 2-3 flag */
+
+#define ISA_IRQS 16
+
+typedef struct __attribute__((packed)) {
+  char sig[4];
+  uint32_t len;
+  uint8_t rev, checksum;
+  char oem[6], oem_table[8];
+  uint32_t oem_rev, creator, creator_rev;
+} acpi_hdr_t;
+
+volatile uint32_t *g_lapic;
+static volatile uint32_t *g_ioapic;
+static apic_info_t g_info;
+
+/* ISA IRQ → GSI i flagi RTE (polaryzacja/wyzwalanie) */
+static uint32_t g_isa_gsi[ISA_IRQS];
+static uint32_t g_isa_flags[ISA_IRQS];
+
+/* ===== ACPI ===== */
+
+static bool checksum_ok(const void *p, uint32_t len) {
+  const uint8_t *b = p;
+  uint8_t sum = 0;
+  for (uint32_t i = 0; i < len; i++) sum += b[i];
+  return sum == 0;
+}
+
+/* Tabele ACPI leżą zwykle w RAM oznaczonym jako zarezerwowany, poza
+ * mapą bezpośrednią – mapujemy brakujące strony 1:1, tylko do odczytu. */
+static void map_phys(uint32_t phys, uint32_t len) {
+  for (uint32_t p = phys & ~0xFFFu; p - (phys & ~0xFFFu) < len + (phys & 0xFFFu); p += 4096)
+    if (!paging_virt_to_phys(p)) paging_map_page(p, p, PG_PRESENT);
+}
+
+static const uint8_t *find_rsdp_in(uint32_t start, uint32_t len) {
+  for (uint32_t a = start; a + 20 <= start + len; a += 16) {
+    const uint8_t *p = (const uint8_t *)a;
+    if (!memcmp(p, "RSD PTR ", 8) && checksum_ok(p, 20)) return p;
+  }
+  return NULL;
+}
+
+static const acpi_hdr_t *find_madt(void) {
+  /* segment EBDA z BDA; wskaźnik volatile, bo stały adres < 4 KiB GCC
+   * bierze za NULL + przesunięcie */
+  static const uint16_t *volatile bda_ebda = (const uint16_t *)0x40E;
+  uint32_t ebda = (uint32_t)*bda_ebda << 4;
+  const uint8_t *rsdp = ebda ? find_rsdp_in(ebda, 1024) : NULL;
+  if (!rsdp) rsdp = find_rsdp_in(0xE0000, 0x20000);
+  if (!rsdp) return NULL;
+
+  uint32_t rsdt_phys;
+  memcpy(&rsdt_phys, rsdp + 16, 4);
+  map_phys(rsdt_phys, sizeof(acpi_hdr_t));
+  const acpi_hdr_t *rsdt = (const acpi_hdr_t *)rsdt_phys;
+  if (memcmp(rsdt->sig, "RSDT", 4)) return NULL;
+  map_phys(rsdt_phys, rsdt->len);
+  if (!checksum_ok(rsdt, rsdt->len)) return NULL;
+
+  uint32_t n = (rsdt->len - sizeof(*rsdt)) / 4;
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t phys;
+    memcpy(&phys, (const uint8_t *)(rsdt + 1) + 4 * i, 4);
+    map_phys(phys, sizeof(acpi_hdr_t));
+    const acpi_hdr_t *t = (const acpi_hdr_t *)phys;
+    if (memcmp(t->sig, "APIC", 4)) continue;
+    map_phys(phys, t->len);
+    return checksum_ok(t, t->len) ? t : NULL;
+  }
+  return NULL;
+}
+
+static void parse_madt(const acpi_hdr_t *madt) {
+  const uint8_t *p = (const uint8_t *)madt + sizeof(*madt) + 8; /* adres LAPIC, flagi */
+  const uint8_t *end = (const uint8_t *)madt + madt->len;
+  for (; p + 2 <= end && p[1] >= 2; p += p[1]) {
+    if (p[0] == MADT_IOAPIC && !g_info.ioapic && p[1] >= 12) {
+      g_info.ioapic = true;
+      g_info.ioapic_id = p[2];
+      memcpy(&g_info.ioapic_phys, p + 4, 4);
+      memcpy(&g_info.gsi_base, p + 8, 4);
+    } else if (p[0] == MADT_ISO && p[1] >= 10 && p[2] == 0 && p[3] < ISA_IRQS) {
+      uint32_t gsi;
+      uint16_t fl;
+      memcpy(&gsi, p + 4, 4);
+      memcpy(&fl, p + 8, 2);
+      /* 00 = domyślne dla magistrali (ISA: zbocze, stan wysoki) */
+      uint32_t rte = 0;
+      if ((fl & 3) == MPS_POLARITY_LOW) rte |= RTE_POLARITY_LOW;
+      if (((fl >> 2) & 3) == MPS_TRIGGER_LEVEL) rte |= RTE_TRIGGER_LEVEL;
+      g_isa_gsi[p[3]] = gsi;
+      g_isa_flags[p[3]] = rte;
+      g_info.overrides++;
+    }
+  }
+}
+
+/* ===== IOAPIC ===== */
+
+static uint32_t ioapic_read(uint32_t reg) {
+  g_ioapic[IOAPIC_REGSEL / 4] = reg;
+  return g_ioapic[IOAPIC_WIN / 4];
+}
+
+static void ioapic_write(uint32_t reg, uint32_t v) {
+  g_ioapic[IOAPIC_REGSEL / 4] = reg;
+  g_ioapic[IOAPIC_WIN / 4] = v;
+}
+
+/* ===== API ===== */
+
+static void spurious_isr(isr_frame_t *f) {
+  (void)f;
+  g_info.spurious++; /* bez EOI */
+}
+
+bool apic_detect(void) {
+  uint32_t a, b, c, d;
+  cpuid(1, &a, &b, &c, &d);
+  if (!(d & CPUID_EDX_APIC)) return false;
+  g_info.lapic = true;
+  g_info.lapic_phys = (uint32_t)rdmsr(MSR_APIC_BASE) & ~0xFFFu;
+
+  for (unsigned i = 0; i < ISA_IRQS; i++) g_isa_gsi[i] = i;
+  const acpi_hdr_t *madt = find_madt();
+  if (!madt) return false;
+  parse_madt(madt);
+  if (!g_info.ioapic) return false;
+
+  uint32_t uc = PG_PRESENT | PG_RW | PG_PCD | PG_PWT;
+  paging_map_page(g_info.lapic_phys, g_info.lapic_phys, uc);
+  paging_map_page(g_info.ioapic_phys, g_info.ioapic_phys, uc);
+  g_lapic = (volatile uint32_t *)g_info.lapic_phys;
+  g_ioapic = (volatile uint32_t *)g_info.ioapic_phys;
+  g_info.ioapic_pins = ((ioapic_read(IOAPIC_VER) >> 16) & 0xFF) + 1;
+  return true;
+}
+
+void apic_enable(void) {
+  wrmsr(MSR_APIC_BASE, rdmsr(MSR_APIC_BASE) | APIC_BASE_ENABLE);
+  idt_set_handler(APIC_SPURIOUS_VEC, spurious_isr);
+  g_lapic[LAPIC_TPR / 4] = 0;
+  g_lapic[LAPIC_SVR / 4] = LAPIC_SVR_ENABLE | APIC_SPURIOUS_VEC;
+  g_info.lapic_id = (uint8_t)(g_lapic[LAPIC_ID / 4] >> 24);
+  for (uint32_t i = 0; i < g_info.ioapic_pins; i++) {
+    ioapic_write(IOAPIC_RTE(i) + 1, 0);
+    ioapic_write(IOAPIC_RTE(i), RTE_MASKED);
+  }
+}
+
+void apic_route(uint8_t irq, uint8_t vector, bool masked) {
+  if (irq >= ISA_IRQS) return;
+  uint32_t pin = g_isa_gsi[irq] - g_info.gsi_base;
+  if (pin >= g_info.ioapic_pins) return;
+  uint32_t lo = vector | g_isa_flags[irq] | (masked ? RTE_MASKED : 0);
+  ioapic_write(IOAPIC_RTE(pin) + 1, (uint32_t)g_info.lapic_id << 24);
+  ioapic_write(IOAPIC_RTE(pin), lo);
+}
+
+void apic_get_info(apic_info_t *out) { *out = g_info; }
@@ -0,0 +1,77 @@
+/*
+ * [Cygnus] - [src/apic.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_APIC_H
+#define CYGNUS_APIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Lokalny APIC i IOAPIC (xAPIC, MMIO).
+ *
+ * apic_detect szuka tabeli MADT (ACPI "APIC") przez RSDP/RSDT: z niej
+ * bierzemy adres pierwszego IOAPIC-a i nadpisania ISA (np. IRQ0 → GSI2,
+ * linie PCI wyzwalane poziomem). Bez CPUID.APIC albo bez MADT zostajemy
+ * przy 8259. Linie IRQ 0..15 trafiają do IOAPIC-a pod te same wektory
+ * co przy 8259 (IRQ_BASE + n), więc sterowniki nie widzą różnicy.
+ *
+ * Numer linii z PCI_INTERRUPT_LINE to numer IRQ w PIC-u; na i440fx/Q35
+ * w QEMU ten sam numer (z nadpisaniem z MADT) działa jako GSI IOAPIC-a.
+ */
+
+#define APIC_SPURIOUS_VEC 0xFF
+
+typedef struct {
+  bool lapic;             /* CPUID.1:EDX.APIC */
+  bool ioapic;            /* MADT z IOAPIC-iem */
+  uint32_t lapic_phys;
+  uint32_t ioapic_phys;
+  uint8_t lapic_id;
+  uint8_t ioapic_id;
+  uint32_t ioapic_pins;   /* wejścia (max redirection entry + 1) */
+  uint32_t gsi_base;
+  uint32_t overrides;     /* nadpisania ISA z MADT */
+  uint32_t spurious;      /* przerwania z wektora APIC_SPURIOUS_VEC */
+} apic_info_t;
+
+/* CPUID + ACPI; mapuje rejestry. true, gdy są i LAPIC, i IOAPIC.
+ * Po paging_enable. */
+bool apic_detect(void);
+
+/* Włącza LAPIC (TPR 0, wektor fałszywych przerwań) i maskuje wszystkie
+ * wejścia IOAPIC-a. */
+void apic_enable(void);
+
+/* Ustawia wejście IOAPIC-a dla linii ISA 'irq' (z nadpisaniami z MADT)
+ * na 'vector' do bieżącego CPU. */
+void apic_route(uint8_t irq, uint8_t vector, bool masked);
+
+void apic_get_info(apic_info_t *out);
+
+extern volatile uint32_t *g_lapic;
+
+#define LAPIC_EOI 0xB0
+
+/* Koniec obsługi przerwania – jeden zapis MMIO zamiast dwóch outb. */
+static inline void apic_eoi(void) {
+  g_lapic[LAPIC_EOI / 4] = 0;
+}
+
+#endif /* CYGNUS_APIC_H */
@@ -0,0 +1,717 @@
+/*
+ * [Cygnus] - [src/bench.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "bench.h"
+#include "checksum.h"
+#include "cpu.h"
+#include "debugcon.h"
+#include "fbcon.h"
+#include "fat32_aio.h"
+#include "kmalloc.h"
+#include "ktime.h"
+#include "pagecache.h"
+#include "paging.h"
+#include "vcon.h"
+#include "../inc/serial.h"
+#include "../inc/std.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+#define BENCH_MAX_ARGS 8
+
+/* wspólny bufor odczytu dla pomiarów plikowych */
+static uint8_t g_bench_buf[64 * 1024];
+
+uint64_t bench_now(void) { return rdtsc(); }
+
+uint64_t bench_ns(uint64_t ticks) { return ktime_cycles_to_ns(ticks); }
+
+/* MB/s (10^6 B) z dwoma miejscami po przecinku, jako setne części */
+static uint32_t rate_mbs100(uint64_t bytes, uint64_t ns) {
+    return (uint32_t)(bytes * 100000 / (ns ? ns : 1));
+}
+
+void bench_report(const char *label, uint64_t bytes, uint64_t ticks) {
+    uint64_t ns = bench_ns(ticks);
+    uint32_t r = rate_mbs100(bytes, ns);
+    kprintf("%s: %u B w %llu us, %u.%02u MB/s\n", label, (unsigned)bytes, ns / 1000,
+            r / 100, r % 100);
+}
+
+int bench_read_file(fat32_volume_t *vol, const char *path, uint32_t flags,
+                      uint64_t *bytes, uint64_t *ticks) {
+    fat32_file_t *f = NULL;
+    pcache_drop_all();
+    int rc = fat32_open_ex(vol, path, flags, &f);
+    if (rc) {
+        kprintf("[ERR] bench: nie otworzyliśmy %s (kod=%d)\n", path, rc);
+        return rc;
+    }
+    uint64_t total = 0, t0 = bench_now();
+    for (;;) {
+        uint32_t got = 0;
+        rc = fat32_read(f, g_bench_buf, sizeof(g_bench_buf), &got);
+        total += got;
+        if (rc || got == 0) break;
+    }
+    *ticks = bench_now() - t0;
+    *bytes = total;
+    fat32_close(f);
+    if (rc) kprintf("[ERR] bench: odczyt %s (kod=%d)\n", path, rc);
+    return rc;
+}
+
+/* bench lz4 PLIK.LZ4 PLIK – efektywna przepustowość dekompresji w locie
+ * względem czytania tego samego pliku bez kompresji */
+static int bench_lz4(fat32_volume_t *vol, int argc, char **argv) {
+    if (argc < 3) {
+        kprintf("Użycie: bench lz4 /PLIK.LZ4 /PLIK\n");
+        return -1;
+    }
+    uint64_t zb, zt, pb, pt;
+    if (bench_read_file(vol, argv[1], FAT32_OPEN_LZ4, &zb, &zt)) return -1;
+    if (bench_read_file(vol, argv[2], 0, &pb, &pt)) return -1;
+    bench_report("lz4 (po dekompresji)", zb, zt);
+    bench_report("bez kompresji", pb, pt);
+    if (zb != pb) kprintf("[WARN] rozmiary się różnią: %u vs %u\n",
+                          (unsigned)zb, (unsigned)pb);
+    uint64_t x100 = zt ? pt * 100 / zt : 0;
+    kprintf("przyspieszenie: %u.%u%ux\n", (unsigned)(x100 / 100),
+            (unsigned)(x100 / 10 % 10), (unsigned)(x100 % 10));
+    return 0;
+}
+
+/* Strumień jednego pliku w bench aio: callback liczy CRC32 gotowego
+ * kawałka i od razu zleca następny. */
+#define AIO_FILES 4
+#define AIO_CHUNK (sizeof(g_bench_buf) / AIO_FILES)
+
+typedef struct {
+    fat32_file_t *f;
+    uint8_t *buf;
+    uint32_t off;
+    uint32_t crc;
+    int status;
+    bool done;
+} aio_stream_t;
+
+static void aio_chunk_done(void *ctx, int status, uint32_t nread) {
+    aio_stream_t *s = (aio_stream_t *)ctx;
+    s->crc = crc32_update(s->crc, s->buf, nread);
+    s->off += nread;
+    if (status || nread < AIO_CHUNK) {
+        s->status = status;
+        s->done = true;
+        return;
+    }
+    int id = fat32_read_async(s->f, s->buf, AIO_CHUNK, s->off, aio_chunk_done, s);
+    if (id < 0) { s->status = id; s->done = true; }
+}
+
+/* Czyta pliki po kolei (fat32_read + crc32) albo wszystkie naraz przez
+ * fat32_read_async; 'crc' dostaje sumy do porównania. */
+static int aio_pass(fat32_volume_t *vol, int n, char **paths, bool async,
+                    uint32_t *crc, uint64_t *bytes, uint64_t *ticks) {
+    static aio_stream_t st[AIO_FILES];
+    int rc = 0;
+
+    pcache_drop_all();
+    *bytes = 0;
+    uint64_t t0 = bench_now();
+    for (int i = 0; i < n; i++) {
+        st[i] = (aio_stream_t){0};
+        st[i].buf = g_bench_buf + i * AIO_CHUNK;
+        rc = fat32_open(vol, paths[i], &st[i].f);
+        if (rc) {
+            kprintf("[ERR] bench: nie otworzyliśmy %s (kod=%d)\n", paths[i], rc);
+            n = i;
+            break;
+        }
+        if (async) {
+            int id = fat32_read_async(st[i].f, st[i].buf, AIO_CHUNK, 0,
+                                      aio_chunk_done, &st[i]);
+            if (id < 0) { st[i].status = id; st[i].done = true; }
+            continue;
+        }
+        for (;;) {
+            uint32_t got = 0;
+            st[i].status = fat32_read(st[i].f, st[i].buf, AIO_CHUNK, &got);
+            st[i].crc = crc32_update(st[i].crc, st[i].buf, got);
+            st[i].off += got;
+            if (st[i].status || got < AIO_CHUNK) break;
+        }
+    }
+    while (fat32_aio_poll(16)) { }
+    *ticks = bench_now() - t0;
+
+    for (int i = 0; i < n; i++) {
+        if (st[i].status) {
+            kprintf("[ERR] bench: odczyt %s (kod=%d)\n", paths[i], st[i].status);
+            rc = st[i].status;
+        }
+        crc[i] = st[i].crc;
+        *bytes += st[i].off;
+        fat32_close(st[i].f);
+    }
+    return rc;
+}
+
+/* bench aio PLIK... – do 4 plików naraz przez kolejkę odczytów
+ * asynchronicznych vs po kolei, z CRC32 liczonym w trakcie */
+static int bench_aio(fat32_volume_t *vol, int argc, char **argv) {
+    if (argc < 2 || argc > AIO_FILES + 1) {
+        kprintf("Użycie: bench aio /PLIK [/PLIK2 ... do %u]\n", AIO_FILES);
+        return -1;
+    }
+    uint32_t c_sync[AIO_FILES], c_async[AIO_FILES];
+    uint64_t sb, st, ab, at;
+    if (aio_pass(vol, argc - 1, argv + 1, false, c_sync, &sb, &st)) return -1;
+    if (aio_pass(vol, argc - 1, argv + 1, true, c_async, &ab, &at)) return -1;
+    bench_report("po kolei", sb, st);
+    bench_report("asynchronicznie", ab, at);
+    for (int i = 0; i < argc - 1; i++)
+        if (c_sync[i] != c_async[i])
+            kprintf("[WARN] %s: różne CRC32 (%x vs %x)\n", argv[i + 1],
+                    c_sync[i], c_async[i]);
+    return 0;
+}
+
+/* ===== bench pmm ===== */
+
+#define PMM_HELD 2048   /* ramki trzymane, co druga zwolniona = dziury */
+#define PMM_ROUNDS 1000
+#define FF_FRAMES 8192  /* bitmapa porównawcza: 32 MiB */
+
+static uintptr_t g_held[PMM_HELD];
+static uint32_t g_ff_map[FF_FRAMES / 32];
+
+/* Dawny sposób: przeszukiwanie bitmapy bit po bicie od początku w poszukiwaniu
+ * 'n' wolnych ramek pod rząd. */
+static int ff_alloc(uint32_t n) {
+    uint32_t run = 0;
+    for (uint32_t i = 0; i < FF_FRAMES; i++) {
+        if (g_ff_map[i >> 5] & (1u << (i & 31))) { run = 0; continue; }
+        if (++run == n) {
+            for (uint32_t j = i + 1 - n; j <= i; j++) g_ff_map[j >> 5] |= 1u << (j & 31);
+            return (int)(i + 1 - n);
+        }
+    }
+    return -1;
+}
+
+static void ff_free(int f, uint32_t n) {
+    for (uint32_t j = (uint32_t)f; j < (uint32_t)f + n; j++)
+        g_ff_map[j >> 5] &= ~(1u << (j & 31));
+}
+
+static uint64_t ff_round(unsigned order) {
+    uint64_t t0 = bench_now();
+    for (int r = 0; r < PMM_ROUNDS; r++) {
+        int f = ff_alloc(1u << order);
+        if (f >= 0) ff_free(f, 1u << order);
+    }
+    return (bench_now() - t0) / PMM_ROUNDS;
+}
+
+static uint64_t buddy_round(unsigned order, uint32_t *fails) {
+    uint64_t t0 = bench_now();
+    for (int r = 0; r < PMM_ROUNDS; r++) {
+        uintptr_t p = pmm_alloc_pages(order);
+        if (p) pmm_free_pages(p, order); else (*fails)++;
+    }
+    return (bench_now() - t0) / PMM_ROUNDS;
+}
+
+/* bench pmm – para alloc+free ramek przy pofragmentowanej pamięci:
+ * buddy vs first-fit po bitmapie (ta sama dziurawa struktura: połowa
+ * pamięci zajęta, potem pas co drugiej ramki) */
+static int bench_pmm(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+
+    uint32_t held = 0, fails = 0;
+    while (held < PMM_HELD && (g_held[held] = pmm_alloc_frame())) held++;
+    for (uint32_t i = 0; i < held; i += 2) pmm_free_frame(g_held[i]);
+
+    for (uint32_t i = 0; i < FF_FRAMES; i++) {
+        bool used = i < FF_FRAMES / 2 ||
+                    (i < FF_FRAMES / 2 + PMM_HELD && (i & 1));
+        if (used) g_ff_map[i >> 5] |= 1u << (i & 31);
+        else g_ff_map[i >> 5] &= ~(1u << (i & 31));
+    }
+
+    static const unsigned orders[] = {0, 3, 6};
+    for (unsigned i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        unsigned o = orders[i];
+        kprintf("rząd %u (%u ramek): buddy %u ns, bitmapa %u ns na alloc+free\n",
+                o, 1u << o, (unsigned)bench_ns(buddy_round(o, &fails)),
+                (unsigned)bench_ns(ff_round(o)));
+    }
+    if (fails) kprintf("[WARN] %u nieudanych alokacji\n", fails);
+
+    for (uint32_t i = 1; i < held; i += 2) pmm_free_frame(g_held[i]);
+
+    pmm_stats_t st;
+    pmm_get_stats(&st);
+    kprintf("wolne ramki: %u / %u\n", st.free_frames, st.total_frames);
+    return 0;
+}
+
+/* ===== bench heap ===== */
+
+#define HEAP_SLOTS 512
+#define HEAP_OPS 20000
+#define FF_ARENA (256 * 1024)
+
+/* Naiwna sterta first-fit do porównania (tak działała dawna arena FAT32):
+ * bloki z nagłówkiem jeden za drugim, wolne sklejane przy przeszukiwaniu. */
+typedef struct {
+    uint32_t size; /* razem z nagłówkiem */
+    uint32_t used;
+    uint32_t pad[2];
+} ff_blk_t;
+
+static uint8_t g_ff_arena[FF_ARENA] __attribute__((aligned(16)));
+#define FF_AT(off) ((ff_blk_t *)(g_ff_arena + (off)))
+
+static void ff_heap_reset(void) {
+    FF_AT(0)->size = FF_ARENA;
+    FF_AT(0)->used = 0;
+}
+
+static void *ff_heap_alloc(uint32_t n) {
+    uint32_t need = ((n + 15u) & ~15u) + sizeof(ff_blk_t);
+    for (uint32_t off = 0; off < FF_ARENA; off += FF_AT(off)->size) {
+        ff_blk_t *b = FF_AT(off);
+        if (b->used) continue;
+        while (off + b->size < FF_ARENA && !FF_AT(off + b->size)->used)
+            b->size += FF_AT(off + b->size)->size;
+        if (b->size < need) continue;
+        if (b->size - need >= 2 * sizeof(ff_blk_t)) {
+            FF_AT(off + need)->size = b->size - need;
+            FF_AT(off + need)->used = 0;
+            b->size = need;
+        }
+        b->used = 1;
+        return b + 1;
+    }
+    return NULL;
+}
+
+static void ff_heap_free(void *p) {
+    if (p) ((ff_blk_t *)p - 1)->used = 0;
+}
+
+/* Ten sam pseudolosowy ciąg operacji dla obu stert: rozmiary 16..512 B,
+ * w tablicy do HEAP_SLOTS żywych obiektów (fragmentacja po chwili). */
+static uint64_t heap_run(bool slab, uint32_t *fails) {
+    static void *slots[HEAP_SLOTS];
+    uint32_t seed = 12345;
+    memset(slots, 0, sizeof(slots));
+    if (!slab) ff_heap_reset();
+
+    uint64_t t0 = bench_now();
+    for (int i = 0; i < HEAP_OPS; i++) {
+        seed = seed * 1103515245u + 12345u;
+        uint32_t k = (seed >> 8) % HEAP_SLOTS;
+        if (slots[k]) {
+            if (slab) kfree(slots[k]); else ff_heap_free(slots[k]);
+            slots[k] = NULL;
+        } else {
+            uint32_t n = 16u << ((seed >> 20) % 6);
+            slots[k] = slab ? kmalloc(n) : ff_heap_alloc(n);
+            if (!slots[k]) (*fails)++;
+        }
+    }
+    uint64_t t = bench_now() - t0;
+    for (int k = 0; k < HEAP_SLOTS; k++)
+        if (slots[k]) { if (slab) kfree(slots[k]); else ff_heap_free(slots[k]); }
+    return t;
+}
+
+/* bench heap – kmalloc/kfree (slaby) vs naiwny first-fit */
+static int bench_heap(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+    uint32_t fs = 0, ff = 0;
+    uint64_t ts = heap_run(true, &fs);
+    uint64_t tf = heap_run(false, &ff);
+    kprintf("slaby:     %u ns/op\n", (unsigned)(bench_ns(ts) / HEAP_OPS));
+    kprintf("first-fit: %u ns/op\n", (unsigned)(bench_ns(tf) / HEAP_OPS));
+    if (fs || ff) kprintf("[WARN] nieudane alokacje: slaby %u, first-fit %u\n", fs, ff);
+    return 0;
+}
+
+/* ===== bench mem ===== */
+
+#define MEMB_ORDER 8              /* bufory po 1 MiB z buddy */
+#define MEMB_BYTES (4u << 20)     /* tyle bajtów na jeden pomiar */
+
+/* przepustowość jednej implementacji dla rozmiaru 'n' (MB/s) */
+static uint32_t memb_rate(const mem_impl_t *im, bool copy, uint8_t *dst,
+                          const uint8_t *src, uint32_t n) {
+    uint32_t reps = MEMB_BYTES / n;
+    uint64_t t0 = bench_now();
+    for (uint32_t r = 0; r < reps; r++) {
+        if (copy) im->cpy(dst, src, n);
+        else im->set(dst, (int)r, n);
+    }
+    uint64_t ns = bench_ns(bench_now() - t0);
+    return (uint32_t)((uint64_t)reps * n * 1000 / (ns ? ns : 1));
+}
+
+/* bench mem – memcpy/memset: pętla bajtowa vs rep movsd/stosd vs SSE2 */
+static int bench_mem(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+    uint8_t *src = (uint8_t *)pmm_alloc_pages(MEMB_ORDER);
+    uint8_t *dst = (uint8_t *)pmm_alloc_pages(MEMB_ORDER);
+    if (!src || !dst) {
+        kprintf("[ERR] bench mem: brak 2 MiB ciągłej pamięci\n");
+        if (src) pmm_free_pages((uintptr_t)src, MEMB_ORDER);
+        if (dst) pmm_free_pages((uintptr_t)dst, MEMB_ORDER);
+        return -1;
+    }
+    memset(src, 0x5A, PAGE_SIZE << MEMB_ORDER);
+
+    const mem_impl_t *im;
+    unsigned n_im = string_impls(&im);
+    static const uint32_t sizes[] = {64, 512, 4096, 65536, 1u << 20};
+    kprintf("aktywne: %s; MB/s dla:", string_impl_name());
+    for (unsigned i = 0; i < n_im; i++) kprintf(" %s |", im[i].name);
+    kprintf("\n");
+    for (int copy = 1; copy >= 0; copy--) {
+        for (unsigned k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+            kprintf("%s %u B:", copy ? "memcpy" : "memset", sizes[k]);
+            for (unsigned i = 0; i < n_im; i++)
+                kprintf(" %u", memb_rate(&im[i], copy, dst, src, sizes[k]));
+            kprintf("\n");
+        }
+    }
+    pmm_free_pages((uintptr_t)src, MEMB_ORDER);
+    pmm_free_pages((uintptr_t)dst, MEMB_ORDER);
+    return 0;
+}
+
+/* ===== bench str ===== */
+
+#define STRB_ROUNDS 20000
+
+/* Dawne wersje bajt po bajcie – punkt odniesienia. */
+static size_t strb_len(const char *s) {
+    const char *p = s; while (*p) ++p; return (size_t)(p - s);
+}
+static int strb_cmp(const char *a, const char *b) {
+    while (*a && *b && *a == *b) { ++a; ++b; }
+    return (int)((unsigned char)*a) - (int)((unsigned char)*b);
+}
+static const char *strb_chr(const char *s, int c) {
+    while (*s) { if (*s == (char)c) return s; ++s; }
+    return (c == 0) ? s : NULL;
+}
+/* dawny match_cb: kopie obu nazw, zamiana na wielkie, strncmp */
+static int strb_fat_match(const char *name, const char *tgt_in, size_t len) {
+    char a[256], t[256];
+    strncpy(a, name, sizeof(a));
+    for (char *p = a; *p; ++p) if (*p >= 'a' && *p <= 'z') *p -= 32;
+    memset(t, 0, sizeof(t));
+    strncpy(t, tgt_in, len < sizeof(t) - 1 ? len : sizeof(t) - 1);
+    for (char *p = t; *p; ++p) if (*p >= 'a' && *p <= 'z') *p -= 32;
+    return strncmp(a, t, 255);
+}
+
+static volatile uintptr_t g_strb_sink; /* żeby pętle nie zniknęły */
+
+/* dziesiąte części ns → "całe, dziesiąte" dla %u.%u */
+#define STRB_NS(v) (unsigned)((v) / 10), (unsigned)((v) % 10)
+
+#define STRB_TIME(var, expr) do { \
+        uint64_t t0_ = bench_now(); \
+        for (int r_ = 0; r_ < STRB_ROUNDS; r_++) g_strb_sink += (uintptr_t)(expr); \
+        var = bench_ns(bench_now() - t0_) * 10 / STRB_ROUNDS; \
+    } while (0)
+
+/* bench str – strlen/strcmp/strchr i porównanie nazw FAT: słowo naraz vs
+ * bajt po bajcie (ns na wywołanie, z dziesiątymi) */
+static int bench_str(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+    static char a[256], b[256];
+    static const uint32_t lens[] = {8, 32, 128, 255};
+    for (unsigned k = 0; k < sizeof(lens) / sizeof(lens[0]); k++) {
+        uint32_t n = lens[k];
+        for (uint32_t i = 0; i < n; i++) a[i] = b[i] = (char)('a' + i % 26);
+        a[n] = b[n] = 0;
+        uint64_t sw, by;
+        kprintf("długość %u:\n", n);
+        STRB_TIME(sw, strlen(a));
+        STRB_TIME(by, strb_len(a));
+        kprintf("  strlen   %u.%u vs %u.%u ns\n", STRB_NS(sw), STRB_NS(by));
+        STRB_TIME(sw, strcmp(a, b));
+        STRB_TIME(by, strb_cmp(a, b));
+        kprintf("  strcmp   %u.%u vs %u.%u\n", STRB_NS(sw), STRB_NS(by));
+        STRB_TIME(sw, strchr(a, '#'));
+        STRB_TIME(by, strb_chr(a, '#'));
+        kprintf("  strchr   %u.%u vs %u.%u\n", STRB_NS(sw), STRB_NS(by));
+        /* nazwa z katalogu vs komponent ścieżki wpisany wielkimi literami */
+        for (uint32_t i = 0; i < n; i++) b[i] = (char)('A' + i % 26);
+        STRB_TIME(sw, strncasecmp(a, b, n) == 0 && a[n] == 0);
+        STRB_TIME(by, strb_fat_match(a, b, n));
+        kprintf("  nazwa FAT %u.%u vs %u.%u\n", STRB_NS(sw), STRB_NS(by));
+    }
+    return 0;
+}
+
+/* ===== bench vmap ===== */
+
+#define VMAP_VA 0xD0000000u   /* poza mapą bezpośrednią RAM */
+#define VMAP_SIZE (64u << 20)
+#define VMAP_ROUNDS 4
+
+/* Mapuje i zdejmuje VMAP_SIZE stronami 4 KiB. Fizycznie to dowolne adresy
+ * przesunięte o 4 KiB (żeby nie weszły strony 4 MiB) – nic pod nie nie
+ * piszemy. 'batched' = paging_*_range z jednym flushem na koniec, inaczej
+ * strona po stronie z invlpg przy każdej. */
+static void vmap_round(bool batched, uint64_t *t_map, uint64_t *t_unmap) {
+    uint64_t t0 = bench_now();
+    if (batched) {
+        paging_map_range(PAGE_SIZE, VMAP_VA, VMAP_SIZE, PG_RW);
+    } else {
+        for (uint32_t off = 0; off < VMAP_SIZE; off += PAGE_SIZE)
+            paging_map_page(PAGE_SIZE + off, VMAP_VA + off, PG_RW);
+    }
+    uint64_t t1 = bench_now();
+    if (batched) {
+        paging_unmap_range(VMAP_VA, VMAP_SIZE, false);
+    } else {
+        for (uint32_t off = 0; off < VMAP_SIZE; off += PAGE_SIZE)
+            paging_unmap_page(VMAP_VA + off, false);
+    }
+    *t_map += t1 - t0;
+    *t_unmap += bench_now() - t1;
+}
+
+/* bench vmap – map+unmap 64 MiB: strona po stronie vs zbiorczy flush TLB */
+static int bench_vmap(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+    if (paging_virt_to_phys(VMAP_VA) ||
+        paging_virt_to_phys(VMAP_VA + VMAP_SIZE - PAGE_SIZE)) {
+        kprintf("[ERR] bench vmap: okno 0x%x jest już zmapowane\n", VMAP_VA);
+        return -1;
+    }
+    uint64_t m = 0, u = 0;
+    vmap_round(true, &m, &u); /* rozgrzewka: tablice stron */
+
+    paging_stats_t s0, s1;
+    for (int batched = 0; batched < 2; batched++) {
+        m = u = 0;
+        paging_get_stats(&s0);
+        for (int r = 0; r < VMAP_ROUNDS; r++) vmap_round(batched, &m, &u);
+        paging_get_stats(&s1);
+        kprintf("%s: map %u us, unmap %u us (invlpg %u, pełne flushe %u)\n",
+                batched ? "zbiorczo  " : "po stronie",
+                (unsigned)(bench_ns(m) / VMAP_ROUNDS / 1000),
+                (unsigned)(bench_ns(u) / VMAP_ROUNDS / 1000),
+                (s1.tlb_invlpg - s0.tlb_invlpg) / VMAP_ROUNDS,
+                (s1.tlb_full_flushes - s0.tlb_full_flushes) / VMAP_ROUNDS);
+    }
+    return 0;
+}
+
+/* ===== bench ls ===== */
+
+/* Dawna ścieżka wyjścia kprintf – bufor 512 B na stosie, potem
+ * serial_write_char na każdy bajt (punkt odniesienia). */
+static void lsb_old_printf(const char *fmt, ...) {
+    char buf[512];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kvsnprintf(buf, (int)sizeof(buf), fmt, ap);
+    va_end(ap);
+    for (int i = 0; i < n && buf[i]; ++i) serial_write_char(buf[i]);
+}
+
+/* Jedno `ls` katalogu; liczymy tylko czas wypisywania, bez readdir. */
+static int ls_pass(fat32_volume_t *vol, uint32_t cluster, bool old,
+                   uint32_t *lines, uint64_t *ticks) {
+    fat32_file_t *it = NULL;
+    int rc = fat32_readdir_first(vol, cluster, &it);
+    if (rc) return rc;
+    *lines = 0;
+    *ticks = 0;
+    for (;;) {
+        fat32_dirent_info_t inf;
+        rc = fat32_readdir_next(it, &inf);
+        if (rc) break;
+        uint64_t t0 = bench_now();
+        if (old) {
+            lsb_old_printf("%c ", inf.is_dir ? 'd' : '-');
+            lsb_old_printf("%d  ", (int)inf.size);
+            lsb_old_printf("%s\n", inf.name);
+        } else {
+            kprintf("%c %10u  %s\n", inf.is_dir ? 'd' : '-', (unsigned)inf.size, inf.name);
+        }
+        *ticks += bench_now() - t0;
+        (*lines)++;
+    }
+    fat32_readdir_close(it);
+    return rc == 1 ? 0 : rc;
+}
+
+/* bench ls /KATALOG – linie na ms przy wypisywaniu dużego katalogu:
+ * kprintf porcjami przez ujścia vs dawne znak po znaku */
+static int bench_ls(fat32_volume_t *vol, int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : "/";
+    fat32_file_t *d = NULL;
+    int rc = fat32_open(vol, path, &d);
+    if (rc || !d->is_dir) {
+        kprintf("[ERR] bench ls: %s to nie katalog (kod=%d)\n", path, rc);
+        if (!rc) fat32_close(d);
+        return rc ? rc : -1;
+    }
+    uint32_t cluster = d->start_cluster;
+    fat32_close(d);
+
+    uint32_t lines[2];
+    uint64_t ticks[2];
+    for (int old = 1; old >= 0; old--) {
+        rc = ls_pass(vol, cluster, old, &lines[old], &ticks[old]);
+        if (rc) { kprintf("[ERR] bench ls: readdir kod=%d\n", rc); return rc; }
+    }
+    for (int old = 1; old >= 0; old--) {
+        uint64_t ns = bench_ns(ticks[old]);
+        kprintf("%s: %u linii w %llu us, %llu linii/ms\n",
+                old ? "znak po znaku" : "porcjami     ", lines[old],
+                ns / 1000, (uint64_t)lines[old] * 1000000 / (ns ? ns : 1));
+    }
+    return 0;
+}
+
+/* ===== bench con ===== */
+
+#define CONB_LINES 200
+
+/* Linie na ms dla jednej konsoli, łącznie z dociągnięciem zaległego
+ * wyjścia (UART – opróżnienie pierścienia, fb – przerysowanie). */
+static void con_round(const char *label, ksink_t *sink, void (*flush)(void)) {
+    uint64_t t0 = bench_now();
+    for (uint32_t i = 0; i < CONB_LINES; i++)
+        kfprintf(sink, "bench con %3u: The quick brown fox jumps over the lazy dog\n", i);
+    if (flush) flush();
+    uint64_t ns = bench_ns(bench_now() - t0);
+    kprintf("%-8s %u linii w %llu us, %llu linii/ms\n", label, CONB_LINES,
+            ns / 1000, (uint64_t)CONB_LINES * 1000000 / (ns ? ns : 1));
+}
+
+/* bench con – przepustowość konsol: COM1 vs framebuffer vs debugcon */
+static int bench_con(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol; (void)argc; (void)argv;
+    con_round("serial", &g_ksink_serial, serial_flush);
+    if (fbcon_present()) {
+        fbcon_stats_t f0, f1;
+        fbcon_get_stats(&f0);
+        con_round("fb", &g_ksink_fbcon, fbcon_flush);
+        fbcon_get_stats(&f1);
+        kprintf("         przerysowań %u, komórek %u, przewinięć %u\n",
+                f1.flushes - f0.flushes, f1.glyphs - f0.glyphs, f1.scrolls - f0.scrolls);
+    } else {
+        kprintf("fb       brak\n");
+    }
+    if (debugcon_present()) con_round("e9", &g_ksink_debugcon, NULL);
+    else kprintf("e9       brak\n");
+    return 0;
+}
+
+/* ===== bench vcon ===== */
+
+#define VCONB_BYTES (8u << 20)
+#define VCONB_SERIAL (64u << 10)
+
+/* bench vcon [PORT] – hurtowe wyjście: virtio-console vs COM1 */
+static int bench_vcon(fat32_volume_t *vol, int argc, char **argv) {
+    (void)vol;
+    int port = argc > 1 ? argv[1][0] - '0' : 0;
+    vcon_port_info_t p0, p1;
+    if (!vcon_port_info(port, &p0) || !p0.present) {
+        kprintf("[ERR] bench vcon: brak portu %d virtio-console\n", port);
+        return -1;
+    }
+    for (uint32_t i = 0; i < sizeof(g_bench_buf); i++)
+        g_bench_buf[i] = (uint8_t)(i % 64 == 63 ? '\n' : 'A' + i % 26);
+
+    uint64_t t0 = bench_now();
+    for (uint32_t done = 0; done < VCONB_BYTES; done += sizeof(g_bench_buf))
+        vcon_write(port, g_bench_buf, sizeof(g_bench_buf));
+    vcon_flush(port);
+    uint64_t tv = bench_now() - t0;
+    vcon_port_info(port, &p1);
+
+    t0 = bench_now();
+    serial_write_n((const char *)g_bench_buf, VCONB_SERIAL);
+    serial_flush();
+    uint64_t ts = bench_now() - t0;
+
+    serial_write("\r\n");
+    bench_report("virtio-console", VCONB_BYTES, tv);
+    kprintf("  buforów %u, powiadomień %u\n", p1.tx_bufs - p0.tx_bufs, p1.kicks - p0.kicks);
+    bench_report("COM1", VCONB_SERIAL, ts);
+    return 0;
+}
+
+static const struct {
+    const char *name;
+    int (*fn)(fat32_volume_t *vol, int argc, char **argv);
+    const char *help;
+} g_benches[] = {
+    {"lz4", bench_lz4, "lz4 /PLIK.LZ4 /PLIK  - dekompresja w locie vs zwykły odczyt"},
+    {"pmm", bench_pmm, "pmm                  - alloc/free ramek: buddy vs bitmapa"},
+    {"heap", bench_heap, "heap                 - kmalloc/kfree vs naiwny first-fit"},
+    {"mem", bench_mem, "mem                  - memcpy/memset: bajty vs rep movsd vs SSE2, 64 B..1 MiB"},
+    {"str", bench_str, "str                  - strlen/strcmp/strchr/nazwy FAT: słowo naraz vs bajty"},
+    {"con", bench_con, "con                  - linie/ms: COM1 vs framebuffer vs debugcon 0xE9"},
+    {"vcon", bench_vcon, "vcon [PORT]          - hurtowe wyjście: virtio-console vs COM1"},
+    {"ls", bench_ls, "ls [/KATALOG]        - wypis katalogu: kprintf porcjami vs znak po znaku"},
+    {"vmap", bench_vmap, "vmap                 - map/unmap 64 MiB: invlpg na stronę vs zbiorczy flush"},
+    {"aio", bench_aio, "aio /PLIK [...]      - kilka plików naraz przez fat32_read_async"},
+};
+
+void bench_run(fat32_volume_t *vol, const char *args) {
+    char line[128];
+    char *argv[BENCH_MAX_ARGS];
+    int argc = 0;
+
+    strncpy(line, args, sizeof(line) - 1);
+    line[sizeof(line) - 1] = 0;
+    for (char *p = line; *p && argc < BENCH_MAX_ARGS;) {
+        while (*p == ' ' || *p == '\t') *p++ = 0;
+        if (!*p) break;
+        argv[argc++] = p;
+        while (*p && *p != ' ' && *p != '\t') p++;
+    }
+
+    if (argc > 0) {
+        for (unsigned i = 0; i < sizeof(g_benches) / sizeof(g_benches[0]); i++) {
+            if (strcmp(argv[0], g_benches[i].name) == 0) {
+                g_benches[i].fn(vol, argc, argv);
+                return;
+            }
+        }
+    }
+    kprintf("Użycie: bench NAZWA [ARGUMENTY]\n");
+    for (unsigned i = 0; i < sizeof(g_benches) / sizeof(g_benches[0]); i++)
+        kprintf("  %s\n", g_benches[i].help);
+}
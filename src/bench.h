@@ -0,0 +1,42 @@
+/*
+ * [Cygnus] - [src/bench.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_BENCH_H
+#define CYGNUS_BENCH_H
+
+#include <stdint.h>
+#include "fat32.h"
+
+/* Znacznik czasu do pomiarów: surowe cykle TSC (tanie w pętli);
+ * na ns przelicza bench_ns (ktime.h). */
+uint64_t bench_now(void);
+uint64_t bench_ns(uint64_t ticks);
+
+/* Wypisuje "label: bajty, czas (us), przepustowość (MB/s)". */
+void bench_report(const char *label, uint64_t bytes, uint64_t ticks);
+
+/* Czyta cały plik (z pustym cache, żeby mierzyć dysk). */
+int bench_read_file(fat32_volume_t *vol, const char *path, uint32_t flags,
+                    uint64_t *bytes, uint64_t *ticks);
+
+/* Komenda powłoki: "bench NAZWA [ARGUMENTY]". */
+void bench_run(fat32_volume_t *vol, const char *args);
+
+#endif /* CYGNUS_BENCH_H */
@@ -0,0 +1,163 @@
+/*
+ * [Cygnus] - [src/checksum.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "checksum.h"
+#include "cpu.h"
+#include <string.h>
+
+#define CRC32_POLY 0xEDB88320u  /* odwrócony 0x04C11DB7 */
+#define CRC32C_POLY 0x82F63B78u /* odwrócony 0x1EDC6F41 */
+
+/* duże bloki: odczyt idzie przez cache stron, więc 64 KiB = 16 stron */
+#define CHECKSUM_BUF (64u * 1024)
+
+static uint32_t g_crc32_tab[8][256];
+static uint32_t g_crc32c_tab[8][256];
+static bool g_ready = false;
+static bool g_hw = false;
+
+static uint8_t g_buf[CHECKSUM_BUF];
+
+static void build_tables(uint32_t tab[8][256], uint32_t poly) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++) c = (c >> 1) ^ (poly & (0u - (c & 1)));
+    tab[0][i] = c;
+  }
+  /* tab[k][i] = CRC bajtu i, po którym idzie k zerowych bajtów */
+  for (int k = 1; k < 8; k++)
+    for (uint32_t i = 0; i < 256; i++)
+      tab[k][i] = (tab[k - 1][i] >> 8) ^ tab[0][tab[k - 1][i] & 0xFF];
+}
+
+static void crc_init(void) {
+  if (g_ready) return;
+  build_tables(g_crc32_tab, CRC32_POLY);
+  build_tables(g_crc32c_tab, CRC32C_POLY);
+  uint32_t a, b, c, d;
+  cpuid(0, &a, &b, &c, &d);
+  if (a >= 1) {
+    cpuid(1, &a, &b, &c, &d);
+    g_hw = (c & CPUID_ECX_SSE42) != 0;
+  }
+  g_ready = true;
+}
+
+static inline uint32_t ld32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+/* Rdzeń slice-by-8 na wartości wewnętrznej (bez końcowego XOR). */
+static uint32_t slice8(uint32_t tab[8][256], uint32_t crc, const uint8_t *p,
+                       uint32_t len) {
+  while (len && ((uintptr_t)p & 3)) {
+    crc = (crc >> 8) ^ tab[0][(crc ^ *p++) & 0xFF];
+    len--;
+  }
+  while (len >= 8) {
+    uint32_t lo = ld32(p) ^ crc;
+    uint32_t hi = ld32(p + 4);
+    crc = tab[7][lo & 0xFF] ^ tab[6][(lo >> 8) & 0xFF] ^
+          tab[5][(lo >> 16) & 0xFF] ^ tab[4][lo >> 24] ^
+          tab[3][hi & 0xFF] ^ tab[2][(hi >> 8) & 0xFF] ^
+          tab[1][(hi >> 16) & 0xFF] ^ tab[0][hi >> 24];
+    p += 8;
+    len -= 8;
+  }
+  while (len--) crc = (crc >> 8) ^ tab[0][(crc ^ *p++) & 0xFF];
+  return crc;
+}
+
+/* SSE4.2: 4 bajty na instrukcję (w trybie 32-bit nie ma crc32q) */
+static uint32_t crc32c_sse42(uint32_t crc, const uint8_t *p, uint32_t len) {
+  while (len && ((uintptr_t)p & 3)) {
+    __asm__("crc32b %1, %0" : "+r"(crc) : "rm"(*p));
+    p++;
+    len--;
+  }
+  while (len >= 16) {
+    __asm__("crc32l %1, %0" : "+r"(crc) : "rm"(ld32(p)));
+    __asm__("crc32l %1, %0" : "+r"(crc) : "rm"(ld32(p + 4)));
+    __asm__("crc32l %1, %0" : "+r"(crc) : "rm"(ld32(p + 8)));
+    __asm__("crc32l %1, %0" : "+r"(crc) : "rm"(ld32(p + 12)));
+    p += 16;
+    len -= 16;
+  }
+  while (len >= 4) {
+    __asm__("crc32l %1, %0" : "+r"(crc) : "rm"(ld32(p)));
+    p += 4;
+    len -= 4;
+  }
+  while (len--) {
+    __asm__("crc32b %1, %0" : "+r"(crc) : "rm"(*p));
+    p++;
+  }
+  return crc;
+}
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t len) {
+  crc_init();
+  return ~slice8(g_crc32_tab, ~crc, (const uint8_t *)data, len);
+}
+
+uint32_t crc32c_update(uint32_t crc, const void *data, uint32_t len) {
+  crc_init();
+  if (g_hw) return ~crc32c_sse42(~crc, (const uint8_t *)data, len);
+  return ~slice8(g_crc32c_tab, ~crc, (const uint8_t *)data, len);
+}
+
+bool crc32c_hw(void) {
+  crc_init();
+  return g_hw;
+}
+
+int checksum_file(fat32_volume_t *vol, const char *path,
+                  checksum_result_t *out) {
+  fat32_file_t *f = NULL;
+  memset(out, 0, sizeof(*out));
+  crc_init();
+
+  int rc = fat32_open(vol, path, &f);
+  if (rc) return rc;
+  if (f->is_dir) {
+    fat32_close(f);
+    return CHECKSUM_ERR_ISDIR;
+  }
+
+  for (;;) {
+    uint32_t got = 0;
+    uint64_t t0 = rdtsc();
+    rc = fat32_read(f, g_buf, sizeof(g_buf), &got);
+    uint64_t t1 = rdtsc();
+    out->io_ticks += t1 - t0;
+    if (rc || got == 0) break;
+
+    out->crc32 = crc32_update(out->crc32, g_buf, got);
+    uint64_t t2 = rdtsc();
+    out->crc32c = crc32c_update(out->crc32c, g_buf, got);
+    out->crc32_ticks += t2 - t1;
+    out->crc32c_ticks += rdtsc() - t2;
+    out->bytes += got;
+  }
+  fat32_close(f);
+  return rc;
+}
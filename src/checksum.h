@@ -0,0 +1,60 @@
+/*
+ * [Cygnus] - [src/checksum.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_CHECKSUM_H
+#define CYGNUS_CHECKSUM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fat32.h"
+
+/* CRC32 (IEEE, jak zip/`crc32`) i CRC32C (Castagnoli, jak iSCSI/ext4).
+ *
+ * CRC32 liczymy programowo metodą slice-by-8 (8 tablic po 256 wpisów,
+ * 8 bajtów na iterację). CRC32C liczy instrukcja `crc32` z SSE4.2, jeżeli
+ * CPUID ją zgłasza; w przeciwnym razie ta sama metoda slice-by-8.
+ * Obie funkcje przyjmują i zwracają wartość "na zewnątrz" (z końcowym
+ * XOR), więc można je wołać kawałkami: crc = crc32_update(crc, ...),
+ * zaczynając od 0.
+ */
+
+uint32_t crc32_update(uint32_t crc, const void *data, uint32_t len);
+uint32_t crc32c_update(uint32_t crc, const void *data, uint32_t len);
+
+/* true, gdy CRC32C idzie przez instrukcję SSE4.2 */
+bool crc32c_hw(void);
+
+enum { CHECKSUM_ERR_ISDIR = -40 };
+
+typedef struct {
+  uint32_t crc32;
+  uint32_t crc32c;
+  uint64_t bytes;
+  uint64_t io_ticks;     /* czas samego czytania pliku */
+  uint64_t crc32_ticks;  /* czas liczenia CRC32 */
+  uint64_t crc32c_ticks; /* czas liczenia CRC32C */
+} checksum_result_t;
+
+/* Czyta plik dużymi blokami i liczy obie sumy, mierząc osobno I/O i
+ * obliczenia. Zwraca 0 gdy OK, kod fat32 przy błędzie. */
+int checksum_file(fat32_volume_t *vol, const char *path,
+                  checksum_result_t *out);
+
+#endif /* CYGNUS_CHECKSUM_H */
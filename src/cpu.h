@@ -0,0 +1,91 @@
+/*
+ * [Cygnus] - [src/cpu.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_CPU_H
+#define CYGNUS_CPU_H
+
+#include <stdint.h>
+
+/* ===== Drobne instrukcje CPU (x86) ===== */
+
+/* Licznik cykli (TSC). */
+static inline uint64_t rdtsc(void) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)hi << 32) | lo;
+}
+
+/* Stan flagi IF i sekcje z wyłączonymi przerwaniami. */
+static inline uint32_t irq_save(void) {
+    uint32_t fl;
+    __asm__ volatile ("pushfl; popl %0; cli" : "=r"(fl) : : "memory");
+    return fl;
+}
+static inline void irq_restore(uint32_t fl) {
+    if (fl & (1u << 9)) __asm__ volatile ("sti" : : : "memory");
+}
+static inline int irqs_enabled(void) {
+    uint32_t fl;
+    __asm__ volatile ("pushfl; popl %0" : "=r"(fl));
+    return (fl >> 9) & 1;
+}
+
+/* Czekamy na przerwanie, jeżeli 'cond' (sprawdzane przy wyłączonych
+ * przerwaniach) nadal jest prawdziwe. sti działa dopiero po następnej
+ * instrukcji, więc przerwanie między sprawdzeniem a hlt nie ginie.
+ * Czekamy tylko raz: budzi dowolne przerwanie, więc wołający musi
+ * sprawdzić 'cond' ponownie w pętli. */
+#define CPU_WAIT_WHILE(cond) do { \
+        __asm__ volatile ("cli" : : : "memory"); \
+        if (cond) __asm__ volatile ("sti; hlt" : : : "memory"); \
+        else __asm__ volatile ("sti" : : : "memory"); \
+    } while (0)
+
+/* CPUID: liść 'leaf', podliść 0. */
+static inline void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c,
+                         uint32_t *d) {
+    __asm__ volatile ("cpuid"
+                      : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d)
+                      : "a"(leaf), "c"(0));
+}
+
+/* Rejestry MSR. */
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t lo, hi;
+    __asm__ volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t)hi << 32) | lo;
+}
+static inline void wrmsr(uint32_t msr, uint64_t v) {
+    __asm__ volatile ("wrmsr" : : "c"(msr), "a"((uint32_t)v), "d"((uint32_t)(v >> 32)));
+}
+
+#define MSR_IA32_PAT 0x277
+
+/* bity CPUID.1:ECX */
+#define CPUID_ECX_SSE42 (1u << 20)
+
+/* bity CPUID.1:EDX */
+#define CPUID_EDX_PSE (1u << 3)
+#define CPUID_EDX_PGE (1u << 13)
+#define CPUID_EDX_PAT (1u << 16)
+#define CPUID_EDX_FXSR (1u << 24)
+#define CPUID_EDX_SSE2 (1u << 26)
+
+#endif /* CYGNUS_CPU_H */
@@ -0,0 +1,59 @@
+/*
+ * [Cygnus] - [src/debugcon.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "debugcon.h"
+#include "io.h"
+#include "klog.h"
+
+static bool g_present;
+static unsigned g_route;
+
+bool debugcon_detect(void) {
+    g_present = inb(DEBUGCON_PORT) == DEBUGCON_PORT;
+    return g_present;
+}
+
+bool debugcon_present(void) { return g_present; }
+
+void debugcon_write(const char *s, size_t n) {
+    if (g_present && n) outsb(DEBUGCON_PORT, s, (uint32_t)n);
+}
+
+static void debugcon_sink_write(ksink_t *s, const char *buf, size_t n) {
+    (void)s;
+    debugcon_write(buf, n);
+}
+
+ksink_t g_ksink_debugcon = { debugcon_sink_write, NULL };
+
+int debugcon_route(unsigned what) {
+    if (what && !g_present) return -1;
+    if (what & DEBUGCON_LOG) {
+        kprintf_add_sink(&g_ksink_debugcon);
+        klog_set_output(&g_ksink_debugcon);
+    } else {
+        kprintf_remove_sink(&g_ksink_debugcon);
+        klog_set_output(NULL);
+    }
+    g_route = what;
+    return 0;
+}
+
+unsigned debugcon_routed(void) { return g_route; }
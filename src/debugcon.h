@@ -0,0 +1,53 @@
+/*
+ * [Cygnus] - [src/debugcon.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_DEBUGCON_H
+#define CYGNUS_DEBUGCON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "../inc/std.h"
+
+/* Konsola debugcon QEMU/Bochs na porcie 0xE9 (`-debugcon file:log.txt`
+ * albo `-debugcon stdio`). Każdy zapis na port to od razu bajt na wyjściu
+ * hosta – bez emulacji UART, więc całe bufory wysyłamy jednym rep outsb.
+ * Bajty idą bez zmian (bez LF → CR+LF), więc `cat` zrzuca plik 1:1.
+ */
+
+#define DEBUGCON_PORT 0xE9
+
+/* co kierujemy na debugcon (debugcon_route) */
+#define DEBUGCON_LOG 0x1  /* kprintf + drain/dmesg logu jądra */
+#define DEBUGCON_CAT 0x2  /* wyjście komendy cat */
+
+/* Odczyt z 0xE9 zwraca 0xE9, jeżeli port jest emulowany. */
+bool debugcon_detect(void);
+bool debugcon_present(void);
+
+void debugcon_write(const char *s, size_t n);
+
+extern ksink_t g_ksink_debugcon;
+
+/* Ustawia, co idzie na debugcon (DEBUGCON_*; 0 = nic). Zwraca -1, gdy
+ * portu nie ma. Log trafia wtedy także na UART, cat – tylko na 0xE9. */
+int debugcon_route(unsigned what);
+unsigned debugcon_routed(void);
+
+#endif /* CYGNUS_DEBUGCON_H */
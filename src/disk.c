@@ -33,6 +33,10 @@ int disk_read_sectors(int disk_id, uint32_t lba, uint32_t count, void* buf) {
     return ata_lba_read_n((uint8_t)disk_id, lba, count, buf);
 }
 
+int disk_write_sectors(int disk_id, uint32_t lba, uint32_t count, const void* buf) {
+    return ata_lba_write_n((uint8_t)disk_id, lba, count, buf);
+}
+
 /* Skanujemy MBR (LBA0) i przepisujemy 4 wpisy do mbr_partition_t.
  * Zwraca 0 gdy OK, <0 przy błędzie/nieprawidłowej sygnaturze.
  * Uwaga: struktury mbr_t i mbr_partition_t pochodzą z inc/disk.h.
@@ -73,13 +77,16 @@ int fat32_read_from_disk(void* dev, uint64_t lba, uint32_t count, void* buf) {
     /* dopóki mamy LBA28/32-bit, odrzucamy zakres > 0xFFFFFFFF */
     if (phys_lba > 0xFFFFFFFFull) return -1;
 
-    /* czytamy sektor po sektorze (wystarczy na start) */
-    uint8_t* p = (uint8_t*)buf;
-    for (uint32_t i = 0; i < count; i++) {
-        uint64_t cur = phys_lba + i;
-        if (cur > 0xFFFFFFFFull) return -2;
-        int rc = disk_read_sectors(d->disk_id, (uint32_t)cur, 1, p + i * CYG_SECTOR_SIZE);
-        if (rc) return rc;
-    }
-    return 0;
+    /* cały zakres musi się zmieścić w 32-bit LBA */
+    if (count && phys_lba + count - 1 > 0xFFFFFFFFull) return -2;
+
+    /* jedna komenda wielosektorowa zamiast pętli po sektorze */
+    return disk_read_sectors(d->disk_id, (uint32_t)phys_lba, count, buf);
+}
+
+int fat32_write_to_disk(void* dev, uint64_t lba, uint32_t count, const void* buf) {
+    const disk_dev_t* d = (const disk_dev_t*)dev;
+    uint64_t phys_lba = (uint64_t)d->base_lba + lba;
+    if (count && phys_lba + count - 1 > 0xFFFFFFFFull) return -2;
+    return disk_write_sectors(d->disk_id, (uint32_t)phys_lba, count, buf);
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*
+ * [Cygnus] - [src/dma.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "dma.h"
+#include "memstat.h"
+#include "paging.h"
+#include <string.h>
+
+typedef struct dma_free_blk {
+  struct dma_free_blk *next;
+} dma_free_blk_t;
+
+static dma_free_blk_t *g_pool[DMA_CLASSES];
+static dma_stats_t g_st;
+
+static unsigned size_class(size_t size, size_t align) {
+  size_t need = size > align ? size : align;
+  unsigned shift = DMA_MIN_SHIFT;
+  while (shift <= DMA_MAX_SHIFT && ((size_t)1 << shift) < need) shift++;
+  return shift;
+}
+
+/* Dokłada do puli klasy 'c' (poniżej strony) bloki z jednej nowej ramki. */
+static int pool_refill(unsigned c) {
+  uintptr_t fr = pmm_alloc_frame();
+  if (!fr) return -1;
+  g_st.frames++;
+  mem_account_alloc(MEM_DMA, PAGE_SIZE);
+  uint32_t bs = 1u << (c + DMA_MIN_SHIFT);
+  for (uint32_t off = 0; off < PAGE_SIZE; off += bs) {
+    dma_free_blk_t *b = (dma_free_blk_t *)(fr + off); /* tożsamościowo */
+    b->next = g_pool[c];
+    g_pool[c] = b;
+    g_st.cls[c].cached++;
+    g_st.cls[c].fresh++;
+  }
+  return 0;
+}
+
+void *dma_alloc(size_t size, size_t align, size_t boundary, uint64_t *phys) {
+  unsigned shift = size_class(size ? size : 1, align);
+  if (shift > DMA_MAX_SHIFT) return NULL;
+  if (boundary && boundary < ((size_t)1 << shift)) return NULL;
+
+  unsigned c = shift - DMA_MIN_SHIFT;
+  dma_class_stats_t *cs = &g_st.cls[c];
+  void *p;
+
+  if (g_pool[c]) {
+    p = g_pool[c];
+    g_pool[c] = g_pool[c]->next;
+    cs->cached--;
+  } else if (shift < DMA_PAGE_SHIFT) {
+    if (pool_refill(c)) return NULL;
+    p = g_pool[c];
+    g_pool[c] = g_pool[c]->next;
+    cs->cached--;
+  } else {
+    uintptr_t blk = pmm_alloc_pages(shift - DMA_PAGE_SHIFT);
+    if (!blk) return NULL;
+    g_st.frames += 1u << (shift - DMA_PAGE_SHIFT);
+    mem_account_alloc(MEM_DMA, (size_t)1 << shift);
+    cs->fresh++;
+    p = (void *)blk;
+  }
+
+  cs->inuse++;
+  cs->allocs++;
+  /* bez stronicowania adres fizyczny = wirtualny */
+  if (phys) *phys = (uint64_t)(uintptr_t)p;
+  return p;
+}
+
+void dma_free(void *virt, size_t size, size_t align) {
+  if (!virt) return;
+  unsigned shift = size_class(size ? size : 1, align);
+  if (shift > DMA_MAX_SHIFT) return;
+  unsigned c = shift - DMA_MIN_SHIFT;
+  dma_free_blk_t *b = (dma_free_blk_t *)virt;
+  b->next = g_pool[c];
+  g_pool[c] = b;
+  g_st.cls[c].inuse--;
+  g_st.cls[c].cached++;
+}
+
+void *kalloc_dma(size_t size, uint64_t *phys) {
+  size_t boundary = size <= PAGE_SIZE ? PAGE_SIZE : 0;
+  void *p = dma_alloc(size, 64, boundary, phys);
+  if (p) memset(p, 0, size);
+  return p;
+}
+
+void kfree_dma(void *virt, size_t size) { dma_free(virt, size, 64); }
+
+void dma_get_stats(dma_stats_t *out) {
+  *out = g_st;
+  for (unsigned c = 0; c < DMA_CLASSES; c++)
+    out->cls[c].size = 1u << (c + DMA_MIN_SHIFT);
+}
@@ -0,0 +1,73 @@
+/*
+ * [Cygnus] - [src/dma.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_DMA_H
+#define CYGNUS_DMA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Pamięć dla urządzeń z bus-masteringiem (IDE BM, AHCI, NVMe, virtio, xHCI).
+ *
+ * Każdy przydział to blok o rozmiarze będącym potęgą dwójki (64 B .. 4 MiB),
+ * wyrównany do własnego rozmiaru – taki blok nie przecina żadnej granicy
+ * większej lub równej swojemu rozmiarowi. Wymagania urządzenia (wyrównanie,
+ * granica 4 KiB / 64 KiB) sprowadzamy więc do wyboru klasy rozmiaru.
+ * Bloki są fizycznie ciągłe i leżą poniżej 4 GiB (PMM nie widzi wyżej).
+ *
+ * Zwolnione bloki wracają do puli swojej klasy i są wydawane ponownie,
+ * więc ringi tworzone przy każdym resecie kontrolera nie chodzą do PMM.
+ * Klasy poniżej strony kroją całe ramki; klasy od 4 KiB biorą bloki
+ * z allokatora buddy.
+ */
+
+#define DMA_MIN_SHIFT 6u   /* 64 B */
+#define DMA_PAGE_SHIFT 12u /* 4 KiB */
+#define DMA_MAX_SHIFT 22u  /* 4 MiB = PMM_MAX_ORDER */
+#define DMA_CLASSES (DMA_MAX_SHIFT - DMA_MIN_SHIFT + 1u)
+
+typedef struct {
+  uint32_t size;   /* rozmiar bloku klasy */
+  uint32_t inuse;  /* bloki wydane */
+  uint32_t cached; /* bloki w puli, gotowe do ponownego wydania */
+  uint32_t allocs; /* wszystkie przydziały */
+  uint32_t fresh;  /* bloki, które trzeba było wziąć z PMM */
+} dma_class_stats_t;
+
+typedef struct {
+  uint32_t frames; /* ramki PMM trzymane przez pule DMA */
+  dma_class_stats_t cls[DMA_CLASSES];
+} dma_stats_t;
+
+/* 'align' i 'boundary' – potęgi dwójki albo 0 (bez wymagań). Zwraca adres
+ * wirtualny i fizyczny w *phys albo NULL, gdy wymagań nie da się spełnić
+ * (boundary mniejsze niż rozmiar) lub brakuje pamięci. */
+void *dma_alloc(size_t size, size_t align, size_t boundary, uint64_t *phys);
+/* 'size' i 'align' jak przy dma_alloc – wyznaczają klasę bloku. */
+void dma_free(void *virt, size_t size, size_t align);
+
+/* Domyślne wymagania: wyrównanie 64 B, bez przecinania granicy 4 KiB dla
+ * bloków do 4 KiB (xHCI: ringi, konteksty, DCBAA). Pamięć jest wyzerowana. */
+void *kalloc_dma(size_t size, uint64_t *phys);
+void kfree_dma(void *virt, size_t size);
+
+void dma_get_stats(dma_stats_t *out);
+
+#endif /* CYGNUS_DMA_H */
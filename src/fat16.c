@@ -19,13 +19,38 @@
  * limitations under the Licence.
  */
 #include "fat16.h"
+#include "kmalloc.h"
 #include "../inc/std.h"
 #include <string.h>
 
 static fat16_entry_t fat16_entries[FAT16_MAX_ENTRIES];
-static int fat16_fd_count = 0, fat16_dir_count = 0;
-static fat16_fd_t fat16_fds[16];
-static fat16_dir_t fat16_dirs[16];
+static fat16_fd_t fat16_fds[FAT16_MAX_FDS];
+static fat16_dir_t fat16_dirs[FAT16_MAX_FDS];
+
+static int valid_fd(int fd) {
+  return fd >= 0 && fd < FAT16_MAX_FDS && fat16_fds[fd].idx > 0;
+}
+
+// grow the content buffer to hold at least 'size' bytes (doubling)
+static int reserve(fat16_entry_t *e, int size) {
+  if (size <= e->content_cap)
+    return 0;
+  if (size > FAT16_MAX_FILESIZE)
+    return -1;
+  int cap = e->content_cap ? e->content_cap : 4096;
+  while (cap < size)
+    cap = cap > FAT16_MAX_FILESIZE / 2 ? FAT16_MAX_FILESIZE : cap * 2;
+  char *p = kmalloc(cap);
+  if (!p)
+    return -1;
+  if (e->content) {
+    memcpy(p, e->content, e->content_size);
+    kfree(e->content);
+  }
+  e->content = p;
+  e->content_cap = cap;
+  return 0;
+}
 
 static int find_free_entry() {
   for (int i = 1; i < FAT16_MAX_ENTRIES; i++)
@@ -53,7 +78,7 @@ static int lookup(const char *path) {
     p++;
   while (*p) {
     char *slash = strchr(p, '/');
-    int len = slash ? (slash - p) : strlen(p);
+    int len = slash ? (slash - p) : (int)strlen(p);
     strncpy(buf, p, len);
     buf[len] = 0;
     int idx = find_in_dir(cur, buf);
@@ -78,6 +103,9 @@ void fat16_init(void) {
   fat16_entries[0].next_sibling = -1;
   for (int i = 1; i < FAT16_MAX_ENTRIES; ++i)
     fat16_entries[i].type = FAT16_FREE;
+  memset(fat16_fds, 0, sizeof(fat16_fds));
+  for (int i = 0; i < FAT16_MAX_FDS; ++i)
+    fat16_dirs[i].idx = -1;
 }
 
 int fat16_mkdir(const char *path) {
@@ -141,18 +169,25 @@ int fat16_open(const char *path, int flags) {
       fat16_entries[i].first_child = -1;
       fat16_entries[i].next_sibling = fat16_entries[p].first_child;
       fat16_entries[p].first_child = i;
+      fat16_entries[i].content = NULL;
       fat16_entries[i].content_size = 0;
+      fat16_entries[i].content_cap = 0;
     } else
       return -1;
   }
   if (fat16_entries[i].type != FAT16_FILE)
     return -1;
-  fat16_fds[fat16_fd_count].idx = i;
-  fat16_fds[fat16_fd_count].pos = 0;
-  return fat16_fd_count++;
+  for (int fd = 0; fd < FAT16_MAX_FDS; fd++) {
+    if (fat16_fds[fd].idx)
+      continue;
+    fat16_fds[fd].idx = i;
+    fat16_fds[fd].pos = 0;
+    return fd;
+  }
+  return -1;
 }
 int fat16_read(int fd, void *buf, int size) {
-  if (fd < 0 || fd >= fat16_fd_count)
+  if (!valid_fd(fd))
     return -1;
   int i = fat16_fds[fd].idx;
   int rem = fat16_entries[i].content_size - fat16_fds[fd].pos;
@@ -165,23 +200,57 @@ int fat16_read(int fd, void *buf, int size) {
   return size;
 }
 int fat16_write(int fd, const void *buf, int size) {
-  if (fd < 0 || fd >= fat16_fd_count)
+  if (!valid_fd(fd))
     return -1;
   int i = fat16_fds[fd].idx;
   int pos = fat16_fds[fd].pos;
   if (pos + size > FAT16_MAX_FILESIZE)
     size = FAT16_MAX_FILESIZE - pos;
+  if (size <= 0)
+    return 0;
+  if (reserve(&fat16_entries[i], pos + size))
+    return -1;
+  if (pos > fat16_entries[i].content_size)
+    memset(fat16_entries[i].content + fat16_entries[i].content_size, 0,
+           pos - fat16_entries[i].content_size);
   memcpy(fat16_entries[i].content + pos, buf, size);
   fat16_fds[fd].pos += size;
   if (fat16_fds[fd].pos > fat16_entries[i].content_size)
     fat16_entries[i].content_size = fat16_fds[fd].pos;
   return size;
 }
-int fat16_close(int fd) { return 0; }
+int fat16_close(int fd) {
+  if (!valid_fd(fd))
+    return -1;
+  fat16_fds[fd].idx = 0;
+  return 0;
+}
+int fat16_seek(int fd, int pos) {
+  if (!valid_fd(fd) || pos < 0)
+    return -1;
+  fat16_fds[fd].pos = pos;
+  return 0;
+}
+int fat16_size(int fd) {
+  if (!valid_fd(fd))
+    return -1;
+  return fat16_entries[fat16_fds[fd].idx].content_size;
+}
 int fat16_unlink(const char *path) {
   int i = lookup(path);
-  if (i <= 0)
+  if (i <= 0 || (fat16_entries[i].type == FAT16_DIR && fat16_entries[i].first_child != -1))
     return -1;
+  for (int fd = 0; fd < FAT16_MAX_FDS; fd++)
+    if (fat16_fds[fd].idx == i)
+      return -1;
+  // unlink from the parent's child list
+  int *link = &fat16_entries[fat16_entries[i].parent].first_child;
+  while (*link != i)
+    link = &fat16_entries[*link].next_sibling;
+  *link = fat16_entries[i].next_sibling;
+  kfree(fat16_entries[i].content);
+  fat16_entries[i].content = NULL;
+  fat16_entries[i].content_size = fat16_entries[i].content_cap = 0;
   fat16_entries[i].type = FAT16_FREE;
   return 0;
 }
@@ -189,12 +258,17 @@ int fat16_opendir(const char *path) {
   int i = lookup(path);
   if (i < 0 || fat16_entries[i].type != FAT16_DIR)
     return -1;
-  fat16_dirs[fat16_dir_count].idx = i;
-  fat16_dirs[fat16_dir_count].child = fat16_entries[i].first_child;
-  return fat16_dir_count++;
+  for (int dh = 0; dh < FAT16_MAX_FDS; dh++) {
+    if (fat16_dirs[dh].idx != -1)
+      continue;
+    fat16_dirs[dh].idx = i;
+    fat16_dirs[dh].child = fat16_entries[i].first_child;
+    return dh;
+  }
+  return -1;
 }
 int fat16_readdir(int dh, char *name, int *is_dir) {
-  if (dh < 0 || dh >= fat16_dir_count)
+  if (dh < 0 || dh >= FAT16_MAX_FDS || fat16_dirs[dh].idx == -1)
     return -1;
   int c = fat16_dirs[dh].child;
   if (c == -1)
@@ -204,4 +278,9 @@ int fat16_readdir(int dh, char *name, int *is_dir) {
   fat16_dirs[dh].child = fat16_entries[c].next_sibling;
   return 0;
 }
-int fat16_closedir(int dh) { return 0; }
\ No newline at end of file
+int fat16_closedir(int dh) {
+  if (dh < 0 || dh >= FAT16_MAX_FDS)
+    return -1;
+  fat16_dirs[dh].idx = -1;
+  return 0;
+}
\ No newline at end of file
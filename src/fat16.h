@@ -23,7 +23,9 @@
 
 #define FAT16_MAX_NAME 64
 #define FAT16_MAX_ENTRIES 128
-#define FAT16_MAX_FILESIZE 4096
+// content grows on demand (kmalloc), limited by the largest heap block
+#define FAT16_MAX_FILESIZE (4 * 1024 * 1024 - 64)
+#define FAT16_MAX_FDS 16
 
 typedef enum { FAT16_FILE, FAT16_DIR, FAT16_FREE } fat16_type_t;
 
@@ -32,17 +34,18 @@ typedef struct {
     fat16_type_t type;
     int parent;   // Index in entries
     int first_child, next_sibling;
-    char content[FAT16_MAX_FILESIZE];
+    char *content;
     int content_size;
+    int content_cap;
 } fat16_entry_t;
 
 typedef struct {
-    int idx;
+    int idx;  // 0 = free slot
     int pos;
 } fat16_fd_t;
 
 typedef struct {
-    int idx;
+    int idx;  // -1 = free slot
     int child;
 } fat16_dir_t;
 
@@ -52,6 +55,8 @@ int fat16_open(const char *path, int flags);
 int fat16_read(int fd, void *buf, int size);
 int fat16_write(int fd, const void *buf, int size);
 int fat16_close(int fd);
+int fat16_seek(int fd, int pos);
+int fat16_size(int fd);
 
 int fat16_opendir(const char *path);
 int fat16_readdir(int dh, char *name, int *is_dir);
@@ -19,9 +19,15 @@
  * limitations under the Licence.
  */
 #include "fat32.h"
+#include "fat32_aio.h"
+#include "kmalloc.h"
+#include "lz4.h"
+#include "pagecache.h"
+#include "paging.h"
 #include <stdarg.h>
 #include <string.h>
 #include "../inc/std.h"   /* ksnprintf/kprintf, putchar/print */
+#include "klog.h"
 
 /* ===== Minimalne wartości domyślne ===== */
 #ifndef FAT32_STATIC
@@ -42,10 +48,8 @@ FAT32_STATIC void dlog(const char *fmt, ...) {
 #ifdef FAT32_ENABLE_LOG
   va_list ap;
   va_start(ap, fmt);
-  char buf[256];
-  kvsnprintf(buf, (int)sizeof(buf), fmt, ap);
+  vklogf(KLOG_DEBUG, fmt, ap);  /* do dmesg, bez czekania na UART */
   va_end(ap);
-  kprintf("%s", buf);
 #else
   (void)fmt;
 #endif
@@ -70,6 +74,17 @@ uint32_t fat32_cluster_to_lba(const fat32_volume_t *vol, uint32_t clus) {
 
 bool fat32_is_eoc(uint32_t clus) { return (clus >= 0x0FFFFFF8U); }
 
+/* Jednosektorowy cache FAT: kolejne wpisy łańcucha zwykle leżą w tym samym
+ * sektorze, więc przejście po łańcuchu to jeden odczyt na 128 klastrów. */
+static uint8_t g_fat_sec[512];
+static const fat32_volume_t *g_fat_vol = NULL;
+static uint32_t g_fat_lba = (uint32_t)-1;
+
+void fat32_fat_cache_drop(void) {
+  g_fat_vol = NULL;
+  g_fat_lba = (uint32_t)-1;
+}
+
 int fat32_next_cluster(const fat32_volume_t *vol, uint32_t current,
                        uint32_t *next_out) {
   /* Każdy wpis FAT32 ma 32 bity (górne 4 zarezerwowane) */
@@ -78,18 +93,16 @@ int fat32_next_cluster(const fat32_volume_t *vol, uint32_t current,
       vol->fat_start_lba + (fat_offset_bytes / vol->bytes_per_sector);
   uint32_t offset = fat_offset_bytes % vol->bytes_per_sector;
 
-  uint8_t *buf = (uint8_t *)fat32_malloc(vol->bytes_per_sector);
-  if (!buf)
-    return -1;
-  int rc = vol->read(vol->dev, sector, 1, buf);
-  if (rc) {
-    fat32_free(buf);
-    return -2;
+  if (g_fat_vol != vol || g_fat_lba != sector) {
+    if (vol->read(vol->dev, sector, 1, g_fat_sec)) {
+      fat32_fat_cache_drop();
+      return -2;
+    }
+    g_fat_vol = vol;
+    g_fat_lba = sector;
   }
 
-  uint32_t val = rd32(buf + offset) & 0x0FFFFFFF;
-  fat32_free(buf);
-  *next_out = val;
+  *next_out = rd32(g_fat_sec + offset) & 0x0FFFFFFF;
   return 0;
 }
 
@@ -134,6 +147,12 @@ int fat32_mount(fat32_volume_t *vol, void *dev, fat32_read_sectors_fn read_fn) {
   vol->bytes_per_sector       = vol->bpb.bytes_per_sector;
   vol->sectors_per_cluster    = vol->bpb.sectors_per_cluster;
   vol->fat_start_lba          = vol->bpb.reserved_sectors;
+  /* bez lustra ważny jest tylko aktywny FAT – z niego czytamy */
+  if (vol->bpb.ext_flags & FAT32_EXT_NO_MIRROR) {
+    uint32_t active = vol->bpb.ext_flags & FAT32_EXT_ACTIVE_FAT;
+    if (active >= vol->bpb.num_fats) return -5;
+    vol->fat_start_lba += active * vol->bpb.fat_size32;
+  }
   vol->root_dir_first_cluster = vol->bpb.root_cluster;
 
   uint32_t total_sectors = vol->bpb.total_sectors32
@@ -154,6 +173,10 @@ int fat32_mount(fat32_volume_t *vol, void *dev, fat32_read_sectors_fn read_fn) {
   return 0;
 }
 
+void fat32_attach_writer(fat32_volume_t *vol, fat32_write_sectors_fn write_fn) {
+  vol->write = write_fn;
+}
+
 /* ===== Przechodzenie po katalogach i obsługa LFN ===== */
 
 FAT32_STATIC void trim_spaces(char *s) {
@@ -317,6 +340,8 @@ FAT32_STATIC int iterate_dir(fat32_volume_t *vol, uint32_t start_cluster,
 
       fat32_dirent_info_t info;
       build_dirent_info(de, &lacc, &info);
+      info.dir_cluster = clus;
+      info.dir_offset = off;
       lfn_reset(&lacc);
       int rc = cb(de, &info, opaque);
       if (rc != 0) {
@@ -379,18 +404,10 @@ FAT32_STATIC int match_cb(const fat32_dirent_t *raw,
   find_ctx_t *ctx = (find_ctx_t *)opaque;
   if (!ctx->target || !ctx->target_len)
     return 0;
-  /* porównanie bez rozróżniania wielkości liter */
-  char name[256];
-  strncpy(name, info->name, sizeof(name));
-  for (char *p = name; *p; ++p)
-    if (*p >= 'a' && *p <= 'z') *p -= 32;
-  char tgt[256];
-  ZERO(tgt, sizeof(tgt));
-  strncpy(tgt, ctx->target, MIN(sizeof(tgt) - 1, ctx->target_len));
-  for (char *p = tgt; *p; ++p)
-    if (*p >= 'a' && *p <= 'z') *p -= 32;
-
-  if (strncmp(name, tgt, 255) == 0) {
+  /* porównanie bez rozróżniania wielkości liter, bez kopiowania nazw */
+  if (ctx->target_len < sizeof(info->name) &&
+      strncasecmp(info->name, ctx->target, ctx->target_len) == 0 &&
+      info->name[ctx->target_len] == 0) {
     ctx->found = *info;
     ctx->found_raw = raw;
     ctx->matched = true;
@@ -439,39 +456,59 @@ FAT32_STATIC int resolve_path_to_entry(fat32_volume_t *vol, const char *path,
 
 /* ===== Otwieranie / czytanie ===== */
 
+int fat32_stat(fat32_volume_t *vol, const char *path, fat32_dirent_info_t *out) {
+  return resolve_path_to_entry(vol, path, out);
+}
+
+FAT32_STATIC int lz4_src(void *ctx, uint32_t off, void *buf, uint32_t n);
+
 int fat32_open(fat32_volume_t *vol, const char *path, fat32_file_t **out) {
+  return fat32_open_ex(vol, path, 0, out);
+}
+
+/* Uchwyty plików mają własny cache slabów (zwalniamy je zwykłym
+ * fat32_free – kfree rozpozna slab). */
+static kmem_cache_t *file_cache(void) {
+  static kmem_cache_t *c;
+  if (!c) c = kmem_cache_create("fat32_file", sizeof(fat32_file_t), 0);
+  return c;
+}
+
+int fat32_open_ex(fat32_volume_t *vol, const char *path, uint32_t flags,
+                  fat32_file_t **out) {
   fat32_dirent_info_t inf;
   int rc = resolve_path_to_entry(vol, path, &inf);
   if (rc) return rc;
 
-  fat32_file_t *f = (fat32_file_t *)fat32_malloc(sizeof(*f));
+  kmem_cache_t *fc = file_cache();
+  fat32_file_t *f = fc ? (fat32_file_t *)kmem_cache_zalloc(fc) : NULL;
   if (!f) return -1;
-  ZERO(f, sizeof(*f));
   f->vol = vol;
   f->start_cluster = inf.first_cluster;
   f->size_bytes = inf.size;
   f->is_dir = inf.is_dir;
   f->pos = 0;
-  f->cluster_buf =
-      (uint8_t *)fat32_malloc(vol->sectors_per_cluster * vol->bytes_per_sector);
-  if (!f->cluster_buf) {
-    fat32_free(f);
-    return -2;
+  /* dane pliku idą przez cache stron – bez własnego bufora klastra */
+  f->cluster_buf = NULL;
+  f->chain_idx = 0;
+  f->chain_clus = inf.first_cluster;
+  f->last_page = (uint32_t)-1;
+
+  if (flags & FAT32_OPEN_LZ4) {
+    if (f->is_dir) {
+      fat32_free(f);
+      return -12;
+    }
+    rc = lz4_stream_open(lz4_src, f, f->size_bytes, &f->lz4);
+    if (rc) {
+      fat32_free(f);
+      return rc;
+    }
   }
-  f->cluster_buf_num = (uint32_t)-1;
   *out = f;
   return 0;
 }
 
-FAT32_STATIC int cluster_index_and_offset(const fat32_volume_t *vol,
-                                          uint32_t pos, uint32_t *cluster_index,
-                                          uint32_t *offset_in_cluster) {
-  const uint32_t csz = vol->sectors_per_cluster * vol->bytes_per_sector;
-  *cluster_index = pos / csz;
-  *offset_in_cluster = pos % csz;
-  return 0;
-}
-
 FAT32_STATIC int get_cluster_at_index(const fat32_volume_t *vol,
                                       uint32_t start_cluster, uint32_t idx,
                                       uint32_t *out_clus) {
@@ -486,41 +523,140 @@ FAT32_STATIC int get_cluster_at_index(const fat32_volume_t *vol,
   return 0;
 }
 
+/* Jak get_cluster_at_index, ale idziemy od podpowiedzi w uchwycie, jeżeli
+ * szukany indeks leży dalej – przy czytaniu sekwencyjnym to jeden krok. */
+FAT32_STATIC int file_cluster_at(fat32_file_t *f, uint32_t idx,
+                                 uint32_t *out_clus) {
+  uint32_t from_idx = 0, from_clus = f->start_cluster;
+  if (idx >= f->chain_idx) {
+    from_idx = f->chain_idx;
+    from_clus = f->chain_clus;
+  }
+  uint32_t c;
+  if (get_cluster_at_index(f->vol, from_clus, idx - from_idx, &c)) return -1;
+  f->chain_idx = idx;
+  f->chain_clus = c;
+  *out_clus = c;
+  return 0;
+}
+
+/* Wypełnienie strony cache: czytamy sektory z klastrów pokrywających
+ * [page_index*4K, +4K); klastry leżące ciągiem czytamy jednym żądaniem,
+ * ogon za końcem pliku zerujemy. */
+FAT32_STATIC int fill_page(void *ctx, uint32_t page_index, uint8_t *page) {
+  fat32_file_t *f = (fat32_file_t *)ctx;
+  const fat32_volume_t *vol = f->vol;
+  const uint32_t bps = vol->bytes_per_sector;
+  const uint32_t csz = vol->sectors_per_cluster * bps;
+  const uint32_t base = page_index * PAGE_SIZE;
+
+  uint32_t run_lba = 0, run_cnt = 0, run_off = 0;
+  uint32_t off = 0;
+  while (off < PAGE_SIZE && base + off < f->size_bytes) {
+    uint32_t pos = base + off;
+    uint32_t coff = pos % csz;
+    uint32_t clus;
+    if (file_cluster_at(f, pos / csz, &clus)) return -1;
+
+    uint32_t avail = f->size_bytes - pos;
+    uint32_t n = MIN(csz - coff, PAGE_SIZE - off);
+    n = MIN(n, (avail + bps - 1) / bps * bps);
+
+    uint32_t lba = fat32_cluster_to_lba(vol, clus) + coff / bps;
+    if (run_cnt && lba == run_lba + run_cnt) {
+      run_cnt += n / bps;
+    } else {
+      if (run_cnt && vol->read(vol->dev, run_lba, run_cnt, page + run_off))
+        return -2;
+      run_lba = lba;
+      run_cnt = n / bps;
+      run_off = off;
+    }
+    off += n;
+  }
+  if (run_cnt && vol->read(vol->dev, run_lba, run_cnt, page + run_off))
+    return -2;
+  if (off < PAGE_SIZE) ZERO(page + off, PAGE_SIZE - off);
+  return 0;
+}
+
+/* Czytanie surowych bajtów pliku od 'pos' przez cache stron. */
+FAT32_STATIC uint32_t read_at(fat32_file_t *f, uint32_t pos, void *buf,
+                              uint32_t n) {
+  uint8_t *dst = (uint8_t *)buf;
+  uint32_t done = 0;
+  while (done < n) {
+    uint32_t pidx = pos >> PAGE_SHIFT;
+    uint32_t off = pos & (PAGE_SIZE - 1u);
+
+    /* Strona z cache (albo z dysku przy chybieniu) */
+    const uint8_t *page = pcache_get(f->vol, f->start_cluster, pidx,
+                                     pidx != f->last_page, fill_page, f);
+    if (!page) break;
+    f->last_page = pidx;
+
+    uint32_t chunk = MIN(PAGE_SIZE - off, n - done);
+    memcpy(dst + done, page + off, chunk);
+    done += chunk;
+    pos += chunk;
+  }
+  return done;
+}
+
+/* Źródło danych skompresowanych dla dekodera LZ4 */
+FAT32_STATIC int lz4_src(void *ctx, uint32_t off, void *buf, uint32_t n) {
+  fat32_file_t *f = (fat32_file_t *)ctx;
+  if (off > f->size_bytes || n > f->size_bytes - off) return -1;
+  return read_at(f, off, buf, n) == n ? 0 : -13;
+}
+
 int fat32_read(fat32_file_t *f, void *buf, uint32_t nbytes,
                uint32_t *out_read) {
   if (f->is_dir) return -12; /* czytanie bajtów z katalogu nieobsługiwane */
+  if (f->lz4) return lz4_stream_read(f->lz4, buf, nbytes, out_read);
 
   uint32_t remain = (f->pos < f->size_bytes) ? (f->size_bytes - f->pos) : 0;
   uint32_t toread = MIN(remain, nbytes);
-  uint8_t *dst = (uint8_t *)buf;
 
-  const uint32_t csz = f->vol->sectors_per_cluster * f->vol->bytes_per_sector;
+  uint32_t done = read_at(f, f->pos, buf, toread);
+  f->pos += done;
 
-  uint32_t done = 0;
-  while (done < toread) {
-    uint32_t cidx, off;
-    cluster_index_and_offset(f->vol, f->pos, &cidx, &off);
-
-    /* Upewniamy się, że bufor klastra jest załadowany dla tego cidx */
-    if (f->cluster_buf_num != cidx) {
-      uint32_t clus;
-      if (get_cluster_at_index(f->vol, f->start_cluster, cidx, &clus)) break;
-      if (read_entire_cluster(f->vol, clus, f->cluster_buf)) break;
-      f->cluster_buf_num = cidx;
-    }
+  if (out_read) *out_read = done;
+  return (done == toread) ? 0 : -13;
+}
 
-    uint32_t chunk = MIN(csz - off, toread - done);
-    memcpy(dst + done, f->cluster_buf + off, chunk);
-    done += chunk;
-    f->pos += chunk;
+int fat32_pread(fat32_file_t *f, uint32_t offset, void *buf, uint32_t nbytes,
+                uint32_t *out_read) {
+  if (f->is_dir) return -12;
+  if (f->lz4) {
+    /* dekoder ma jeden kursor: przestawiamy i wracamy (indeks bloków
+     * robi z tego tani skok dla ramek z blokami niezależnymi) */
+    uint32_t save = lz4_stream_tell(f->lz4);
+    int rc = lz4_stream_seek(f->lz4, offset);
+    if (rc == 0) rc = lz4_stream_read(f->lz4, buf, nbytes, out_read);
+    lz4_stream_seek(f->lz4, save);
+    return rc;
   }
 
+  uint32_t remain = (offset < f->size_bytes) ? (f->size_bytes - offset) : 0;
+  uint32_t toread = MIN(remain, nbytes);
+  uint32_t done = read_at(f, offset, buf, toread);
+
   if (out_read) *out_read = done;
   return (done == toread) ? 0 : -13;
 }
 
+int fat32_seek(fat32_file_t *f, uint32_t pos) {
+  if (f->is_dir) return -12;
+  if (f->lz4) return lz4_stream_seek(f->lz4, pos);
+  f->pos = pos; /* za końcem pliku read zwróci po prostu 0 bajtów */
+  return 0;
+}
+
 void fat32_close(fat32_file_t *f) {
   if (!f) return;
+  fat32_aio_cancel(f); /* zaległe odczyty asynchroniczne dostają -14 */
+  if (f->lz4) lz4_stream_close(f->lz4);
   if (f->cluster_buf) fat32_free(f->cluster_buf);
   fat32_free(f);
 }
@@ -592,6 +728,8 @@ int fat32_readdir_next(fat32_file_t *dir_handle, fat32_dirent_info_t *out) {
     if (de->attr & FAT32_ATTR_VOLUME_ID) { lfn_reset(&it->lacc); continue; }
 
     build_dirent_info(de, &it->lacc, out);
+    out->dir_cluster = it->cur_cluster;
+    out->dir_offset = it->off_in_cluster - dsz;
     lfn_reset(&it->lacc);
     return 0;
   }
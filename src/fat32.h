@@ -25,6 +25,8 @@
 
 typedef int (*fat32_read_sectors_fn)(void *dev, uint64_t lba, uint32_t count,
                                      void *buf);
+typedef int (*fat32_write_sectors_fn)(void *dev, uint64_t lba, uint32_t count,
+                                      const void *buf);
 
 void *fat32_malloc(size_t sz);
 void fat32_free(void *p);
@@ -67,6 +69,14 @@ typedef struct {
   uint16_t boot_signature55AA;
 } fat32_bpb_t;
 
+// BPB ext_flags: bit 7 = tylko jeden FAT aktywny (bez lustra), bity 0-3 = który
+#define FAT32_EXT_NO_MIRROR 0x0080u
+#define FAT32_EXT_ACTIVE_FAT 0x000Fu
+
+#define FAT32_FSINFO_LEAD 0x41615252u
+#define FAT32_FSINFO_STRUCT 0x61417272u
+#define FAT32_FSINFO_UNKNOWN 0xFFFFFFFFu // free_count / next_free nieznane
+
 typedef struct {
   uint32_t lead_sig; // 0x41615252
   uint8_t reserved1[480];
@@ -118,6 +128,7 @@ enum {
 typedef struct {
   void *dev;
   fat32_read_sectors_fn read;
+  fat32_write_sectors_fn write; // NULL = tylko do odczytu (tylko defrag pisze)
   fat32_bpb_t bpb;
 
   uint32_t bytes_per_sector;
@@ -128,15 +139,26 @@ typedef struct {
   uint32_t total_clusters;
 } fat32_volume_t;
 
+struct lz4_stream;
+
 typedef struct {
   uint32_t start_cluster;
   uint32_t size_bytes;
   uint32_t pos;
   bool is_dir;
   fat32_volume_t *vol;
-  // prosty buffer dla jednego klastra (cluster)
+  // bufor jednego klastra – tylko dla iteratora katalogu, pliki czytamy
+  // przez cache stron (pagecache.h)
   uint8_t *cluster_buf;
-  uint32_t cluster_buf_num;
+  // podpowiedź do łańcucha: ostatnio znaleziony klaster i jego indeks
+  uint32_t chain_idx;
+  uint32_t chain_clus;
+  // ostatnio czytana strona (kolejne odczyty tej samej strony nie promują
+  // jej w cache)
+  uint32_t last_page;
+  // dekompresja w locie (FAT32_OPEN_LZ4); pos/size_bytes dotyczą wtedy
+  // danych skompresowanych
+  struct lz4_stream *lz4;
 } fat32_file_t;
 
 typedef struct {
@@ -144,13 +166,29 @@ typedef struct {
   bool is_dir;
   uint32_t size;
   uint32_t first_cluster;
+  // gdzie leży wpis 8.3 (klaster katalogu + offset w bajtach); 0 dla roota
+  uint32_t dir_cluster;
+  uint32_t dir_offset;
 } fat32_dirent_info_t;
 
 // API (nie no rozkurwi mnie od wewnątrz jak będę musiał to naprawiać(teraz też
 // rozpierdala))
 int fat32_mount(fat32_volume_t *vol, void *dev, fat32_read_sectors_fn read_fn);
+void fat32_attach_writer(fat32_volume_t *vol, fat32_write_sectors_fn write_fn);
+int fat32_stat(fat32_volume_t *vol, const char *path, fat32_dirent_info_t *out);
+// flagi fat32_open_ex
+enum {
+  FAT32_OPEN_LZ4 = 0x01, // plik to ramka LZ4, fat32_read oddaje dane po dekompresji
+};
+
 int fat32_open(fat32_volume_t *vol, const char *path, fat32_file_t **out);
+int fat32_open_ex(fat32_volume_t *vol, const char *path, uint32_t flags,
+                  fat32_file_t **out);
 int fat32_read(fat32_file_t *f, void *buf, uint32_t nbytes, uint32_t *out_read);
+// odczyt od zadanego offsetu, bez ruszania pozycji pliku
+int fat32_pread(fat32_file_t *f, uint32_t offset, void *buf, uint32_t nbytes,
+                uint32_t *out_read);
+int fat32_seek(fat32_file_t *f, uint32_t pos);
 void fat32_close(fat32_file_t *f);
 
 int fat32_readdir_first(fat32_volume_t *vol, uint32_t dir_cluster,
@@ -162,4 +200,6 @@ void fat32_readdir_close(fat32_file_t *dir_handle);
 uint32_t fat32_cluster_to_lba(const fat32_volume_t *vol, uint32_t clus);
 int fat32_next_cluster(const fat32_volume_t *vol, uint32_t current,
                        uint32_t *next_out);
-bool fat32_is_eoc(uint32_t clus);
\ No newline at end of file
+bool fat32_is_eoc(uint32_t clus);
+/* po zapisie do FAT (defrag) unieważniamy sektor FAT trzymany w pamięci */
+void fat32_fat_cache_drop(void);
\ No newline at end of file
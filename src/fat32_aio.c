@@ -0,0 +1,120 @@
+/*
+ * [Cygnus] - [src/fat32_aio.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "fat32_aio.h"
+#include <stddef.h>
+
+#define AIO_STEP 4096u /* jeden krok = najwyżej jedna strona cache */
+
+typedef struct {
+  int id;                 /* 0 = slot wolny */
+  fat32_file_t *f;
+  uint8_t *buf;
+  uint32_t len;
+  uint32_t offset;
+  uint32_t done;
+  fat32_aio_cb cb;
+  void *ctx;
+} aio_req_t;
+
+static aio_req_t g_reqs[FAT32_AIO_MAX];
+static uint32_t g_pending = 0;
+static uint32_t g_rr = 0;     /* następny slot do obsłużenia */
+static int g_next_id = 1;
+
+static void complete(aio_req_t *r, int status) {
+  /* zwalniamy slot przed callbackiem – może zlecić następny odczyt */
+  fat32_aio_cb cb = r->cb;
+  void *ctx = r->ctx;
+  uint32_t done = r->done;
+  r->id = 0;
+  g_pending--;
+  if (cb) cb(ctx, status, done);
+}
+
+int fat32_read_async(fat32_file_t *f, void *buf, uint32_t len,
+                     uint32_t offset, fat32_aio_cb cb, void *ctx) {
+  if (!f || f->is_dir) return -12;
+  for (uint32_t i = 0; i < FAT32_AIO_MAX; i++) {
+    aio_req_t *r = &g_reqs[i];
+    if (r->id) continue;
+    r->id = g_next_id++;
+    if (g_next_id <= 0) g_next_id = 1;
+    r->f = f;
+    r->buf = (uint8_t *)buf;
+    r->len = len;
+    r->offset = offset;
+    r->done = 0;
+    r->cb = cb;
+    r->ctx = ctx;
+    g_pending++;
+    return r->id;
+  }
+  return FAT32_AIO_ERR_FULL;
+}
+
+/* Jeden krok żądania: do granicy strony albo do końca bufora. */
+static void step(aio_req_t *r) {
+  uint32_t pos = r->offset + r->done;
+  uint32_t n = AIO_STEP - (pos & (AIO_STEP - 1));
+  if (n > r->len - r->done) n = r->len - r->done;
+
+  uint32_t got = 0;
+  int rc = n ? fat32_pread(r->f, pos, r->buf + r->done, n, &got) : 0;
+  r->done += got;
+  if (rc) complete(r, rc);
+  else if (got < n || r->done == r->len) complete(r, 0);
+}
+
+uint32_t fat32_aio_poll(uint32_t max_steps) {
+  while (max_steps-- && g_pending) {
+    for (uint32_t k = 0; k < FAT32_AIO_MAX; k++) {
+      aio_req_t *r = &g_reqs[g_rr];
+      g_rr = (g_rr + 1) % FAT32_AIO_MAX;
+      if (r->id) {
+        step(r);
+        break;
+      }
+    }
+  }
+  return g_pending;
+}
+
+bool fat32_aio_idle(void) {
+  if (!g_pending) return false;
+  fat32_aio_poll(8);
+  return true;
+}
+
+bool fat32_aio_pending(int id) {
+  for (uint32_t i = 0; i < FAT32_AIO_MAX; i++)
+    if (g_reqs[i].id == id) return true;
+  return false;
+}
+
+void fat32_aio_wait(int id) {
+  while (fat32_aio_pending(id)) fat32_aio_poll(1);
+}
+
+void fat32_aio_cancel(fat32_file_t *f) {
+  for (uint32_t i = 0; i < FAT32_AIO_MAX; i++)
+    if (g_reqs[i].id && g_reqs[i].f == f)
+      complete(&g_reqs[i], FAT32_AIO_ERR_CANCEL);
+}
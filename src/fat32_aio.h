@@ -0,0 +1,76 @@
+/*
+ * [Cygnus] - [src/fat32_aio.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_FAT32_AIO_H
+#define CYGNUS_FAT32_AIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fat32.h"
+
+/* Asynchroniczne odczyty plików FAT32.
+ *
+ * fat32_read_async tylko wstawia żądanie do kolejki i od razu wraca.
+ * Żądania są realizowane kawałkami (najwyżej jedna strona 4 KiB na krok)
+ * przez fat32_aio_poll, na zmianę między wszystkimi zaległymi żądaniami,
+ * więc kilka odczytów (także z różnych plików) postępuje równolegle.
+ * Poll woła pętla bezczynności powłoki (idle.h) oraz fat32_aio_wait.
+ *
+ * Dopóki dysk to ATA PIO bez przerwań, krok wykonuje się synchronicznie
+ * w wątku, który woła poll – kolejka daje za to miejsce, w które
+ * sterowniki z własnymi kolejkami (AHCI, NVMe, virtio) włożą wiele żądań
+ * naraz, a wywołującemu możliwość liczenia w trakcie odczytu.
+ */
+
+#ifndef FAT32_AIO_MAX
+#define FAT32_AIO_MAX 16
+#endif
+
+enum {
+  FAT32_AIO_ERR_FULL = -50,    /* brak wolnego miejsca w kolejce */
+  FAT32_AIO_ERR_CANCEL = -14,  /* plik zamknięty przed końcem odczytu */
+};
+
+/* Wołane po zakończeniu: 'status' 0 albo kod błędu, 'nread' – bajty w
+ * buforze (mniej niż żądano na końcu pliku). Można z niej zlecać kolejne
+ * odczyty. */
+typedef void (*fat32_aio_cb)(void *ctx, int status, uint32_t nread);
+
+/* Zwraca identyfikator żądania (>0) albo kod błędu (<0). Bufor musi żyć
+ * do wywołania callbacku. */
+int fat32_read_async(fat32_file_t *f, void *buf, uint32_t len,
+                     uint32_t offset, fat32_aio_cb cb, void *ctx);
+
+/* Wykonuje najwyżej 'max_steps' kroków; zwraca liczbę zaległych żądań. */
+uint32_t fat32_aio_poll(uint32_t max_steps);
+
+/* Funkcja dla pętli bezczynności (idle_register): kilka kroków naraz. */
+bool fat32_aio_idle(void);
+
+/* Czeka (pollując) aż żądanie 'id' się zakończy. */
+void fat32_aio_wait(int id);
+
+/* Czy żądanie 'id' jest jeszcze w kolejce? */
+bool fat32_aio_pending(int id);
+
+/* Kończy wszystkie żądania pliku 'f' kodem FAT32_AIO_ERR_CANCEL. */
+void fat32_aio_cancel(fat32_file_t *f);
+
+#endif /* CYGNUS_FAT32_AIO_H */
@@ -19,33 +19,14 @@
  * limitations under the Licence.
  */
 #include <stddef.h>
-#include <stdint.h>
+#include "kmalloc.h"
 
-#ifndef FAT32_ARENA_SIZE
-#define FAT32_ARENA_SIZE (128 * 1024) /* 128 KiB na struktury FAT32 */
-#endif
-
-/* Wyrównujemy do 16 bajtów dla bezpieczeństwa. */
-static uint8_t g_fat32_arena[FAT32_ARENA_SIZE];
-static size_t  g_fat32_off = 0;
-
-static inline size_t align_up(size_t x, size_t a) {
-    return (x + (a - 1)) & ~(a - 1);
-}
-
-/* API oczekiwane przez fat32.c */
+/* API oczekiwane przez fat32.c – struktury FAT32 idą na stertę jądra
+ * (kmalloc.h); dawna własna arena 128 KiB już niepotrzebna. */
 void* fat32_malloc(size_t n) {
-    if (n == 0) n = 1;
-    size_t off = align_up(g_fat32_off, 16);
-    size_t end = off + align_up(n, 16);
-    if (end > FAT32_ARENA_SIZE) {
-        return NULL; /* brak miejsca */
-    }
-    void* p = (void*)(g_fat32_arena + off);
-    g_fat32_off = end;
-    return p;
+    return kmalloc(n);
 }
 
 void fat32_free(void* p) {
-    (void)p; /* no-op – arena jest jednorazowa */
-}
\ No newline at end of file
+    kfree(p);
+}
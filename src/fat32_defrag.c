@@ -0,0 +1,364 @@
+/*
+ * [Cygnus] - [src/fat32_defrag.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "fat32_defrag.h"
+#include "pagecache.h"
+#include <string.h>
+#include "../inc/std.h"
+
+#define FAT_MASK 0x0FFFFFFFu
+#define FAT_EOC 0x0FFFFFFFu
+#define FAT_BAD 0x0FFFFFF7u
+#define DEFRAG_MAX_DEPTH 16
+#define DEFRAG_PATH_MAX 256
+
+/* bufor kopiowania: tyle klastrów ekstentu naraz, ile się zmieści */
+static uint8_t g_copy_buf[64 * 1024];
+static uint8_t g_dir_sec[512];
+
+/* ===== Zapis FAT: jeden sektor w trybie write-back ===== */
+
+static uint8_t g_wsec[512];
+static uint32_t g_wsec_lba = (uint32_t)-1; /* offset sektora w FAT */
+static bool g_wsec_dirty = false;
+
+/* Zapisuje bieżący sektor do wszystkich kopii FAT, a przy wyłączonym
+ * lustrze (ext_flags bit 7) tylko do aktywnej – fat_start_lba już na nią
+ * wskazuje. */
+static int fat_flush(fat32_volume_t *vol) {
+  if (g_wsec_dirty) {
+    bool mirror = !(vol->bpb.ext_flags & FAT32_EXT_NO_MIRROR);
+    uint32_t first = mirror ? vol->bpb.reserved_sectors : vol->fat_start_lba;
+    uint32_t copies = mirror ? vol->bpb.num_fats : 1;
+    for (uint32_t k = 0; k < copies; k++) {
+      uint32_t lba = first + k * vol->bpb.fat_size32 + g_wsec_lba;
+      if (vol->write(vol->dev, lba, 1, g_wsec)) return -2;
+    }
+    g_wsec_dirty = false;
+  }
+  g_wsec_lba = (uint32_t)-1;
+  fat32_fat_cache_drop();
+  return 0;
+}
+
+/* Ustawia wpis FAT (górne 4 bity zostają nietknięte). */
+static int fat_put(fat32_volume_t *vol, uint32_t clus, uint32_t val) {
+  uint32_t byte = clus * 4;
+  uint32_t sec = byte / vol->bytes_per_sector;
+  uint32_t off = byte % vol->bytes_per_sector;
+
+  if (sec != g_wsec_lba) {
+    if (g_wsec_dirty && fat_flush(vol)) return -2;
+    if (vol->read(vol->dev, vol->fat_start_lba + sec, 1, g_wsec)) return -2;
+    g_wsec_lba = sec;
+  }
+  uint32_t old = (uint32_t)g_wsec[off] | ((uint32_t)g_wsec[off + 1] << 8) |
+                 ((uint32_t)g_wsec[off + 2] << 16) |
+                 ((uint32_t)g_wsec[off + 3] << 24);
+  val = (old & ~FAT_MASK) | (val & FAT_MASK);
+  g_wsec[off] = (uint8_t)val;
+  g_wsec[off + 1] = (uint8_t)(val >> 8);
+  g_wsec[off + 2] = (uint8_t)(val >> 16);
+  g_wsec[off + 3] = (uint8_t)(val >> 24);
+  g_wsec_dirty = true;
+  return 0;
+}
+
+/* ===== FSInfo ===== */
+
+static uint8_t g_fsi_sec[512];
+
+/* Czyta sektor FSInfo; false, gdy woluminu go nie ma albo jest
+ * nieprawidłowy (wtedy nic w nim nie zmieniamy). */
+static bool fsinfo_read(fat32_volume_t *vol) {
+  uint16_t s = vol->bpb.fsinfo;
+  if (!s || s == 0xFFFF || s >= vol->bpb.reserved_sectors) return false;
+  if (vol->read(vol->dev, s, 1, g_fsi_sec)) return false;
+  const fat32_fsinfo_t *fi = (const fat32_fsinfo_t *)g_fsi_sec;
+  return fi->lead_sig == FAT32_FSINFO_LEAD && fi->struct_sig == FAT32_FSINFO_STRUCT;
+}
+
+static int fsinfo_write(fat32_volume_t *vol, uint32_t free_count,
+                        uint32_t next_free) {
+  fat32_fsinfo_t *fi = (fat32_fsinfo_t *)g_fsi_sec;
+  fi->free_count = free_count;
+  fi->next_free = next_free;
+  return vol->write(vol->dev, vol->bpb.fsinfo, 1, g_fsi_sec) ? -2 : 0;
+}
+
+/* ===== Analiza łańcuchów ===== */
+
+static bool clus_valid(const fat32_volume_t *vol, uint32_t c) {
+  return c >= 2 && c < vol->total_clusters + 2;
+}
+
+/* Liczy klastry i ekstenty łańcucha; wykrywa pętle i złe wpisy. */
+static int chain_extents(const fat32_volume_t *vol, uint32_t start,
+                         uint32_t *clusters, uint32_t *extents) {
+  uint32_t n = 0, e = 0, prev = 0, c = start;
+  while (!fat32_is_eoc(c)) {
+    if (!clus_valid(vol, c) || n >= vol->total_clusters)
+      return FAT32_DEFRAG_CHAIN;
+    if (n == 0 || c != prev + 1) e++;
+    n++;
+    prev = c;
+    if (fat32_next_cluster(vol, c, &c)) return -2;
+  }
+  *clusters = n;
+  *extents = e;
+  return 0;
+}
+
+/* Przegląd wolnego miejsca. Gdy 'need' > 0, zwraca w *found początek
+ * pierwszego wolnego obszaru o długości >= need i kończy wcześniej. */
+static int scan_free(const fat32_volume_t *vol, uint32_t need,
+                     uint32_t *found, fat32_frag_stats_t *st) {
+  uint32_t run_start = 0, run_len = 0;
+  uint32_t end = vol->total_clusters + 2;
+
+  for (uint32_t c = 2; c <= end; c++) {
+    uint32_t v = 1;
+    if (c < end && fat32_next_cluster(vol, c, &v)) return -2;
+    if (c < end && v == 0) {
+      if (run_len++ == 0) run_start = c;
+      if (need && run_len >= need) {
+        *found = run_start;
+        return 0;
+      }
+      continue;
+    }
+    if (run_len && st) {
+      st->free_clusters += run_len;
+      st->free_extents++;
+      if (run_len > st->largest_free) st->largest_free = run_len;
+    }
+    run_len = 0;
+  }
+  return need ? FAT32_DEFRAG_NOSPACE : 0;
+}
+
+/* ===== Przenoszenie pliku ===== */
+
+/* Kopiuje dane łańcucha 'start' (n klastrów) do klastrów dst..dst+n-1,
+ * czytając kolejne klastry źródła jednym żądaniem. */
+static int copy_chain(fat32_volume_t *vol, uint32_t start, uint32_t n,
+                      uint32_t dst) {
+  uint32_t csz = vol->sectors_per_cluster * vol->bytes_per_sector;
+  uint32_t batch = sizeof(g_copy_buf) / csz;
+  uint32_t c = start, done = 0;
+
+  while (done < n) {
+    uint32_t first = c, run = 0;
+    while (run < batch && done + run < n) {
+      run++;
+      uint32_t nxt;
+      if (fat32_next_cluster(vol, c, &nxt)) return -2;
+      if (done + run < n && nxt != c + 1) {
+        c = nxt;
+        break;
+      }
+      c = nxt;
+    }
+    if (vol->read(vol->dev, fat32_cluster_to_lba(vol, first),
+                  run * vol->sectors_per_cluster, g_copy_buf))
+      return -2;
+    if (vol->write(vol->dev, fat32_cluster_to_lba(vol, dst + done),
+                   run * vol->sectors_per_cluster, g_copy_buf))
+      return -2;
+    done += run;
+  }
+  return 0;
+}
+
+/* Przepina wpis 8.3 na nowy pierwszy klaster. */
+static int set_first_cluster(fat32_volume_t *vol,
+                             const fat32_dirent_info_t *inf, uint32_t clus) {
+  uint32_t lba = fat32_cluster_to_lba(vol, inf->dir_cluster) +
+                 inf->dir_offset / vol->bytes_per_sector;
+  if (vol->read(vol->dev, lba, 1, g_dir_sec)) return -2;
+  fat32_dirent_t *de =
+      (fat32_dirent_t *)(g_dir_sec + inf->dir_offset % vol->bytes_per_sector);
+  if ((((uint32_t)de->firstClusterHigh << 16) | de->firstClusterLow) !=
+      inf->first_cluster)
+    return FAT32_DEFRAG_CHAIN; /* wpis nie jest tym, który czytaliśmy */
+  de->firstClusterHigh = (uint16_t)(clus >> 16);
+  de->firstClusterLow = (uint16_t)(clus & 0xFFFF);
+  return vol->write(vol->dev, lba, 1, g_dir_sec) ? -2 : 0;
+}
+
+static int defrag_entry(fat32_volume_t *vol, const fat32_dirent_info_t *inf) {
+  if (!vol->write) return FAT32_DEFRAG_RO;
+  if (inf->is_dir) return FAT32_DEFRAG_ISDIR;
+  uint32_t start = inf->first_cluster;
+  if (start < 2 || inf->dir_cluster < 2) return 1;
+
+  uint32_t n, e;
+  int rc = chain_extents(vol, start, &n, &e);
+  if (rc) return rc;
+  if (e <= 1) return 1;
+
+  uint32_t dst;
+  rc = scan_free(vol, n, &dst, NULL);
+  if (rc) return rc;
+
+  /* 1) dane, 2) nowy łańcuch, 3) wpis katalogu, 4) zwolnienie starego.
+   * Na czas zmian w FAT licznik wolnych klastrów w FSInfo oznaczamy jako
+   * nieznany – przerwanie w środku zostawia najwyżej jego przeliczenie
+   * przy następnym montowaniu, a nie złą liczbę. */
+  if ((rc = copy_chain(vol, start, n, dst))) return rc;
+
+  bool fsi = fsinfo_read(vol);
+  uint32_t free_count = FAT32_FSINFO_UNKNOWN;
+  if (fsi) {
+    free_count = ((const fat32_fsinfo_t *)g_fsi_sec)->free_count;
+    uint32_t hint = ((const fat32_fsinfo_t *)g_fsi_sec)->next_free;
+    if (free_count != FAT32_FSINFO_UNKNOWN && fsinfo_write(vol, FAT32_FSINFO_UNKNOWN, hint))
+      return -2;
+  }
+
+  for (uint32_t i = 0; i < n; i++)
+    if (fat_put(vol, dst + i, i + 1 < n ? dst + i + 1 : FAT_EOC)) return -2;
+  if (fat_flush(vol)) return -2;
+
+  if ((rc = set_first_cluster(vol, inf, dst))) return rc;
+
+  uint32_t low = FAT32_FSINFO_UNKNOWN;
+  for (uint32_t c = start, i = 0; !fat32_is_eoc(c) && i < n; i++) {
+    uint32_t nxt;
+    if (c < low) low = c;
+    /* następnika czytamy z bufora zapisu, jeśli sektor już w nim siedzi */
+    if (g_wsec_lba == c * 4 / vol->bytes_per_sector) {
+      uint32_t off = c * 4 % vol->bytes_per_sector;
+      nxt = ((uint32_t)g_wsec[off] | ((uint32_t)g_wsec[off + 1] << 8) |
+             ((uint32_t)g_wsec[off + 2] << 16) |
+             ((uint32_t)g_wsec[off + 3] << 24)) & FAT_MASK;
+    } else if (fat32_next_cluster(vol, c, &nxt)) {
+      return -2;
+    }
+    if (fat_put(vol, c, 0)) return -2;
+    c = nxt;
+  }
+  if (fat_flush(vol)) return -2;
+
+  /* zajęliśmy n klastrów i tyle samo zwolniliśmy; podpowiedź wskazuje
+   * najniższy zwolniony */
+  if (fsi && fsinfo_write(vol, free_count, low)) return -2;
+
+  pcache_invalidate_file(vol, start);
+  return 0;
+}
+
+int fat32_defrag_file(fat32_volume_t *vol, const char *path) {
+  fat32_dirent_info_t inf;
+  int rc = fat32_stat(vol, path, &inf);
+  if (rc) return rc;
+  return defrag_entry(vol, &inf);
+}
+
+/* ===== Przejście drzewa ===== */
+
+typedef struct {
+  fat32_volume_t *vol;
+  fat32_frag_stats_t *st;
+  bool verbose;
+  bool defrag;
+  uint32_t moved;
+  uint32_t failed;
+  char path[DEFRAG_PATH_MAX];
+} walk_t;
+
+static int walk_dir(walk_t *w, uint32_t dir_cluster, size_t plen, int depth) {
+  fat32_file_t *it = NULL;
+  int rc = fat32_readdir_first(w->vol, dir_cluster, &it);
+  if (rc) return rc;
+
+  fat32_dirent_info_t inf;
+  while ((rc = fat32_readdir_next(it, &inf)) == 0) {
+    if (!strcmp(inf.name, ".") || !strcmp(inf.name, "..")) continue;
+
+    size_t nlen = strlen(inf.name);
+    if (plen + 1 + nlen >= DEFRAG_PATH_MAX) continue;
+    w->path[plen] = '/';
+    memcpy(w->path + plen + 1, inf.name, nlen + 1);
+
+    if (inf.is_dir) {
+      w->st->dirs++;
+      if (depth < DEFRAG_MAX_DEPTH && inf.first_cluster >= 2)
+        walk_dir(w, inf.first_cluster, plen + 1 + nlen, depth + 1);
+      continue;
+    }
+    if (inf.first_cluster < 2) continue; /* pusty plik */
+
+    uint32_t n, e;
+    if (chain_extents(w->vol, inf.first_cluster, &n, &e)) {
+      kprintf("[WARN] %s: uszkodzony łańcuch\n", w->path);
+      continue;
+    }
+    w->st->files++;
+    w->st->clusters += n;
+    w->st->extents += e;
+    if (e > 1) w->st->fragmented++;
+    if (w->verbose) kprintf("%u\t%u\t%s\n", n, e, w->path);
+
+    if (w->defrag && e > 1) {
+      int drc = defrag_entry(w->vol, &inf);
+      if (drc == 0) {
+        w->moved++;
+      } else {
+        w->failed++;
+        kprintf("[WARN] defrag %s: kod=%d\n", w->path, drc);
+      }
+    }
+  }
+  fat32_readdir_close(it);
+  w->path[plen] = 0;
+  return rc == 1 ? 0 : rc;
+}
+
+static int walk(fat32_volume_t *vol, walk_t *w, fat32_frag_stats_t *st) {
+  memset(st, 0, sizeof(*st));
+  w->vol = vol;
+  w->st = st;
+  w->path[0] = 0;
+  int rc = walk_dir(w, vol->root_dir_first_cluster, 0, 0);
+  if (rc) return rc;
+  return scan_free(vol, 0, NULL, st);
+}
+
+int fat32_frag_report(fat32_volume_t *vol, bool verbose,
+                      fat32_frag_stats_t *out) {
+  static walk_t w;
+  memset(&w, 0, sizeof(w));
+  w.verbose = verbose;
+  if (verbose) kprintf("klastry\tekstenty\tplik\n");
+  return walk(vol, &w, out);
+}
+
+int fat32_defrag_all(fat32_volume_t *vol, uint32_t *moved, uint32_t *failed) {
+  static walk_t w;
+  fat32_frag_stats_t st;
+  if (!vol->write) return FAT32_DEFRAG_RO;
+  memset(&w, 0, sizeof(w));
+  w.defrag = true;
+  int rc = walk(vol, &w, &st);
+  *moved = w.moved;
+  *failed = w.failed;
+  return rc;
+}
@@ -0,0 +1,69 @@
+/*
+ * [Cygnus] - [src/fat32_defrag.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_FAT32_DEFRAG_H
+#define CYGNUS_FAT32_DEFRAG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "fat32.h"
+
+/* Raport fragmentacji i defragmentacja plików na zamontowanym woluminie.
+ *
+ * Ekstent to ciąg kolejnych numerów klastrów w łańcuchu pliku; plik jest
+ * ciągły, gdy ma jeden ekstent. Defragmentacja przenosi plik do pierwszego
+ * wolnego obszaru, który go zmieści, w kolejności bezpiecznej przy
+ * przerwaniu: kopia danych -> nowy łańcuch w FAT -> wpis katalogu ->
+ * zwolnienie starego łańcucha. Przerwanie przed zmianą wpisu zostawia
+ * najwyżej zgubione klastry, nigdy uszkodzony plik. Katalogów nie ruszamy.
+ * FAT zapisujemy do wszystkich kopii, przy wyłączonym lustrze (ext_flags)
+ * tylko do aktywnej; FSInfo (licznik wolnych, podpowiedź) aktualizujemy.
+ */
+
+typedef struct {
+  uint32_t files;         /* pliki z danymi */
+  uint32_t dirs;
+  uint32_t fragmented;    /* pliki z więcej niż jednym ekstentem */
+  uint32_t clusters;      /* klastry zajęte przez pliki */
+  uint32_t extents;       /* ekstenty wszystkich plików */
+  uint32_t free_clusters;
+  uint32_t free_extents;  /* ciągłe obszary wolnego miejsca */
+  uint32_t largest_free;  /* największy wolny obszar (klastry) */
+} fat32_frag_stats_t;
+
+enum {
+  FAT32_DEFRAG_RO = -20,      /* brak ścieżki zapisu (fat32_attach_writer) */
+  FAT32_DEFRAG_NOSPACE = -21, /* brak ciągłego wolnego obszaru */
+  FAT32_DEFRAG_CHAIN = -22,   /* uszkodzony łańcuch (pętla / zły klaster) */
+  FAT32_DEFRAG_ISDIR = -23,
+};
+
+/* Przechodzi całe drzewo; z 'verbose' wypisuje ekstenty każdego pliku. */
+int fat32_frag_report(fat32_volume_t *vol, bool verbose,
+                      fat32_frag_stats_t *out);
+
+/* 0 = przeniesiony, 1 = już ciągły (albo pusty), <0 = błąd. */
+int fat32_defrag_file(fat32_volume_t *vol, const char *path);
+
+/* Defragmentuje wszystkie pofragmentowane pliki woluminu. */
+int fat32_defrag_all(fat32_volume_t *vol, uint32_t *moved,
+                     uint32_t *failed);
+
+#endif /* CYGNUS_FAT32_DEFRAG_H */
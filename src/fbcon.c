@@ -0,0 +1,328 @@
+/*
+ * [Cygnus] - [src/fbcon.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "fbcon.h"
+#include "cpu.h"
+#include "io.h"
+#include "ktime.h"
+#include "paging.h"
+#include "pci.h"
+#include <stddef.h>
+#include <string.h>
+
+/* Bochs Graphics Adapter: indeks/dane na portach 0x1CE/0x1CF */
+#define BGA_INDEX 0x01CE
+#define BGA_DATA 0x01CF
+enum {
+  BGA_REG_ID = 0,
+  BGA_REG_XRES = 1,
+  BGA_REG_YRES = 2,
+  BGA_REG_BPP = 3,
+  BGA_REG_ENABLE = 4,
+};
+#define BGA_ID_MIN 0xB0C0
+#define BGA_ID_MAX 0xB0C5
+#define BGA_ENABLED 0x01
+#define BGA_LFB 0x40
+
+/* QEMU std VGA / Bochs */
+#define BGA_PCI_VENDOR 0x1234
+#define BGA_PCI_DEVICE 0x1111
+#define BGA_DEFAULT_LFB 0xE0000000u /* Bochs ISA, bez PCI */
+
+#define FB_FG 0x00C0C0C0u
+#define FB_BG 0x00000000u
+
+/* co tyle ns rysujemy w trakcie długiego wypisywania (~100 Hz) */
+#define FB_FLUSH_NS 10000000ull
+
+/* font8x8_basic (public domain), znaki 0x20..0x7E, bit 0 = lewy piksel */
+static const uint8_t g_font[95][8];
+
+static volatile uint32_t *g_fb;
+static bool g_wc;
+static uint32_t g_phys;
+static uint8_t g_cells[FB_ROWS][FB_COLS]; /* tekst */
+static uint8_t g_shown[FB_ROWS][FB_COLS]; /* co jest na ekranie */
+static uint8_t g_dirty[FB_ROWS];          /* wiersz mógł się zmienić */
+static bool g_any_dirty;
+static uint32_t g_col, g_row;
+static uint64_t g_last_flush;
+static uint32_t g_flushes, g_glyphs, g_scrolls;
+
+/* UTF-8: składamy punkt kodowy i zastępujemy go znakiem ASCII */
+static uint32_t g_cp;
+static int g_cp_need;
+
+static const struct {
+  uint16_t cp;
+  char ascii;
+} g_translit[] = {
+    {0x0104, 'A'}, {0x0105, 'a'}, {0x0106, 'C'}, {0x0107, 'c'}, {0x0118, 'E'},
+    {0x0119, 'e'}, {0x0141, 'L'}, {0x0142, 'l'}, {0x0143, 'N'}, {0x0144, 'n'},
+    {0x00D3, 'O'}, {0x00F3, 'o'}, {0x015A, 'S'}, {0x015B, 's'}, {0x0179, 'Z'},
+    {0x017A, 'z'}, {0x017B, 'Z'}, {0x017C, 'z'}, {0x2013, '-'}, {0x2014, '-'},
+    {0x201D, '"'}, {0x201E, '"'}, {0x2192, '>'},
+};
+
+static uint16_t bga_read(uint16_t reg) {
+  outw(BGA_INDEX, reg);
+  return inw(BGA_DATA);
+}
+
+static void bga_write(uint16_t reg, uint16_t v) {
+  outw(BGA_INDEX, reg);
+  outw(BGA_DATA, v);
+}
+
+static void draw_cell(uint32_t row, uint32_t col, uint8_t ch) {
+  const uint8_t *g = g_font[(ch >= 0x20 && ch < 0x7F) ? ch - 0x20 : '?' - 0x20];
+  volatile uint32_t *p =
+      g_fb + row * FB_GLYPH_H * FB_WIDTH + col * FB_GLYPH_W;
+  for (uint32_t y = 0; y < FB_GLYPH_H; y++, p += FB_WIDTH) {
+    uint32_t bits = g[y >> 1];
+    for (uint32_t x = 0; x < FB_GLYPH_W; x++)
+      p[x] = (bits >> x) & 1 ? FB_FG : FB_BG;
+  }
+}
+
+void fbcon_flush(void) {
+  if (!g_fb || !g_any_dirty) return;
+  uint32_t fl = irq_save();
+  for (uint32_t r = 0; r < FB_ROWS; r++) {
+    if (!g_dirty[r]) continue;
+    g_dirty[r] = 0;
+    for (uint32_t c = 0; c < FB_COLS; c++) {
+      if (g_cells[r][c] == g_shown[r][c]) continue;
+      draw_cell(r, c, g_cells[r][c]);
+      g_shown[r][c] = g_cells[r][c];
+      g_glyphs++;
+    }
+  }
+  g_any_dirty = false;
+  g_flushes++;
+  g_last_flush = ktime_ns();
+  irq_restore(fl);
+}
+
+bool fbcon_idle(void) {
+  if (!g_any_dirty) return false;
+  fbcon_flush();
+  return true;
+}
+
+static void newline(void) {
+  g_col = 0;
+  if (++g_row < FB_ROWS) return;
+  g_row = FB_ROWS - 1;
+  memmove(g_cells[0], g_cells[1], (FB_ROWS - 1) * FB_COLS);
+  memset(g_cells[FB_ROWS - 1], ' ', FB_COLS);
+  memset(g_dirty, 1, sizeof(g_dirty));
+  g_scrolls++;
+}
+
+static void put_ascii(uint8_t c) {
+  switch (c) {
+  case '\n':
+    newline();
+    return;
+  case '\r':
+    g_col = 0;
+    return;
+  case '\b':
+    if (g_col) g_col--;
+    return;
+  case '\t':
+    do put_ascii(' ');
+    while (g_col & 7);
+    return;
+  }
+  if (g_col == FB_COLS) newline();
+  g_cells[g_row][g_col++] = c;
+  g_dirty[g_row] = 1;
+  g_any_dirty = true;
+}
+
+static void put_byte(uint8_t b) {
+  if (b < 0x80) {
+    g_cp_need = 0;
+    put_ascii(b);
+    return;
+  }
+  if ((b & 0xC0) == 0x80) { /* kontynuacja */
+    if (!g_cp_need) return;
+    g_cp = (g_cp << 6) | (b & 0x3F);
+    if (--g_cp_need) return;
+    char a = '?';
+    for (unsigned i = 0; i < sizeof(g_translit) / sizeof(g_translit[0]); i++)
+      if (g_translit[i].cp == g_cp) a = g_translit[i].ascii;
+    put_ascii((uint8_t)a);
+    return;
+  }
+  if ((b & 0xE0) == 0xC0) { g_cp = b & 0x1F; g_cp_need = 1; }
+  else if ((b & 0xF0) == 0xE0) { g_cp = b & 0x0F; g_cp_need = 2; }
+  else { g_cp = b & 0x07; g_cp_need = 3; }
+}
+
+static void fbcon_write(ksink_t *s, const char *buf, size_t n) {
+  (void)s;
+  uint32_t fl = irq_save();
+  for (size_t i = 0; i < n; i++) put_byte((uint8_t)buf[i]);
+  irq_restore(fl);
+  if (ktime_ns() - g_last_flush > FB_FLUSH_NS) fbcon_flush();
+}
+
+ksink_t g_ksink_fbcon = {fbcon_write, NULL};
+
+bool fbcon_init(void) {
+  uint16_t id = bga_read(BGA_REG_ID);
+  if (id < BGA_ID_MIN || id > BGA_ID_MAX) return false;
+
+  pci_addr_t pa;
+  g_phys = pci_find(BGA_PCI_VENDOR, BGA_PCI_DEVICE, &pa) ? pci_bar_mem(&pa, 0)
+                                                         : BGA_DEFAULT_LFB;
+  if (!g_phys) return false;
+
+  bga_write(BGA_REG_ENABLE, 0);
+  bga_write(BGA_REG_XRES, FB_WIDTH);
+  bga_write(BGA_REG_YRES, FB_HEIGHT);
+  bga_write(BGA_REG_BPP, 32);
+  bga_write(BGA_REG_ENABLE, BGA_ENABLED | BGA_LFB);
+
+  uint32_t wc = paging_wc_flags();
+  g_wc = !(wc & PG_PCD);
+  paging_map_range(g_phys, FB_VIRT, FB_WIDTH * FB_HEIGHT * 4, PG_RW | wc);
+  g_fb = (volatile uint32_t *)FB_VIRT;
+
+  memset((void *)g_fb, 0, FB_WIDTH * FB_HEIGHT * 4);
+  memset(g_cells, ' ', sizeof(g_cells));
+  memset(g_shown, ' ', sizeof(g_shown));
+  g_col = g_row = 0;
+  kprintf_add_sink(&g_ksink_fbcon);
+  return true;
+}
+
+bool fbcon_present(void) { return g_fb != NULL; }
+
+void fbcon_get_stats(fbcon_stats_t *out) {
+  out->phys = g_phys;
+  out->wc = g_wc;
+  out->flushes = g_flushes;
+  out->glyphs = g_glyphs;
+  out->scrolls = g_scrolls;
+}
+
+static const uint8_t g_font[95][8] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* ' ' */
+    {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, /* '!' */
+    {0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* '"' */
+    {0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00}, /* '#' */
+    {0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00}, /* '$' */
+    {0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00}, /* '%' */
+    {0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00}, /* '&' */
+    {0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00}, /* '\'' */
+    {0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00}, /* '(' */
+    {0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00}, /* ')' */
+    {0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00}, /* '*' */
+    {0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00}, /* '+' */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06}, /* ',' */
+    {0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00}, /* '-' */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00}, /* '.' */
+    {0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00}, /* '/' */
+    {0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00}, /* '0' */
+    {0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00}, /* '1' */
+    {0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00}, /* '2' */
+    {0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00}, /* '3' */
+    {0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00}, /* '4' */
+    {0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00}, /* '5' */
+    {0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00}, /* '6' */
+    {0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00}, /* '7' */
+    {0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00}, /* '8' */
+    {0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00}, /* '9' */
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00}, /* ':' */
+    {0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06}, /* ';' */
+    {0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00}, /* '<' */
+    {0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00}, /* '=' */
+    {0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00}, /* '>' */
+    {0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00}, /* '?' */
+    {0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00}, /* '@' */
+    {0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00}, /* 'A' */
+    {0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00}, /* 'B' */
+    {0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00}, /* 'C' */
+    {0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00}, /* 'D' */
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00}, /* 'E' */
+    {0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00}, /* 'F' */
+    {0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00}, /* 'G' */
+    {0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00}, /* 'H' */
+    {0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* 'I' */
+    {0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00}, /* 'J' */
+    {0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00}, /* 'K' */
+    {0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00}, /* 'L' */
+    {0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00}, /* 'M' */
+    {0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00}, /* 'N' */
+    {0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00}, /* 'O' */
+    {0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00}, /* 'P' */
+    {0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00}, /* 'Q' */
+    {0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00}, /* 'R' */
+    {0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00}, /* 'S' */
+    {0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* 'T' */
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00}, /* 'U' */
+    {0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, /* 'V' */
+    {0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00}, /* 'W' */
+    {0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00}, /* 'X' */
+    {0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00}, /* 'Y' */
+    {0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00}, /* 'Z' */
+    {0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00}, /* '[' */
+    {0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00}, /* '\\' */
+    {0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00}, /* ']' */
+    {0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00}, /* '^' */
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, /* '_' */
+    {0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00}, /* '`' */
+    {0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00}, /* 'a' */
+    {0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00}, /* 'b' */
+    {0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00}, /* 'c' */
+    {0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00}, /* 'd' */
+    {0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00}, /* 'e' */
+    {0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00}, /* 'f' */
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F}, /* 'g' */
+    {0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00}, /* 'h' */
+    {0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* 'i' */
+    {0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E}, /* 'j' */
+    {0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00}, /* 'k' */
+    {0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00}, /* 'l' */
+    {0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00}, /* 'm' */
+    {0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00}, /* 'n' */
+    {0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00}, /* 'o' */
+    {0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F}, /* 'p' */
+    {0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78}, /* 'q' */
+    {0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00}, /* 'r' */
+    {0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00}, /* 's' */
+    {0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00}, /* 't' */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00}, /* 'u' */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00}, /* 'v' */
+    {0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00}, /* 'w' */
+    {0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00}, /* 'x' */
+    {0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F}, /* 'y' */
+    {0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00}, /* 'z' */
+    {0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00}, /* '{' */
+    {0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00}, /* '|' */
+    {0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00}, /* '}' */
+    {0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, /* '~' */
+};
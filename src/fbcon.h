@@ -0,0 +1,70 @@
+/*
+ * [Cygnus] - [src/fbcon.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_FBCON_H
+#define CYGNUS_FBCON_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../inc/std.h"
+
+/* Konsola tekstowa na liniowym framebufferze Bochs/QEMU (BGA, std VGA).
+ *
+ * Tekst trzymamy w siatce znaków; przewijanie to memmove tej siatki
+ * (kilka KiB), a nie pikseli. Na ekran trafiają tylko komórki, które
+ * różnią się od tego, co już na nim jest – rysujemy je partiami przy
+ * fbcon_flush (z hooka bezczynności albo co FB_FLUSH_NS w trakcie
+ * długiego wypisywania). VRAM jest mapowany z write-combining (PAT) i
+ * tylko do niego piszemy, nigdy z niego nie czytamy.
+ */
+
+#define FB_WIDTH 1024
+#define FB_HEIGHT 768
+#define FB_GLYPH_W 8
+#define FB_GLYPH_H 16 /* font 8x8 z podwojonymi wierszami */
+#define FB_COLS (FB_WIDTH / FB_GLYPH_W)
+#define FB_ROWS (FB_HEIGHT / FB_GLYPH_H)
+
+/* adres wirtualny VRAM – poza oknem VM i oknem bench vmap */
+#define FB_VIRT 0xE0000000u
+
+typedef struct {
+  uint32_t phys;      /* BAR0 */
+  bool wc;            /* zmapowany z write-combining */
+  uint32_t flushes;   /* przerysowań */
+  uint32_t glyphs;    /* narysowanych komórek */
+  uint32_t scrolls;   /* przewinięć o wiersz */
+} fbcon_stats_t;
+
+/* Wykrywa BGA, ustawia FB_WIDTH x FB_HEIGHT x 32, mapuje VRAM i podpina
+ * konsolę pod kprintf. false, gdy karty nie ma. Po vm_init/paging. */
+bool fbcon_init(void);
+bool fbcon_present(void);
+
+/* Rysuje zaległe zmiany. */
+void fbcon_flush(void);
+/* Hook bezczynności: true, jeżeli było co rysować. */
+bool fbcon_idle(void);
+
+void fbcon_get_stats(fbcon_stats_t *out);
+
+extern ksink_t g_ksink_fbcon;
+
+#endif /* CYGNUS_FBCON_H */
@@ -0,0 +1,54 @@
+/*
+ * [Cygnus] - [src/fpu.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "fpu.h"
+#include "cpu.h"
+#include "idt.h"
+#include <stdint.h>
+
+#define CR0_MP (1u << 1)
+#define CR0_EM (1u << 2)
+#define CR0_TS (1u << 3)
+#define CR0_NE (1u << 5)
+#define CR4_OSFXSR (1u << 9)
+#define CR4_OSXMMEXCPT (1u << 10)
+
+static bool g_sse2;
+
+void fpu_init(void) {
+  uint32_t cr0, cr4, a, b, c, d;
+  __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+  cr0 &= ~(CR0_EM | CR0_TS);
+  cr0 |= CR0_MP | CR0_NE;
+  __asm__ volatile("mov %0, %%cr0" ::"r"(cr0));
+  __asm__ volatile("fninit");
+
+  cpuid(1, &a, &b, &c, &d);
+  if ((d & CPUID_EDX_FXSR) && (d & CPUID_EDX_SSE2)) {
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_OSFXSR | CR4_OSXMMEXCPT;
+    __asm__ volatile("mov %0, %%cr4" ::"r"(cr4));
+    g_sse2 = true;
+  }
+}
+
+bool fpu_has_sse2(void) { return g_sse2; }
+
+bool fpu_simd_usable(void) { return g_sse2 && idt_isr_depth() == 0; }
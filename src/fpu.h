@@ -0,0 +1,48 @@
+/*
+ * [Cygnus] - [src/fpu.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_FPU_H
+#define CYGNUS_FPU_H
+
+#include <stdbool.h>
+
+/* FPU/SSE w jądrze.
+ *
+ * fpu_init ustawia CR0 (MP=1, EM=0, TS=0, NE=1), robi fninit i – gdy CPU ma
+ * FXSR i SSE2 – włącza CR4.OSFXSR/OSXMMEXCPT, bez których każda instrukcja
+ * SSE kończy się #UD.
+ *
+ * Nie mamy procesów ani przełączania kontekstu, więc rejestrów XMM używa
+ * tylko kod jądra. Jedyny konflikt to przerwanie w środku pętli SIMD:
+ * obsługa przerwania, która sama sięgnęłaby po XMM, nadpisałaby stan
+ * przerwanego kodu. Zamiast zapisywać stan (fxsave) przy każdym wejściu,
+ * w przerwaniu po prostu nie używamy SIMD – fpu_simd_usable() zwraca wtedy
+ * false i memcpy/memset wybierają rep movsd/stosd.
+ */
+
+void fpu_init(void);
+
+/* CPU ma SSE2 i włączyliśmy je w CR4. */
+bool fpu_has_sse2(void);
+
+/* Można teraz użyć rejestrów XMM (SSE2 włączone, nie jesteśmy w ISR). */
+bool fpu_simd_usable(void);
+
+#endif /* CYGNUS_FPU_H */
@@ -0,0 +1,38 @@
+/*
+ * [Cygnus] - [src/idle.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "idle.h"
+#include <stddef.h>
+
+static idle_fn g_hooks[IDLE_MAX_HOOKS];
+static int g_nhooks = 0;
+
+int idle_register(idle_fn fn) {
+    if (g_nhooks >= IDLE_MAX_HOOKS) return -1;
+    g_hooks[g_nhooks++] = fn;
+    return 0;
+}
+
+bool idle_run(void) {
+    bool worked = false;
+    for (int i = 0; i < g_nhooks; i++)
+        if (g_hooks[i]()) worked = true;
+    return worked;
+}
@@ -0,0 +1,39 @@
+/*
+ * [Cygnus] - [src/idle.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_IDLE_H
+#define CYGNUS_IDLE_H
+
+#include <stdbool.h>
+
+/* Praca w tle wykonywana, gdy jądro nie ma nic lepszego do roboty
+ * (na razie: powłoka czeka na znak z UART). Każda funkcja robi krótki
+ * kawałek pracy i zwraca true, jeżeli coś zrobiła. */
+typedef bool (*idle_fn)(void);
+
+#define IDLE_MAX_HOOKS 8
+
+/* Zwraca 0 gdy OK, -1 gdy tablica jest pełna. */
+int idle_register(idle_fn fn);
+
+/* Jedno przejście po wszystkich funkcjach; true, jeżeli któraś pracowała. */
+bool idle_run(void);
+
+#endif /* CYGNUS_IDLE_H */
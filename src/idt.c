@@ -0,0 +1,122 @@
+/*
+ * [Cygnus] - [src/idt.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "idt.h"
+#include "klog.h"
+#include "../inc/std.h"
+
+/* ===== GDT =====
+ * Multiboot nie gwarantuje, że GDT bootloadera przeżyje start jądra, a
+ * każde przerwanie ładuje CS z IDT – dlatego mamy własne: null, kod, dane. */
+typedef struct __attribute__((packed)) {
+  uint16_t limit_lo, base_lo;
+  uint8_t base_mid, access, gran, base_hi;
+} gdt_entry_t;
+
+typedef struct __attribute__((packed)) {
+  uint16_t limit;
+  uint32_t base;
+} dt_ptr_t;
+
+static gdt_entry_t g_gdt[3] = {
+    {0, 0, 0, 0, 0, 0},
+    {0xFFFF, 0, 0, 0x9A, 0xCF, 0}, /* kod ring 0, 4 GiB */
+    {0xFFFF, 0, 0, 0x92, 0xCF, 0}, /* dane ring 0, 4 GiB */
+};
+
+static void gdt_load(void) {
+  dt_ptr_t p = {sizeof(g_gdt) - 1, (uint32_t)g_gdt};
+  __asm__ volatile("lgdt %0\n\t"
+                   "mov %1, %%ds\n\t"
+                   "mov %1, %%es\n\t"
+                   "mov %1, %%fs\n\t"
+                   "mov %1, %%gs\n\t"
+                   "mov %1, %%ss\n\t"
+                   "ljmp %2, $1f\n"
+                   "1:"
+                   :
+                   : "m"(p), "r"((uint32_t)GDT_KERNEL_DS), "i"(GDT_KERNEL_CS)
+                   : "memory");
+}
+
+/* ===== IDT ===== */
+typedef struct __attribute__((packed)) {
+  uint16_t off_lo, sel;
+  uint8_t zero, type;
+  uint16_t off_hi;
+} idt_entry_t;
+
+extern char isr_stubs[]; /* isr.s: 256 stubów po 16 B */
+
+static idt_entry_t g_idt[IDT_VECTORS] __attribute__((aligned(8)));
+static isr_handler_fn g_handlers[IDT_VECTORS];
+static uint32_t g_counts[IDT_VECTORS];
+static volatile uint32_t g_depth;
+
+static const char *const g_exc_names[32] = {
+    "dzielenie przez zero", "debug", "NMI", "breakpoint", "overflow",
+    "bound", "nieprawidłowa instrukcja", "brak FPU", "double fault",
+    "coprocessor segment", "zły TSS", "brak segmentu", "błąd stosu",
+    "general protection", "page fault", "15", "błąd x87", "alignment check",
+    "machine check", "błąd SIMD", "virtualization", "control protection"};
+
+void idt_init(void) {
+  gdt_load();
+  for (unsigned v = 0; v < IDT_VECTORS; v++) {
+    uint32_t off = (uint32_t)(isr_stubs + 16 * v);
+    g_idt[v].off_lo = (uint16_t)off;
+    g_idt[v].off_hi = (uint16_t)(off >> 16);
+    g_idt[v].sel = GDT_KERNEL_CS;
+    g_idt[v].zero = 0;
+    g_idt[v].type = 0x8E; /* obecna, ring 0, 32-bit interrupt gate */
+  }
+  dt_ptr_t p = {sizeof(g_idt) - 1, (uint32_t)g_idt};
+  __asm__ volatile("lidt %0" ::"m"(p) : "memory");
+}
+
+void idt_set_handler(uint8_t vector, isr_handler_fn fn) {
+  g_handlers[vector] = fn;
+}
+
+uint32_t idt_count(uint8_t vector) { return g_counts[vector]; }
+
+uint32_t idt_isr_depth(void) { return g_depth; }
+
+void isr_dispatch(isr_frame_t *frame) {
+  uint32_t v = frame->vector & 0xFFu;
+  g_counts[v]++;
+  if (g_handlers[v]) {
+    g_depth++;
+    g_handlers[v](frame);
+    g_depth--;
+    return;
+  }
+  if (v >= 32) return; /* niespodziewane przerwanie – ignorujemy */
+
+  klog_flush(); /* to, co czekało w logu, zanim stanie wszystko */
+  const char *name = (v < sizeof(g_exc_names) / sizeof(g_exc_names[0]) &&
+                      g_exc_names[v]) ? g_exc_names[v] : "zarezerwowany";
+  kprintf("\n[PANIC] Wyjątek %u (%s), kod=%x, eip=%x, eflags=%x\n", v, name,
+          frame->err, frame->eip, frame->eflags);
+  kprintf("eax=%x ebx=%x ecx=%x edx=%x esi=%x edi=%x ebp=%x\n", frame->eax,
+          frame->ebx, frame->ecx, frame->edx, frame->esi, frame->edi,
+          frame->ebp);
+  for (;;) __asm__ volatile("cli; hlt");
+}
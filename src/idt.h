@@ -0,0 +1,68 @@
+/*
+ * [Cygnus] - [src/idt.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_IDT_H
+#define CYGNUS_IDT_H
+
+#include <stdint.h>
+
+/* Własne GDT (płaskie segmenty 0x08/0x10) i IDT na wszystkie 256 wektorów.
+ *
+ * Każdy wektor ma krótki stub w src/isr.s, który odkłada numer wektora
+ * (i zero, gdy CPU nie podaje kodu błędu), zapisuje rejestry i woła
+ * isr_dispatch. Stamtąd trafiamy do funkcji zarejestrowanej dla wektora;
+ * nieobsłużony wyjątek (0..31) wypisuje stan i zatrzymuje jądro.
+ */
+
+#define IDT_VECTORS 256
+#define GDT_KERNEL_CS 0x08
+#define GDT_KERNEL_DS 0x10
+
+/* wyjątki, które obsługujemy z nazwy */
+#define VEC_DIVIDE 0
+#define VEC_GP 13
+#define VEC_PAGE_FAULT 14
+
+/* Ramka na stosie przy wejściu do isr_dispatch (kolejność jak w isr.s). */
+typedef struct {
+  uint32_t edi, esi, ebp, esp_dummy, ebx, edx, ecx, eax; /* pushal */
+  uint32_t vector;
+  uint32_t err;                                          /* 0, gdy brak */
+  uint32_t eip, cs, eflags;                              /* od CPU */
+} isr_frame_t;
+
+typedef void (*isr_handler_fn)(isr_frame_t *frame);
+
+/* Ładuje GDT i IDT. Przerwania zostają wyłączone (cli z boot.s). */
+void idt_init(void);
+
+/* Rejestruje obsługę wektora (NULL = domyślna). */
+void idt_set_handler(uint8_t vector, isr_handler_fn fn);
+
+/* Licznik wejść do danego wektora. */
+uint32_t idt_count(uint8_t vector);
+
+/* > 0, gdy jesteśmy wewnątrz obsługi przerwania/wyjątku. */
+uint32_t idt_isr_depth(void);
+
+/* Wołane z isr.s. */
+void isr_dispatch(isr_frame_t *frame);
+
+#endif /* CYGNUS_IDT_H */
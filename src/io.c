@@ -111,18 +111,56 @@ int ata_write_sector(uint32_t lba, const uint8_t* buffer) {
     return ata_flush_cache();
 }
 
-/* Odczyt wielu sektorów (prosto: wywołujemy single-sector w pętli).
- * Jeżeli chcemy kiedyś wydajniej: możemy użyć komend multiblokowych lub DMA. */
+/* Ustawia licznik sektorów i LBA, wysyła komendę (n=256 kodujemy jako 0). */
+static void ata_issue_lba28(uint32_t lba, uint32_t n, uint8_t cmd) {
+    ata_select_drive_lba28(lba);
+    outb(ATA_PRIMARY_IO + ATA_REG_SECCNT, (uint8_t)(n & 0xFF));
+    outb(ATA_PRIMARY_IO + ATA_REG_LBA0, (uint8_t)(lba & 0xFF));
+    outb(ATA_PRIMARY_IO + ATA_REG_LBA1, (uint8_t)((lba >> 8) & 0xFF));
+    outb(ATA_PRIMARY_IO + ATA_REG_LBA2, (uint8_t)((lba >> 16) & 0xFF));
+    outb(ATA_PRIMARY_IO + ATA_REG_COMMAND, cmd);
+}
+
+/* Odczyt wielu sektorów: jedna komenda READ SECTORS na max 256 sektorów,
+ * potem dla każdego sektora czekamy na DRQ i zbieramy 256 słów naraz. */
 int ata_read_n(uint32_t lba, uint32_t count, void* buffer) {
     uint8_t* p = (uint8_t*)buffer;
-    for (uint32_t i = 0; i < count; i++) {
-        if (ata_read_sector(lba + i, p + i * CYG_SECTOR_SIZE) != 0) {
-            return -1;
+    while (count) {
+        uint32_t n = count > 256 ? 256 : count;
+        ata_issue_lba28(lba, n, ATA_CMD_READ_SECTORS);
+        for (uint32_t i = 0; i < n; i++) {
+            ata_wait_not_bsy();
+            if (ata_wait_drq_or_err() != 0) return -1;
+            insw(ATA_PRIMARY_IO + ATA_REG_DATA, p, CYG_SECTOR_SIZE / 2);
+            p += CYG_SECTOR_SIZE;
         }
+        io_wait();
+        lba += n;
+        count -= n;
     }
     return 0;
 }
 
+/* Zapis wielu sektorów: WRITE SECTORS na max 256 sektorów, flush na końcu. */
+int ata_write_n(uint32_t lba, uint32_t count, const void* buffer) {
+    const uint8_t* p = (const uint8_t*)buffer;
+    while (count) {
+        uint32_t n = count > 256 ? 256 : count;
+        ata_issue_lba28(lba, n, ATA_CMD_WRITE_SECTORS);
+        for (uint32_t i = 0; i < n; i++) {
+            ata_wait_not_bsy();
+            if (ata_wait_drq_or_err() != 0) return -1;
+            outsw(ATA_PRIMARY_IO + ATA_REG_DATA, p, CYG_SECTOR_SIZE / 2);
+            p += CYG_SECTOR_SIZE;
+        }
+        io_wait();
+        lba += n;
+        count -= n;
+    }
+    ata_wait_not_bsy();
+    return ata_flush_cache();
+}
+
 /* Flush cache (E7h). Niektóre emulatory i tak przyjmą OK, ale wyślijmy,
  * żeby być poprawni. */
 int ata_flush_cache(void) {
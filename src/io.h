@@ -44,6 +44,28 @@ static inline uint16_t inw(uint16_t port) {
     return ret;
 }
 
+static inline void outl(uint16_t port, uint32_t val) {
+    __asm__ volatile ("outl %0, %1" : : "a"(val), "Nd"(port));
+}
+static inline uint32_t inl(uint16_t port) {
+    uint32_t ret;
+    __asm__ volatile ("inl %1, %0" : "=a"(ret) : "Nd"(port));
+    return ret;
+}
+
+/* Blokowe przesłanie słów 16-bit (rep insw/outsw) – dane sektora ATA. */
+static inline void insw(uint16_t port, void* buf, uint32_t count) {
+    __asm__ volatile ("rep insw" : "+D"(buf), "+c"(count) : "d"(port) : "memory");
+}
+static inline void outsw(uint16_t port, const void* buf, uint32_t count) {
+    __asm__ volatile ("rep outsw" : "+S"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
+/* Blokowe wypisanie bajtów (rep outsb) – np. port debugcon 0xE9. */
+static inline void outsb(uint16_t port, const void* buf, uint32_t count) {
+    __asm__ volatile ("rep outsb" : "+S"(buf), "+c"(count) : "d"(port) : "memory");
+}
+
 /* 400 ns opóźnienia dla niektórych kontrolerów ATA — klasyczny hack:
  * odczyt z „portu opóźniającego” 0x80 kilka razy. */
 static inline void io_wait(void) {
@@ -98,9 +120,13 @@ int ata_read_sector(uint32_t lba, uint8_t* buffer);
 /* Zapis 1 sektora (512 B) z bufora do LBA. Zwraca 0 gdy OK. */
 int ata_write_sector(uint32_t lba, const uint8_t* buffer);
 
-/* Odczyt wielu sektorów w pętli. Zwraca 0 gdy OK. */
+/* Odczyt wielu kolejnych sektorów (komendy po max 256 sektorów).
+ * Zwraca 0 gdy OK. */
 int ata_read_n(uint32_t lba, uint32_t count, void* buffer);
 
+/* Zapis wielu kolejnych sektorów, flush cache na końcu. Zwraca 0 gdy OK. */
+int ata_write_n(uint32_t lba, uint32_t count, const void* buffer);
+
 /* Flush cache dysku (dobry zwyczaj po serii zapisów). */
 int ata_flush_cache(void);
 
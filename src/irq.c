@@ -0,0 +1,173 @@
+/*
+ * [Cygnus] - [src/irq.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "irq.h"
+#include "apic.h"
+#include "cpu.h"
+#include "idt.h"
+#include "io.h"
+
+/* porty 8259 */
+#define PIC1_CMD 0x20
+#define PIC1_DATA 0x21
+#define PIC2_CMD 0xA0
+#define PIC2_DATA 0xA1
+
+#define PIC_EOI 0x20
+#define PIC_READ_ISR 0x0B
+#define ICW1_INIT 0x11  /* ICW4 będzie, kaskada, zbocze */
+#define ICW4_8086 0x01
+
+#define IRQ_CASCADE 2
+
+typedef struct {
+  irq_handler_fn fn;
+  const char *name;
+  uint32_t count;
+  uint32_t max_cycles;
+  uint64_t cycles;
+} irq_line_t;
+
+static irq_line_t g_lines[IRQ_LINES];
+static uint32_t g_spurious;
+static bool g_apic;
+
+static uint16_t pic_isr(void) {
+  outb(PIC1_CMD, PIC_READ_ISR);
+  outb(PIC2_CMD, PIC_READ_ISR);
+  return (uint16_t)(inb(PIC1_CMD) | (inb(PIC2_CMD) << 8));
+}
+
+static void pic_eoi(uint8_t irq) {
+  if (irq >= 8) outb(PIC2_CMD, PIC_EOI);
+  outb(PIC1_CMD, PIC_EOI);
+}
+
+static void irq_entry(isr_frame_t *frame) {
+  uint8_t irq = (uint8_t)(frame->vector - IRQ_BASE);
+  irq_line_t *l = &g_lines[irq & (IRQ_LINES - 1)];
+
+  /* fałszywe IRQ7/15: linia opadła przed INTA. Slave'owe potwierdzamy
+   * tylko na masterze (kaskada naprawdę była w obsłudze). IOAPIC ma
+   * na to osobny wektor (apic.c). */
+  if (!g_apic && (irq == 7 || irq == 15) && !(pic_isr() & (1u << irq))) {
+    g_spurious++;
+    if (irq == 15) outb(PIC1_CMD, PIC_EOI);
+    return;
+  }
+  l->count++;
+  if (l->fn) {
+    uint64_t t0 = rdtsc();
+    l->fn();
+    uint32_t dt = (uint32_t)(rdtsc() - t0);
+    l->cycles += dt;
+    if (dt > l->max_cycles) l->max_cycles = dt;
+  }
+  if (g_apic) apic_eoi();
+  else pic_eoi(irq);
+}
+
+void irq_init(void) {
+  outb(PIC1_CMD, ICW1_INIT);
+  io_wait();
+  outb(PIC2_CMD, ICW1_INIT);
+  io_wait();
+  outb(PIC1_DATA, IRQ_BASE);           /* ICW2: wektory master */
+  io_wait();
+  outb(PIC2_DATA, IRQ_BASE + 8);       /* ICW2: wektory slave */
+  io_wait();
+  outb(PIC1_DATA, 1u << IRQ_CASCADE);  /* ICW3: slave na IRQ2 */
+  io_wait();
+  outb(PIC2_DATA, IRQ_CASCADE);
+  io_wait();
+  outb(PIC1_DATA, ICW4_8086);
+  io_wait();
+  outb(PIC2_DATA, ICW4_8086);
+  io_wait();
+
+  /* wszystko zamaskowane poza kaskadą */
+  outb(PIC1_DATA, (uint8_t)~(1u << IRQ_CASCADE));
+  outb(PIC2_DATA, 0xFF);
+
+  for (unsigned i = 0; i < IRQ_LINES; i++)
+    idt_set_handler((uint8_t)(IRQ_BASE + i), irq_entry);
+}
+
+void irq_mask(uint8_t irq) {
+  if (g_apic) {
+    apic_route(irq, (uint8_t)(IRQ_BASE + irq), true);
+    return;
+  }
+  uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+  outb(port, (uint8_t)(inb(port) | (1u << (irq & 7))));
+}
+
+void irq_unmask(uint8_t irq) {
+  if (g_apic) {
+    apic_route(irq, (uint8_t)(IRQ_BASE + irq), false);
+    return;
+  }
+  uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+  outb(port, (uint8_t)(inb(port) & ~(1u << (irq & 7))));
+}
+
+void irq_register(uint8_t irq, irq_handler_fn fn, const char *name) {
+  if (irq >= IRQ_LINES || irq == IRQ_CASCADE) return;
+  g_lines[irq].fn = fn;
+  g_lines[irq].name = fn ? name : NULL;
+  if (fn) irq_unmask(irq);
+  else irq_mask(irq);
+}
+
+bool irq_use_apic(void) {
+#ifdef CYGNUS_NO_APIC
+  return false;
+#else
+  if (g_apic || !apic_detect()) return g_apic;
+  uint32_t fl = irq_save();
+  apic_enable();
+  /* 8259 maskujemy całkiem – odtąd przerwania idą tylko z IOAPIC-a */
+  outb(PIC1_DATA, 0xFF);
+  outb(PIC2_DATA, 0xFF);
+  g_apic = true;
+  for (uint8_t i = 0; i < IRQ_LINES; i++)
+    if (g_lines[i].fn) irq_unmask(i);
+  irq_restore(fl);
+  return true;
+#endif
+}
+
+const char *irq_controller(void) { return g_apic ? "IOAPIC" : "8259"; }
+
+uint32_t irq_count(uint8_t irq) {
+  return irq < IRQ_LINES ? g_lines[irq].count : 0;
+}
+
+uint32_t irq_spurious(void) { return g_spurious; }
+
+void irq_get_stats(uint8_t irq, irq_stats_t *out) {
+  irq_line_t *l = &g_lines[irq & (IRQ_LINES - 1)];
+  uint32_t fl = irq_save();
+  out->name = l->name;
+  out->count = l->count;
+  out->cycles = l->cycles;
+  out->max_cycles = l->max_cycles;
+  irq_restore(fl);
+}
@@ -0,0 +1,79 @@
+/*
+ * [Cygnus] - [src/irq.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_IRQ_H
+#define CYGNUS_IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Przerwania sprzętowe przez 8259 (master + slave), a po irq_use_apic
+ * przez IOAPIC i lokalny APIC (apic.h), jeżeli są.
+ *
+ * IRQ 0..15 przesuwamy na wektory IRQ_BASE..IRQ_BASE+15, żeby nie
+ * nachodziły na wyjątki CPU. Na start wszystkie linie są zamaskowane;
+ * irq_register odmaskowuje linię dopiero, gdy ktoś ją obsługuje. EOI
+ * wysyłamy sami po powrocie z funkcji obsługi, fałszywe IRQ7/IRQ15
+ * (bit w ISR nieustawiony) odrzucamy bez wołania sterownika.
+ *
+ * Każda linia to jeden wpis tablicy (funkcja, nazwa, liczniki), więc
+ * wejście z wektora to indeks i jedno wywołanie pośrednie. Czas obsługi
+ * (cykle TSC) liczymy na linię – pokazuje go komenda `irq`.
+ */
+
+#define IRQ_BASE 32
+#define IRQ_LINES 16
+
+#define IRQ_COM1 4
+
+typedef void (*irq_handler_fn)(void);
+
+typedef struct {
+  const char *name;    /* NULL – linia wolna */
+  uint32_t count;
+  uint64_t cycles;     /* łącznie w funkcji obsługi */
+  uint32_t max_cycles; /* najdłuższa pojedyncza obsługa */
+} irq_stats_t;
+
+/* Remapuje oba PIC-e i maskuje wszystkie linie. Po idt_init. */
+void irq_init(void);
+
+/* Przenosi linie na IOAPIC/LAPIC, jeżeli są (apic_detect), i wyłącza
+ * 8259. Już podpięte linie zostają odmaskowane. Po paging_enable.
+ * Zwraca true, gdy przeszliśmy na APIC. */
+bool irq_use_apic(void);
+
+/* "8259" albo "IOAPIC" */
+const char *irq_controller(void);
+
+/* Podpina obsługę linii i ją odmaskowuje (NULL = odpina i maskuje).
+ * 'name' – do statystyk (komenda irq). */
+void irq_register(uint8_t irq, irq_handler_fn fn, const char *name);
+
+void irq_mask(uint8_t irq);
+void irq_unmask(uint8_t irq);
+
+/* Ile razy przyszło IRQ z danej linii / ile było fałszywych. */
+uint32_t irq_count(uint8_t irq);
+uint32_t irq_spurious(void);
+
+void irq_get_stats(uint8_t irq, irq_stats_t *out);
+
+#endif /* CYGNUS_IRQ_H */
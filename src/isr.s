@@ -0,0 +1,54 @@
+#
+# [Cygnus] - [src/isr.s]
+#
+# Copyright (C) [2025] [Szymon Grajner]
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+# soon as they will be approved by the European Commission - subsequent
+# versions of the EUPL (the "Licence").
+#
+# You may not use this work except in compliance with the Licence.
+# You may obtain a copy of the Licence at:
+# https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the Licence is distributed on an "AS IS" basis,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the Licence for the specific language governing permissions and
+# limitations under the Licence.
+#
+    .code32
+
+    /* ===== Stuby wektorów 0..255 =====
+     * Każdy zajmuje 16 bajtów (isr_stubs + 16 * wektor), więc idt.c liczy
+     * adresy zamiast trzymać tablicę 256 wskaźników. CPU odkłada kod błędu
+     * tylko dla 8, 10-14, 17, 21, 29, 30 – dla pozostałych wkładamy zero,
+     * żeby ramka zawsze wyglądała tak samo. */
+    .section .text
+    .globl isr_stubs
+    .align 16
+isr_stubs:
+    .set vec, 0
+    .rept 256
+    .align 16
+    .if !((vec == 8) || ((vec >= 10) && (vec <= 14)) || (vec == 17) || (vec == 21) || (vec == 29) || (vec == 30))
+    pushl $0
+    .endif
+    pushl $vec
+    jmp isr_common
+    .set vec, vec + 1
+    .endr
+
+    /* ===== Wspólna część: rejestry -> isr_dispatch(ramka) -> iret ===== */
+    .extern isr_dispatch
+isr_common:
+    pushal
+    cld
+    movl %esp, %eax
+    pushl %eax
+    call isr_dispatch
+    addl $4, %esp
+    popal
+    addl $8, %esp       /* wektor + kod błędu */
+    iret
@@ -22,6 +22,43 @@
 #include "../inc/std.h"
 #include "../inc/disk.h"
 #include "fat32.h"
+#include "paging.h"
+#include "pagecache.h"
+#include "fat32_defrag.h"
+#include "checksum.h"
+#include "fat32_aio.h"
+#include "idle.h"
+#include "bench.h"
+#include "multiboot.h"
+#include "kmalloc.h"
+#include "dma.h"
+#include "idt.h"
+#include "irq.h"
+#include "apic.h"
+#include "klog.h"
+#include "debugcon.h"
+#include "fbcon.h"
+#include "vcon.h"
+#include "fat16.h"
+#include "zxfer.h"
+#include "vm.h"
+#include "memstat.h"
+#include "fpu.h"
+#include "ktime.h"
+#include <string.h>
+
+/* Górna granica RAM, gdy bootloader nie dał mapy pamięci */
+#ifndef CYGNUS_MEM_TOP
+#define CYGNUS_MEM_TOP (32u * 1024 * 1024)
+#endif
+
+/* Cache stron plików może zająć 1/N wolnych ramek po starcie */
+#ifndef CYGNUS_PCACHE_SHARE
+#define CYGNUS_PCACHE_SHARE 4u
+#endif
+
+/* Granice obrazu jądra z linker.ld */
+extern uint8_t _kernel_start[], _kernel_end[];
 
 /* Globalnie: urządzenie blokowe i wolumin FAT32 */
 static fat32_volume_t g_vol;
@@ -45,37 +82,102 @@ static int starts_with(const char* s, const char* prefix) {
     }
     return 1;
 }
+/* czy łańcuch kończy się danym sufiksem (bez rozróżniania wielkości liter) */
+static int ends_with_ci(const char* s, const char* suffix) {
+    int n = 0, m = 0;
+    while (s[n]) n++;
+    while (suffix[m]) m++;
+    if (m > n) return 0;
+    for (int i = 0; i < m; i++) {
+        char a = s[n - m + i], b = suffix[i];
+        if (a >= 'A' && a <= 'Z') a += 32;
+        if (b >= 'A' && b <= 'Z') b += 32;
+        if (a != b) return 0;
+    }
+    return 1;
+}
 static const char* skip_ws(const char* s) {
     while (*s==' ' || *s=='\t') s++;
     return s;
 }
 
-/* prosta linia z UART (obsługa backspace), zawsze kończymy NUL-em */
+/* Wejście/wyjście powłoki: UART albo port virtio-console (komenda vcon).
+ * Wyjście kprintf idzie zawsze na UART, port dostaje je dodatkowo. */
+static int g_shell_port = -1;  /* -1 = UART */
+static int g_cat_port = -1;    /* cat na port virtio-console */
+
+static int shell_can_read(void) {
+    return g_shell_port < 0 ? serial_can_read() : vcon_can_read(g_shell_port);
+}
+static char shell_read(void) {
+    return g_shell_port < 0 ? serial_read() : vcon_read(g_shell_port);
+}
+static void shell_wait(void) {
+    if (g_shell_port < 0) serial_wait_rx(); else vcon_wait(g_shell_port);
+}
+static void shell_write(const char* s) {
+    if (g_shell_port < 0) { serial_write(s); return; }
+    vcon_write(g_shell_port, s, strlen(s));
+}
+
+/* prosta linia z konsoli (obsługa backspace), zawsze kończymy NUL-em */
 static void serial_getline(char* out, int cap) {
     int n = 0;
     for (;;) {
-        char c = serial_read();
-        if (c == '\r' || c == '\n') { serial_write("\r\n"); break; }
+        /* praca w tle, a gdy jej brak – śpimy do przerwania */
+        while (!shell_can_read()) if (!idle_run()) shell_wait();
+        char c = shell_read();
+        if (c == '\r' || c == '\n') { shell_write("\r\n"); break; }
         if ((c == 8 || c == 127)) {
-            if (n > 0) { n--; serial_write("\b \b"); }
+            if (n > 0) { n--; shell_write("\b \b"); }
             continue;
         }
-        if (n+1 < cap) { out[n++] = c; serial_write_char(c); }
+        if (n+1 < cap) {
+            out[n++] = c;
+            char e[2] = { c, 0 };
+            shell_write(e);
+        }
     }
     out[n] = 0;
 }
 
-/* wypis jednego wpisu katalogu – unikamy %10u/%u */
+/* Dysk RAM (fat16.c) widzimy pod /ram; zwraca ścieżkę w jego obrębie
+ * albo NULL dla ścieżek FAT32. */
+static const char* ram_path(const char* path) {
+    if (!starts_with(path, "/ram")) return NULL;
+    if (path[4] == 0) return "/";
+    return path[4] == '/' ? path + 4 : NULL;
+}
+
+/* wypis jednego wpisu katalogu – jedną linią, rozmiar wyrównany */
 static void print_dirent(const fat32_dirent_info_t* inf) {
-    kprintf("%c ", inf->is_dir ? 'd' : '-');
-    kprintf("%d  ", (int)inf->size);
-    kprintf("%s\n", inf->name);
+    kprintf("%c %10u  %s\n", inf->is_dir ? 'd' : '-', (unsigned)inf->size, inf->name);
 }
 
 /* ls dla ścieżki (albo root) */
 static void fs_ls(const char* path) {
     if (!path || !*path) path = "/";
 
+    const char* rp = ram_path(path);
+    if (rp) {
+        int dh = fat16_opendir(rp);
+        if (dh < 0) { kprintf("[ERR] ls: nie znaleziono: %s\n", path); return; }
+        char name[FAT16_MAX_NAME], full[2 * FAT16_MAX_NAME];
+        int is_dir;
+        while (fat16_readdir(dh, name, &is_dir) == 0) {
+            int size = 0;
+            if (!is_dir) {
+                ksnprintf(full, sizeof(full), "%s/%s", streq(rp, "/") ? "" : rp, name);
+                int fd = fat16_open(full, 0);
+                size = fat16_size(fd);
+                fat16_close(fd);
+            }
+            kprintf("%c %10u  %s\n", is_dir ? 'd' : '-', (unsigned)size, name);
+        }
+        fat16_closedir(dh);
+        return;
+    }
+
     fat32_file_t* f = NULL;
     int rc = fat32_open(&g_vol, path, &f);
     if (rc) {
@@ -106,28 +208,309 @@ static void fs_ls(const char* path) {
     fat32_readdir_close(it);
 }
 
-/* cat pliku (tekstowo; binarki też pokaże jako znaki) */
+/* cat pliku (tekstowo; binarki też pokaże jako znaki);
+ * pliki *.lz4 rozpakowujemy w locie */
 static void fs_cat(const char* path) {
     if (!path || !*path) { kprintf("Użycie: cat /ŚCIEŻKA\n"); return; }
 
+    /* wyjście: UART, debugcon (komenda e9) albo port virtio-console
+     * (komenda vcon) – całymi buforami */
+    ksink_t* out = &g_ksink_serial;
+    if (debugcon_routed() & DEBUGCON_CAT) out = &g_ksink_debugcon;
+    if (g_cat_port >= 0 && vcon_sink(g_cat_port)) out = vcon_sink(g_cat_port);
+    static uint8_t buf[4096];
+
+    const char* rp = ram_path(path);
+    if (rp) {
+        int fd = fat16_open(rp, 0);
+        if (fd < 0) { kprintf("[ERR] cat: nie znaleziono: %s\n", path); return; }
+        int n;
+        while ((n = fat16_read(fd, buf, sizeof(buf))) > 0) out->write(out, (const char*)buf, n);
+        fat16_close(fd);
+        if (out == &g_ksink_serial) serial_write("\r\n");
+        if (g_cat_port >= 0) vcon_flush(g_cat_port);
+        return;
+    }
+
     fat32_file_t* f = NULL;
-    int rc = fat32_open(&g_vol, path, &f);
+    uint32_t flags = ends_with_ci(path, ".lz4") ? FAT32_OPEN_LZ4 : 0;
+    int rc = fat32_open_ex(&g_vol, path, flags, &f);
     if (rc) { kprintf("[ERR] cat: nie znaleziono: %s (kod=%d)\n", path, rc); return; }
     if (f->is_dir) { kprintf("[ERR] cat: to katalog: %s\n", path); fat32_close(f); return; }
 
-    uint8_t buf[512];
     uint32_t got = 0;
     do {
         rc = fat32_read(f, buf, sizeof(buf), &got);
-        if (got) {
-            for (uint32_t i = 0; i < got; i++) serial_write_char((char)buf[i]);
-        }
+        if (got) out->write(out, (const char*)buf, got);
     } while (rc == 0 && got > 0);
 
-    serial_write("\r\n");
+    if (out == &g_ksink_serial) serial_write("\r\n");
+    if (g_cat_port >= 0) vcon_flush(g_cat_port);
     fat32_close(f);
 }
 
+/* statystyki cache stron; "cache drop" czyści cache */
+static void fs_cache(const char* arg) {
+    if (streq(arg, "drop")) {
+        pcache_drop_all();
+        kprintf("[OK] Cache stron wyczyszczony.\n");
+        return;
+    }
+    pcache_stats_t st;
+    pcache_get_stats(&st);
+    uint32_t total = st.hits + st.misses;
+    kprintf("strony: %u / %u (aktywne %u, nieaktywne %u), pliki: %u\n",
+            st.resident, st.limit, st.active, st.inactive, st.files);
+    kprintf("trafienia: %u, chybienia: %u, wymiecione: %u, trafność: %u%%\n",
+            st.hits, st.misses, st.evictions,
+            total ? (unsigned)((uint64_t)st.hits * 100 / total) : 0u);
+}
+
+/* frag [-v] – fragmentacja plików i wolnego miejsca */
+static void fs_frag(const char* arg) {
+    fat32_frag_stats_t st;
+    int rc = fat32_frag_report(&g_vol, streq(arg, "-v"), &st);
+    if (rc) { kprintf("[ERR] frag: kod=%d\n", rc); return; }
+    kprintf("pliki: %u (pofragmentowane %u), katalogi: %u\n",
+            st.files, st.fragmented, st.dirs);
+    kprintf("klastry plików: %u w %u ekstentach", st.clusters, st.extents);
+    if (st.files)
+        kprintf(" (%u.%u%u na plik)", st.extents / st.files,
+                st.extents * 10 / st.files % 10, st.extents * 100 / st.files % 10);
+    kprintf("\nwolne: %u klastrów w %u obszarach, największy %u\n",
+            st.free_clusters, st.free_extents, st.largest_free);
+}
+
+/* defrag [PATH] – cały wolumin albo jeden plik (z pomiarem odczytu) */
+static void fs_defrag(const char* path) {
+    if (!*path) {
+        uint32_t moved = 0, failed = 0;
+        int rc = fat32_defrag_all(&g_vol, &moved, &failed);
+        if (rc) kprintf("[ERR] defrag: kod=%d\n", rc);
+        kprintf("[OK] Przenieśliśmy %u plików (błędy: %u).\n", moved, failed);
+        return;
+    }
+
+    uint64_t b0, t0, b1, t1;
+    if (bench_read_file(&g_vol, path, 0, &b0, &t0)) return;
+    int rc = fat32_defrag_file(&g_vol, path);
+    if (rc == 1) { kprintf("[OK] %s jest już ciągły.\n", path); return; }
+    if (rc) { kprintf("[ERR] defrag %s: kod=%d\n", path, rc); return; }
+    if (bench_read_file(&g_vol, path, 0, &b1, &t1)) return;
+    bench_report("przed", b0, t0);
+    bench_report("po", b1, t1);
+}
+
+/* slab – zajętość cache sterty jądra */
+static void mem_slab(void) {
+    kprintf("cache            obiekt  zajęte/pojemność  slaby  alloc/free\n");
+    for (uint32_t i = 0; i < kmem_cache_count(); i++) {
+        kmem_cache_stats_t st;
+        kmem_cache_get_stats(i, &st);
+        kprintf("%s  %u B  %u/%u  %u  %u/%u\n", st.name, st.objsize, st.inuse,
+                st.total, st.slabs, st.allocs, st.frees);
+    }
+    kprintf("duże przydziały: %u stron\n", kmem_large_pages());
+}
+
+/* dma – pule pamięci DMA (tylko klasy, które były używane) */
+static void mem_dma(void) {
+    dma_stats_t st;
+    dma_get_stats(&st);
+    kprintf("ramki w pulach DMA: %u\n", st.frames);
+    kprintf("blok  wydane  w puli  przydziały  z PMM\n");
+    for (unsigned c = 0; c < DMA_CLASSES; c++) {
+        const dma_class_stats_t* cs = &st.cls[c];
+        if (!cs->allocs && !cs->cached) continue;
+        kprintf("%u  %u  %u  %u  %u\n", cs->size, cs->inuse, cs->cached,
+                cs->allocs, cs->fresh);
+    }
+}
+
+/* mem – na co idzie pamięć: podsystemy (teraz/szczyt) i stan PMM */
+static void mem_usage(void) {
+    pmm_stats_t ps;
+    pmm_get_stats(&ps);
+    uint32_t used_kib = (ps.total_frames - ps.free_frames) * (PAGE_SIZE / 1024);
+    uint32_t sum = 0;
+
+    kprintf("podsystem  teraz KiB  szczyt KiB\n");
+    for (int t = 0; t < MEM_TAGS; t++) {
+        mem_tag_stats_t st;
+        mem_account_get((mem_tag_t)t, &st);
+        if (st.frames) sum += st.cur / 1024;
+        kprintf("%s%s  %u  %u\n", st.frames ? "" : "  (w tym) ", st.name,
+                st.cur / 1024, st.peak / 1024);
+    }
+    kprintf("nieprzypisane  %u\n", used_kib > sum ? used_kib - sum : 0);
+    kprintf("PMM: zajęte %u KiB, wolne %u KiB z %u KiB\n", used_kib,
+            ps.free_frames * (PAGE_SIZE / 1024),
+            ps.total_frames * (PAGE_SIZE / 1024));
+
+    /* fragmentacja: ile wolnej pamięci leży w blokach mniejszych niż
+     * największy możliwy (4 MiB) i jaki jest największy wolny blok */
+    int largest = -1;
+    kprintf("wolne bloki (rząd:liczba):");
+    for (int k = 0; k <= PMM_MAX_ORDER; k++) {
+        if (ps.free_blocks[k]) largest = k;
+        kprintf(" %d:%u", k, ps.free_blocks[k]);
+    }
+    kprintf("\n");
+    uint32_t big = ps.free_blocks[PMM_MAX_ORDER] << PMM_MAX_ORDER;
+    kprintf("największy wolny blok: %u KiB, poza blokami 4 MiB: %u%% wolnej pamięci\n",
+            largest < 0 ? 0 : (PAGE_SIZE / 1024) << largest,
+            ps.free_frames ? (ps.free_frames - big) * 100 / ps.free_frames : 0);
+}
+
+/* vm – regiony pamięci wirtualnej z leniwym przydziałem */
+static void vm_line(const vm_region_stats_t* st, void* ctx) {
+    (void)ctx;
+    kprintf("%s  0x%x  %u/%u  %u\n", st->name, (unsigned)st->start,
+            st->resident, st->pages, st->faults);
+}
+
+static void mem_vm(void) {
+    vm_stats_t st;
+    vm_get_stats(&st);
+    kprintf("regiony: %u, strony: %u zarezerwowane, %u z ramką, minor faulty: %u\n",
+            st.regions, st.reserved_pages, st.resident_pages, st.faults);
+    pmm_stats_t ps;
+    pmm_get_stats(&ps);
+    uint32_t zr = ps.zero_hits + ps.zero_misses;
+    kprintf("wyzerowane ramki: %u/%u w puli, trafienia %u/%u (%u%%)\n",
+            ps.zero_pool, PMM_ZERO_POOL, ps.zero_hits, zr,
+            zr ? ps.zero_hits * 100 / zr : 0);
+    kprintf("region  początek  z ramką/rozmiar  faulty\n");
+    vm_walk(vm_line, NULL);
+}
+
+/* dmesg [-c | -n POZIOM] – bufor logu jądra; -c czyści po wypisaniu,
+ * -n ustawia, do jakiego poziomu log idzie na konsolę */
+static void log_dmesg(const char* arg) {
+    if (starts_with(arg, "-n")) {
+        const char* p = skip_ws(arg+2);
+        if (*p < '0' || *p > '7' || p[1]) { kprintf("Użycie: dmesg -n 0..7\n"); return; }
+        klog_set_console_level(*p - '0');
+        return;
+    }
+    klog_dump();
+    klog_stats_t st;
+    klog_get_stats(&st);
+    kprintf("-- %u rekordów, %u/%u B, do konsoli czeka %u B, zgubione %u (poziom konsoli %d)\n",
+            st.records, st.used, KLOG_SIZE, st.pending, st.dropped, klog_console_level());
+    if (streq(arg, "-c")) klog_clear();
+}
+
+/* e9 [log|cat|all|off] – co idzie na debugcon QEMU (port 0xE9) */
+static void con_e9(const char* arg) {
+    static const struct { const char* name; unsigned what; } modes[] = {
+        {"off", 0}, {"log", DEBUGCON_LOG}, {"cat", DEBUGCON_CAT},
+        {"all", DEBUGCON_LOG | DEBUGCON_CAT},
+    };
+    if (!debugcon_present()) { kprintf("[ERR] e9: brak debugcon (QEMU -debugcon ...)\n"); return; }
+    for (unsigned i = 0; *arg && i < sizeof(modes) / sizeof(modes[0]); i++) {
+        if (!streq(arg, modes[i].name)) continue;
+        debugcon_route(modes[i].what);
+        return;
+    }
+    if (*arg) { kprintf("Użycie: e9 [log|cat|all|off]\n"); return; }
+    unsigned r = debugcon_routed();
+    kprintf("debugcon 0xE9: log %s, cat %s\n", (r & DEBUGCON_LOG) ? "tak" : "nie",
+            (r & DEBUGCON_CAT) ? "tak" : "nie");
+}
+
+/* vcon [shell N|off] [cat N|off] – porty virtio-console */
+static void con_vcon(const char* arg) {
+    if (!vcon_present()) { kprintf("[ERR] vcon: brak urządzenia virtio-console\n"); return; }
+    int shell = starts_with(arg, "shell ");
+    if (shell || starts_with(arg, "cat ")) {
+        const char* v = skip_ws(arg + (shell ? 6 : 4));
+        int port = -1;
+        if (!streq(v, "off")) {
+            if (*v < '0' || *v > '9' || v[1]) { kprintf("Użycie: vcon shell|cat N|off\n"); return; }
+            port = *v - '0';
+            vcon_port_info_t pi;
+            if (!vcon_port_info(port, &pi) || !pi.present) {
+                kprintf("[ERR] vcon: nie ma portu %d\n", port);
+                return;
+            }
+        }
+        if (!shell) { g_cat_port = port; return; }
+        if (g_shell_port >= 0) kprintf_remove_sink(vcon_sink(g_shell_port));
+        g_shell_port = port;
+        if (port >= 0) kprintf_add_sink(vcon_sink(port));
+        return;
+    }
+    if (*arg) { kprintf("Użycie: vcon [shell N|off] [cat N|off]\n"); return; }
+    for (int i = 0; i < VCON_MAX_PORTS; i++) {
+        vcon_port_info_t pi;
+        if (!vcon_port_info(i, &pi) || !pi.present) continue;
+        kprintf("port %d %-16s host %s%s%s%s  rx %u KiB  tx %u KiB w %u buf., %u powiadomień\n",
+                i, pi.name[0] ? pi.name : "-", pi.host_open ? "otwarty" : "zamknięty",
+                pi.console ? ", konsola" : "", i == g_shell_port ? ", powłoka" : "",
+                i == g_cat_port ? ", cat" : "", (unsigned)(pi.rx_bytes >> 10),
+                (unsigned)(pi.tx_bytes >> 10), pi.tx_bufs, pi.kicks);
+    }
+}
+
+/* rz [/ram/ŚCIEŻKA] i sz /ram/ŚCIEŻKA – pliki przez COM1 (tools/zxfer.py) */
+static void ram_xfer(const char* path, int send) {
+    const char* rp = ram_path(*path ? path : "/ram/");
+    if (!rp || (send && streq(rp, "/"))) {
+        kprintf("Użycie: rz [/ram/ŚCIEŻKA] | sz /ram/PLIK\n");
+        return;
+    }
+    zx_stats_t st;
+    if (!send) kprintf("[RZ] Czekamy na nadawcę (tools/zxfer.py send), Ctrl-X Ctrl-X przerywa\n");
+    else kprintf("[SZ] Czekamy na odbiorcę (tools/zxfer.py recv), Ctrl-X Ctrl-X przerywa\n");
+    serial_flush();
+    int rc = send ? zx_send(rp, &st) : zx_receive(rp, &st);
+    if (rc) {
+        kprintf("\n[ERR] %s %s: kod=%d po %u B (ramek %u, powtórek %u, złych %u, przeterminowań %u)\n",
+                send ? "sz" : "rz", st.name, rc, st.bytes, st.frames, st.rewinds, st.bad_frames,
+                st.timeouts);
+        return;
+    }
+    kprintf("\n[OK] %s %s: %u B, CRC32 %08x, ramek %u, powtórek %u, złych %u\n",
+            send ? "sz" : "rz", st.name, st.bytes, st.crc32, st.frames, st.rewinds, st.bad_frames);
+    bench_report(send ? "sz" : "rz", st.bytes, st.ticks);
+}
+
+/* irq – liczniki i czas obsługi linii, wyjątki */
+static void sys_irq(void) {
+    kprintf("kontroler: %s, fałszywe: %u", irq_controller(), irq_spurious());
+    apic_info_t ai;
+    apic_get_info(&ai);
+    if (streq(irq_controller(), "IOAPIC")) kprintf(" (+%u z APIC)", ai.spurious);
+    kprintf("\nIRQ  %-16s %10s %12s %10s %10s\n", "obsługa", "liczba", "razem us", "śr. ns", "maks. ns");
+    for (uint8_t i = 0; i < IRQ_LINES; i++) {
+        irq_stats_t st;
+        irq_get_stats(i, &st);
+        if (!st.name && !st.count) continue;
+        uint64_t ns = ktime_cycles_to_ns(st.cycles);
+        uint32_t avg = st.count ? (uint32_t)(ns / st.count) : 0;
+        kprintf("%3u  %-16s %10u %12llu %10u %10u\n", i, st.name ? st.name : "-", st.count,
+                ns / 1000, avg, (uint32_t)ktime_cycles_to_ns(st.max_cycles));
+    }
+    for (uint8_t v = 0; v < 32; v++)
+        if (idt_count(v)) kprintf("wyjątek %u: %u\n", v, idt_count(v));
+}
+
+/* sum PATH – CRC32 i CRC32C pliku, osobno czas I/O i obliczeń */
+static void fs_sum(const char* path) {
+    if (!*path) { kprintf("Użycie: sum /ŚCIEŻKA\n"); return; }
+    checksum_result_t r;
+    int rc = checksum_file(&g_vol, path, &r);
+    if (rc) { kprintf("[ERR] sum %s: kod=%d\n", path, rc); return; }
+
+    kprintf("CRC32  %08x  %s\n", r.crc32, path);
+    kprintf("CRC32C %08x  %s\n", r.crc32c, path);
+    bench_report("odczyt", r.bytes, r.io_ticks);
+    bench_report("crc32 (slice-by-8)", r.bytes, r.crc32_ticks);
+    bench_report(crc32c_hw() ? "crc32c (sse4.2)" : "crc32c (slice-by-8)",
+                 r.bytes, r.crc32c_ticks);
+}
+
 /* Montujemy pierwszą partycję FAT32 (0x0B/0x0C) z dysku 0 */
 static int fs_init(void) {
     mbr_partition_t parts[4];
@@ -150,6 +533,8 @@ static int fs_init(void) {
             int rc = fat32_mount(&g_vol, &g_dev, fat32_read_from_disk);
             if (rc == 0) {
                 kprintf("[OK] FAT32 zamontowany poprawnie.\n");
+                /* zapis potrzebny tylko do defragmentacji */
+                fat32_attach_writer(&g_vol, fat32_write_to_disk);
                 return 0;
             } else {
                 kprintf("[ERR] Mount FAT32 nie powiódł się (kod=%d)\n", rc);
@@ -164,15 +549,15 @@ static int fs_init(void) {
 /* Minimalna powłoka na UART */
 static void shell_loop(void) {
     char line[128];
-    kprintf("\n[TTY] Prosta powłoka. Komendy: help | ls [PATH] | cat PATH | reboot | halt\n");
+    kprintf("\n[TTY] Prosta powłoka. Komendy: help | ls [PATH] | cat PATH | rz [PATH] | sz PATH | sum PATH | cache [drop] | mem | slab | dma | vm | irq | dmesg [-c|-n N] | e9 [log|cat|all|off] | vcon [shell|cat N|off] | frag [-v] | defrag [PATH] | bench ... | reboot | halt\n");
     for (;;) {
-        serial_write("> ");
+        shell_write("> ");
         serial_getline(line, sizeof(line));
         const char* s = skip_ws(line);
         if (*s == 0) continue;
 
         if (streq(s, "help")) {
-            kprintf("help\nls [PATH]\ncat PATH\nreboot\nhalt\n");
+            kprintf("help\nls [PATH]\ncat PATH\nrz [/ram/PATH]\nsz /ram/PATH\nsum PATH\ncache [drop]\nmem\nslab\ndma\nvm\nirq\ndmesg [-c|-n N]\ne9 [log|cat|all|off]\nvcon [shell N|off] [cat N|off]\nfrag [-v]\ndefrag [PATH]\nbench NAZWA [ARG]\nreboot\nhalt\n");
             continue;
         }
         if (streq(s, "halt")) {
@@ -181,6 +566,7 @@ static void shell_loop(void) {
         }
         if (streq(s, "reboot")) {
             kprintf("[REBOOT]\n");
+            serial_flush();
             /* reset przez KBC (0x64 ← 0xFE) */
             __asm__ __volatile__(
                 "mov $0xFE, %%al\n\t"
@@ -193,15 +579,115 @@ static void shell_loop(void) {
         if (streq(s, "ls")) { fs_ls("/"); continue; }
         if (starts_with(s, "ls "))   { fs_ls(skip_ws(s+2)); continue; }
         if (starts_with(s, "cat "))  { fs_cat(skip_ws(s+3)); continue; }
+        if (streq(s, "rz"))          { ram_xfer("", 0); continue; }
+        if (starts_with(s, "rz "))   { ram_xfer(skip_ws(s+2), 0); continue; }
+        if (starts_with(s, "sz "))   { ram_xfer(skip_ws(s+2), 1); continue; }
+        if (streq(s, "sum"))         { fs_sum(""); continue; }
+        if (starts_with(s, "sum "))  { fs_sum(skip_ws(s+3)); continue; }
+        if (streq(s, "cache"))       { fs_cache(""); continue; }
+        if (starts_with(s, "cache ")) { fs_cache(skip_ws(s+5)); continue; }
+        if (streq(s, "mem"))         { mem_usage(); continue; }
+        if (streq(s, "slab"))        { mem_slab(); continue; }
+        if (streq(s, "dma"))         { mem_dma(); continue; }
+        if (streq(s, "vm"))          { mem_vm(); continue; }
+        if (streq(s, "dmesg"))       { log_dmesg(""); continue; }
+        if (starts_with(s, "dmesg ")) { log_dmesg(skip_ws(s+5)); continue; }
+        if (streq(s, "e9"))          { con_e9(""); continue; }
+        if (starts_with(s, "e9 "))   { con_e9(skip_ws(s+2)); continue; }
+        if (streq(s, "irq"))         { sys_irq(); continue; }
+        if (streq(s, "vcon"))        { con_vcon(""); continue; }
+        if (starts_with(s, "vcon ")) { con_vcon(skip_ws(s+4)); continue; }
+        if (streq(s, "frag"))        { fs_frag(""); continue; }
+        if (starts_with(s, "frag ")) { fs_frag(skip_ws(s+4)); continue; }
+        if (streq(s, "defrag"))      { fs_defrag(""); continue; }
+        if (starts_with(s, "defrag ")) { fs_defrag(skip_ws(s+6)); continue; }
+        if (streq(s, "bench"))       { bench_run(&g_vol, ""); continue; }
+        if (starts_with(s, "bench ")) { bench_run(&g_vol, skip_ws(s+5)); continue; }
 
         kprintf("[ERR] Nie znam: %s\n", s);
     }
 }
 
 /* ======== Wejście jądra ======== */
-void kmain(void) {
+void kmain(uint32_t mb_magic, const multiboot_info_t* mbi) {
     serial_init(COM1_BASE);
+    klog_init();
     kprintf("\n=== Cygnus kernel ===\n");
+    if (debugcon_detect()) kprintf("[CON] debugcon 0xE9 dostępny (komenda e9)\n");
+    idt_init();
+    irq_init();
+    serial_enable_irq();
+    __asm__ __volatile__("sti");
+    fpu_init();
+    string_init();
+    kprintf("[CPU] memcpy/memset: %s\n", string_impl_name());
+    ktime_init();
+    ktime_info_t ki;
+    ktime_get_info(&ki);
+    if (ki.calibrated) {
+        uint32_t khz = (uint32_t)(ki.tsc_hz / 1000);
+        kprintf("[TIME] TSC %u.%03u MHz (PIT, rozrzut %u ppm), inwariantny: %s\n",
+                khz / 1000, khz % 1000, ki.cal_spread_ppm, ki.invariant ? "tak" : "nie");
+    } else {
+        kprintf("[WARN] Kalibracja TSC nie wyszła, zakładamy 1 GHz\n");
+    }
+
+    /* PMM (ramki 4 KiB) + tablice stron. Mapę pamięci bierzemy z multiboot,
+     * bez niej – CYGNUS_MEM_TOP. */
+    static boot_mem_t bm;
+    multiboot_dump(mb_magic, mbi);
+    if (multiboot_parse(mb_magic, mbi, &bm)) {
+        paging_setup_mmap((uintptr_t)_kernel_start, (uintptr_t)_kernel_end,
+                          bm.usable, bm.n_usable, bm.reserved, bm.n_reserved);
+    } else {
+        kprintf("[WARN] Brak mapy pamięci, zakładamy %u MiB\n",
+                CYGNUS_MEM_TOP >> 20);
+        paging_setup((uintptr_t)_kernel_start, (uintptr_t)_kernel_end, CYGNUS_MEM_TOP);
+    }
+
+    /* od teraz adresy idą przez tablice stron (mapa bezpośrednia RAM) */
+    paging_enable();
+    paging_stats_t pgs;
+    paging_get_stats(&pgs);
+    kprintf("[MEM] Stronicowanie: strony 4 MiB %s (%u), globalne %s, PAT WC %s, tablice stron: %u\n",
+            pgs.pse ? "tak" : "nie", pgs.large_pages, pgs.pge ? "tak" : "nie",
+            pgs.pat_wc ? "tak" : "nie", pgs.pt_frames);
+
+    if (irq_use_apic()) {
+        apic_info_t ai;
+        apic_get_info(&ai);
+        kprintf("[IRQ] IOAPIC 0x%x (%u wejść, nadpisań ISA %u), LAPIC 0x%x id %u\n",
+                ai.ioapic_phys, ai.ioapic_pins, ai.overrides, ai.lapic_phys, ai.lapic_id);
+    }
+
+    kmem_init();
+    vm_init();
+    fat16_init(); /* dysk RAM pod /ram (rz/sz) */
+
+    if (fbcon_init()) {
+        fbcon_stats_t fs;
+        fbcon_get_stats(&fs);
+        kprintf("[FB] Konsola %ux%u (%ux%u znaków), VRAM 0x%x, %s\n", FB_WIDTH, FB_HEIGHT,
+                FB_COLS, FB_ROWS, fs.phys, fs.wc ? "write-combining" : "bez cache");
+    }
+
+    if (vcon_init()) {
+        vcon_port_info_t pi;
+        int n = 0;
+        for (int i = 0; i < VCON_MAX_PORTS; i++) n += vcon_port_info(i, &pi) && pi.present;
+        kprintf("[VCON] virtio-console: portów %d\n", n);
+    }
+
+    /* cache stron skalujemy do tego, co faktycznie zostało wolne */
+    pmm_stats_t ps;
+    pmm_get_stats(&ps);
+    kprintf("[MEM] Wolne: %u MiB z %u MiB\n", ps.free_frames >> 8, ps.total_frames >> 8);
+    pcache_init(ps.free_frames / CYGNUS_PCACHE_SHARE);
+    idle_register(fat32_aio_idle);
+    idle_register(pmm_zero_idle);
+    idle_register(klog_idle);
+    idle_register(fbcon_idle);
+    idle_register(vcon_idle);
 
     int disks = disk_enumerate();
     kprintf("[INIT] Dyski widoczne: %d\n", disks);
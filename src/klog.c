@@ -0,0 +1,249 @@
+/*
+ * [Cygnus] - [src/klog.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "klog.h"
+#include "cpu.h"
+#include "ktime.h"
+#include "../inc/std.h"
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Nagłówek rekordu; tekst leży zaraz za nim, całość wyrównana do 8 B.
+ * Rekordy się nie zawijają – gdy na końcu bufora brakuje miejsca,
+ * wstawiamy znacznik KLOG_WRAP i zaczynamy od offsetu 0. */
+typedef struct {
+  uint16_t len;
+  uint8_t level;
+  uint8_t flags;
+  uint32_t seq;
+  uint64_t ts;
+} klog_rec_t;
+
+#define KLOG_WRAP 0xFFFFu
+#define REC_ECHOED 0x01  /* już był na konsoli (z kprintf) */
+
+static uint8_t g_buf[KLOG_SIZE] __attribute__((aligned(8)));
+/* pozycje rosną bez zawijania; offset w buforze = pozycja % KLOG_SIZE */
+static uint32_t g_head;   /* następny zapis */
+static uint32_t g_tail;   /* najstarszy rekord */
+static uint32_t g_con;    /* następny rekord dla konsoli */
+static uint32_t g_seq, g_dropped, g_records;
+static int g_con_level = KLOG_INFO;
+static ksink_t *g_out = &g_ksink_serial; /* konsola dla drain/dump */
+
+/* linia z kprintf składana do '\n' */
+static char g_line[KLOG_LINE_MAX];
+static uint32_t g_line_len;
+
+static inline uint32_t rec_size(uint32_t len) {
+  return (uint32_t)(sizeof(klog_rec_t) + len + 7) & ~7u;
+}
+
+static inline klog_rec_t *rec_at(uint32_t pos) {
+  return (klog_rec_t *)&g_buf[pos % KLOG_SIZE];
+}
+
+static uint32_t rec_next(uint32_t pos) {
+  const klog_rec_t *r = rec_at(pos);
+  if (r->len == KLOG_WRAP) return pos + (KLOG_SIZE - pos % KLOG_SIZE);
+  return pos + rec_size(r->len);
+}
+
+static inline bool rec_for_console(const klog_rec_t *r) {
+  return r->len != KLOG_WRAP && !(r->flags & REC_ECHOED) &&
+         r->level <= g_con_level;
+}
+
+/* Zwalnia najstarszy rekord. Przerwania wyłączone. */
+static void drop_oldest(void) {
+  const klog_rec_t *r = rec_at(g_tail);
+  uint32_t next = rec_next(g_tail);
+  if (r->len != KLOG_WRAP) g_records--;
+  if (g_con == g_tail) {
+    if (rec_for_console(r)) g_dropped++;
+    g_con = next;
+  }
+  g_tail = next;
+}
+
+static void make_room(uint32_t sz) {
+  while (g_head + sz - g_tail > KLOG_SIZE) drop_oldest();
+}
+
+static void append(int level, uint8_t flags, const char *text, uint32_t len) {
+  while (len && (text[len - 1] == '\n' || text[len - 1] == '\r')) len--;
+  if (len > KLOG_LINE_MAX) len = KLOG_LINE_MAX;
+  uint32_t sz = rec_size(len);
+
+  uint32_t fl = irq_save();
+  uint32_t room_to_end = KLOG_SIZE - g_head % KLOG_SIZE;
+  if (room_to_end < sz) {
+    make_room(room_to_end);
+    rec_at(g_head)->len = KLOG_WRAP;
+    g_head += room_to_end;
+  }
+  make_room(sz);
+  klog_rec_t *r = rec_at(g_head);
+  r->len = (uint16_t)len;
+  r->level = (uint8_t)level;
+  r->flags = flags;
+  r->seq = g_seq++;
+  r->ts = rdtsc();
+  memcpy(r + 1, text, len);
+  g_head += sz;
+  g_records++;
+  irq_restore(fl);
+}
+
+void vklogf(int level, const char *fmt, va_list ap) {
+  char line[KLOG_LINE_MAX + 1];
+  int n = kvsnprintf(line, (int)sizeof(line), fmt, ap);
+  if (n > KLOG_LINE_MAX) n = KLOG_LINE_MAX;
+  append(level, 0, line, (uint32_t)n);
+}
+
+void klogf(int level, const char *fmt, ...) {
+  va_list ap;
+  va_start(ap, fmt);
+  vklogf(level, fmt, ap);
+  va_end(ap);
+}
+
+/* ===== ujście dla kprintf ===== */
+
+static int line_level(const char *s, uint32_t n) {
+  if (n >= 5 && memcmp(s, "[ERR]", 5) == 0) return KLOG_ERR;
+  if (n >= 7 && memcmp(s, "[PANIC]", 7) == 0) return KLOG_ERR;
+  return KLOG_INFO;
+}
+
+static void klog_sink_write(ksink_t *s, const char *buf, size_t n) {
+  (void)s;
+  uint32_t fl = irq_save();
+  for (size_t i = 0; i < n; i++) {
+    if (buf[i] == '\n' || g_line_len == KLOG_LINE_MAX) {
+      if (g_line_len)
+        append(line_level(g_line, g_line_len), REC_ECHOED, g_line, g_line_len);
+      g_line_len = 0;
+      if (buf[i] == '\n') continue;
+    }
+    g_line[g_line_len++] = buf[i];
+  }
+  irq_restore(fl);
+}
+
+static ksink_t g_ksink_klog = {klog_sink_write, NULL};
+
+void klog_init(void) { kprintf_add_sink(&g_ksink_klog); }
+
+/* ===== odczyt ===== */
+
+/* Kopiuje rekord spod *pos (przesuwając na najstarszy, jeżeli *pos już
+ * nadpisano). Zwraca false na końcu bufora. */
+static bool rec_copy(uint32_t *pos, klog_rec_t *hdr, char *text) {
+  uint32_t fl = irq_save();
+  if ((int32_t)(*pos - g_tail) < 0) *pos = g_tail;
+  while (*pos != g_head && rec_at(*pos)->len == KLOG_WRAP) *pos = rec_next(*pos);
+  if (*pos == g_head) {
+    irq_restore(fl);
+    return false;
+  }
+  const klog_rec_t *r = rec_at(*pos);
+  *hdr = *r;
+  memcpy(text, r + 1, r->len);
+  text[r->len] = 0;
+  *pos = rec_next(*pos);
+  irq_restore(fl);
+  return true;
+}
+
+static void rec_print(const klog_rec_t *r, const char *text) {
+  /* znacznik zostaje w cyklach TSC (tanio przy zapisie), na czas
+   * przeliczamy dopiero przy wypisaniu */
+  uint64_t us = ktime_cycles_to_ns(r->ts) / 1000;
+  uint32_t sec = (uint32_t)(us / 1000000);
+  kfprintf(g_out, "[%5u.%06u] %s\n", sec, (uint32_t)(us - (uint64_t)sec * 1000000), text);
+}
+
+/* Jeden rekord dla konsoli; false, gdy nic nie czeka. g_con nigdy nie
+ * zostaje za g_tail – drop_oldest przesuwa go razem z ogonem. */
+static bool drain_one(void) {
+  klog_rec_t r;
+  char text[KLOG_LINE_MAX + 1];
+  uint32_t fl = irq_save();
+  while (g_con != g_head && !rec_for_console(rec_at(g_con)))
+    g_con = rec_next(g_con);
+  if (g_con == g_head) {
+    irq_restore(fl);
+    return false;
+  }
+  const klog_rec_t *src = rec_at(g_con);
+  r = *src;
+  memcpy(text, src + 1, r.len);
+  text[r.len] = 0;
+  g_con = rec_next(g_con);
+  irq_restore(fl);
+  rec_print(&r, text);
+  return true;
+}
+
+#define KLOG_IDLE_BATCH 8
+
+bool klog_idle(void) {
+  bool worked = false;
+  for (int i = 0; i < KLOG_IDLE_BATCH && drain_one(); i++) worked = true;
+  return worked;
+}
+
+void klog_flush(void) {
+  while (drain_one()) {
+  }
+}
+
+void klog_dump(void) {
+  klog_rec_t r;
+  char text[KLOG_LINE_MAX + 1];
+  uint32_t pos = g_tail;
+  while (rec_copy(&pos, &r, text)) rec_print(&r, text);
+}
+
+void klog_clear(void) {
+  uint32_t fl = irq_save();
+  g_tail = g_con = g_head;
+  g_records = 0;
+  irq_restore(fl);
+}
+
+void klog_set_console_level(int level) { g_con_level = level; }
+
+void klog_set_output(ksink_t *sink) { g_out = sink ? sink : &g_ksink_serial; }
+
+int klog_console_level(void) { return g_con_level; }
+
+void klog_get_stats(klog_stats_t *out) {
+  uint32_t fl = irq_save();
+  out->records = g_records;
+  out->used = g_head - g_tail;
+  out->pending = g_head - g_con;
+  out->dropped = g_dropped;
+  out->written = g_seq;
+  irq_restore(fl);
+}
@@ -0,0 +1,87 @@
+/*
+ * [Cygnus] - [src/klog.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_KLOG_H
+#define CYGNUS_KLOG_H
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+struct ksink;
+
+/* Bufor logu jądra (dmesg).
+ *
+ * Rekordy {znacznik czasu, poziom, tekst jednej linii} w pierścieniu
+ * KLOG_SIZE bajtów. Zapis nigdy nie czeka na UART: przy braku miejsca
+ * nadpisujemy najstarsze rekordy. Na konsolę rekordy o poziomie
+ * <= klog_console_level wypisuje w tle klog_idle; te, które nadpiszemy,
+ * zanim tam trafią, liczymy jako zgubione.
+ *
+ * kprintf też trafia do bufora (ujście g_ksink_klog, linia po linii) –
+ * te linie są już na konsoli, więc klog_idle ich nie powtarza.
+ */
+
+#ifndef KLOG_SIZE
+#define KLOG_SIZE (64u * 1024)
+#endif
+#define KLOG_LINE_MAX 200  /* dłuższe linie obcinamy */
+
+/* poziomy jak w syslogu */
+enum {
+  KLOG_ERR = 3,
+  KLOG_WARN = 4,
+  KLOG_INFO = 6,
+  KLOG_DEBUG = 7,
+};
+
+typedef struct {
+  uint32_t records;  /* rekordów w buforze */
+  uint32_t used;     /* zajęte bajty */
+  uint32_t pending;  /* bajty czekające na konsolę */
+  uint32_t dropped;  /* nadpisane przed wypisaniem na konsolę */
+  uint32_t written;  /* wszystkich rekordów od startu */
+} klog_stats_t;
+
+/* Dopisuje linię do bufora (bez czekania). Końcowe '\n' jest opcjonalne. */
+void klogf(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+void vklogf(int level, const char *fmt, va_list ap);
+
+/* Podpina bufor pod kprintf (kprintf_add_sink). */
+void klog_init(void);
+
+/* Hook bezczynności: kilka rekordów na konsolę; true, jeżeli coś wypisał. */
+bool klog_idle(void);
+
+/* Wypisuje na konsolę wszystko, co czeka (np. przed paniką). */
+void klog_flush(void);
+
+/* Cały bufor od najstarszego rekordu do ujścia UART (komenda dmesg). */
+void klog_dump(void);
+void klog_clear(void);
+
+void klog_set_console_level(int level);
+/* Dokąd idą klog_idle/klog_flush/klog_dump (NULL = UART). Nie podpinać
+ * tu konsoli kprintf – zapętlilibyśmy log w sobie. */
+void klog_set_output(struct ksink *sink);
+int klog_console_level(void);
+void klog_get_stats(klog_stats_t *out);
+
+#endif /* CYGNUS_KLOG_H */
@@ -0,0 +1,234 @@
+/*
+ * [Cygnus] - [src/kmalloc.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "kmalloc.h"
+#include "memstat.h"
+#include "paging.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define SLAB_MAGIC 0x51AB51ABu
+#define LARGE_MAGIC 0x1A26E000u
+#define KMALLOC_MIN_SHIFT 4u  /* 16 B */
+#define KMALLOC_MAX_SHIFT 10u /* 1024 B */
+#define KMALLOC_CLASSES (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1u)
+
+typedef struct slab {
+  uint32_t magic;
+  kmem_cache_t *cache;
+  struct slab *prev, *next; /* lista slabów częściowo zajętych */
+  void *free;               /* lista wolnych obiektów */
+  uint32_t inuse;
+} slab_t;
+
+/* nagłówek dużego przydziału; obiekt zaczyna się zaraz za nim */
+typedef struct {
+  uint32_t magic; /* LARGE_MAGIC | order */
+  uint32_t pad[3];
+} large_hdr_t;
+
+struct kmem_cache {
+  char name[KMEM_NAME_MAX];
+  uint32_t size;     /* rozmiar slotu (z wyrównaniem) */
+  uint32_t first;    /* offset pierwszego obiektu w ramce */
+  uint32_t per_slab;
+  slab_t *partial;
+  slab_t *spare;     /* jeden pusty slab w zapasie */
+  uint32_t inuse, slabs, allocs, frees;
+};
+
+static kmem_cache_t g_caches[KMEM_MAX_CACHES];
+static uint32_t g_ncaches;
+static kmem_cache_t *g_classes[KMALLOC_CLASSES];
+static uint32_t g_large_pages;
+static bool g_ready;
+
+static inline slab_t *slab_of(const void *p) {
+  return (slab_t *)((uintptr_t)p & PAGE_MASK);
+}
+
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align) {
+  if (align < 8) align = 8;
+  if (align & (align - 1) || g_ncaches >= KMEM_MAX_CACHES) return NULL;
+  uint32_t sz = (uint32_t)((size + align - 1) & ~(align - 1));
+  uint32_t first = (uint32_t)((sizeof(slab_t) + align - 1) & ~(align - 1));
+  if (first + sz > PAGE_SIZE) return NULL;
+
+  kmem_cache_t *c = &g_caches[g_ncaches++];
+  memset(c, 0, sizeof(*c));
+  strncpy(c->name, name, KMEM_NAME_MAX - 1);
+  c->size = sz;
+  c->first = first;
+  c->per_slab = (PAGE_SIZE - first) / sz;
+  return c;
+}
+
+static void partial_push(kmem_cache_t *c, slab_t *s) {
+  s->prev = NULL;
+  s->next = c->partial;
+  if (s->next) s->next->prev = s;
+  c->partial = s;
+}
+
+static void partial_remove(kmem_cache_t *c, slab_t *s) {
+  if (s->prev) s->prev->next = s->next; else c->partial = s->next;
+  if (s->next) s->next->prev = s->prev;
+  s->prev = s->next = NULL;
+}
+
+static slab_t *slab_new(kmem_cache_t *c) {
+  slab_t *s = c->spare;
+  if (s) {
+    c->spare = NULL;
+    return s;
+  }
+  uintptr_t fr = pmm_alloc_frame();
+  if (!fr) return NULL;
+  mem_account_alloc(MEM_SLAB, PAGE_SIZE);
+  s = (slab_t *)fr; /* tożsamościowo, jak w paging.c */
+  s->magic = SLAB_MAGIC;
+  s->cache = c;
+  s->prev = s->next = NULL;
+  s->inuse = 0;
+  s->free = NULL;
+  /* lista wolnych od końca, żeby pierwszy obiekt był na początku */
+  for (uint32_t i = c->per_slab; i-- > 0;) {
+    void **o = (void **)((uint8_t *)s + c->first + i * c->size);
+    *o = s->free;
+    s->free = o;
+  }
+  c->slabs++;
+  return s;
+}
+
+void *kmem_cache_alloc(kmem_cache_t *c) {
+  slab_t *s = c->partial;
+  if (!s) {
+    if (!(s = slab_new(c))) return NULL;
+    partial_push(c, s);
+  }
+  void **o = (void **)s->free;
+  s->free = *o;
+  if (++s->inuse == c->per_slab) partial_remove(c, s); /* pełny */
+  c->inuse++;
+  c->allocs++;
+  mem_account_alloc(MEM_HEAP_OBJECTS, c->size);
+  return o;
+}
+
+void *kmem_cache_zalloc(kmem_cache_t *c) {
+  void *p = kmem_cache_alloc(c);
+  if (p) memset(p, 0, c->size);
+  return p;
+}
+
+void kmem_cache_free(kmem_cache_t *c, void *p) {
+  slab_t *s = slab_of(p);
+  if (s->magic != SLAB_MAGIC || s->cache != c) return; /* nie nasz wskaźnik */
+
+  if (s->inuse == c->per_slab) partial_push(c, s); /* był pełny */
+  *(void **)p = s->free;
+  s->free = p;
+  c->inuse--;
+  c->frees++;
+  mem_account_free(MEM_HEAP_OBJECTS, c->size);
+
+  if (--s->inuse == 0) {
+    partial_remove(c, s);
+    if (!c->spare) {
+      c->spare = s;
+    } else {
+      s->magic = 0;
+      pmm_free_frame((uintptr_t)s);
+      mem_account_free(MEM_SLAB, PAGE_SIZE);
+      c->slabs--;
+    }
+  }
+}
+
+void kmem_init(void) {
+  static const char *names[KMALLOC_CLASSES] = {
+      "kmalloc-16",  "kmalloc-32",  "kmalloc-64",  "kmalloc-128",
+      "kmalloc-256", "kmalloc-512", "kmalloc-1024"};
+  if (g_ready) return;
+  for (uint32_t i = 0; i < KMALLOC_CLASSES; i++)
+    g_classes[i] = kmem_cache_create(names[i], 1u << (KMALLOC_MIN_SHIFT + i),
+                                     0);
+  g_ready = true;
+}
+
+void *kmalloc(size_t size) {
+  if (!g_ready) kmem_init();
+  if (size <= (1u << KMALLOC_MAX_SHIFT)) {
+    uint32_t i = 0;
+    while ((1u << (KMALLOC_MIN_SHIFT + i)) < size) i++;
+    return kmem_cache_alloc(g_classes[i]);
+  }
+
+  /* duże: całe strony z buddy, nagłówek przed obiektem */
+  unsigned order = 0;
+  while (((size_t)PAGE_SIZE << order) < size + sizeof(large_hdr_t)) {
+    if (++order > PMM_MAX_ORDER) return NULL;
+  }
+  large_hdr_t *h = (large_hdr_t *)pmm_alloc_pages(order);
+  if (!h) return NULL;
+  h->magic = LARGE_MAGIC | order;
+  g_large_pages += 1u << order;
+  mem_account_alloc(MEM_HEAP_LARGE, (size_t)PAGE_SIZE << order);
+  return h + 1;
+}
+
+void *kzalloc(size_t size) {
+  void *p = kmalloc(size);
+  if (p) memset(p, 0, size);
+  return p;
+}
+
+void kfree(void *p) {
+  if (!p) return;
+  slab_t *s = slab_of(p);
+  if (s->magic == SLAB_MAGIC) {
+    kmem_cache_free(s->cache, p);
+    return;
+  }
+  large_hdr_t *h = (large_hdr_t *)p - 1;
+  if ((uintptr_t)h == (uintptr_t)s && (h->magic & ~0xFFu) == LARGE_MAGIC) {
+    unsigned order = h->magic & 0xFFu;
+    h->magic = 0;
+    g_large_pages -= 1u << order;
+    mem_account_free(MEM_HEAP_LARGE, (size_t)PAGE_SIZE << order);
+    pmm_free_pages((uintptr_t)h, order);
+  }
+}
+
+uint32_t kmem_cache_count(void) { return g_ncaches; }
+
+void kmem_cache_get_stats(uint32_t i, kmem_cache_stats_t *out) {
+  const kmem_cache_t *c = &g_caches[i];
+  out->name = c->name;
+  out->objsize = c->size;
+  out->inuse = c->inuse;
+  out->total = c->slabs * c->per_slab;
+  out->slabs = c->slabs;
+  out->allocs = c->allocs;
+  out->frees = c->frees;
+}
+
+uint32_t kmem_large_pages(void) { return g_large_pages; }
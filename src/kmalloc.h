@@ -0,0 +1,74 @@
+/*
+ * [Cygnus] - [src/kmalloc.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_KMALLOC_H
+#define CYGNUS_KMALLOC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Sterta jądra: cache slabów na ramkach PMM.
+ *
+ * Slab to jedna ramka 4 KiB: nagłówek na początku, dalej obiekty jednego
+ * rozmiaru połączone w listę wolnych. kfree znajduje nagłówek przez
+ * wyrównanie adresu w dół do ramki, więc nie trzyma rozmiaru obok
+ * obiektu. Pusty slab wraca do PMM (jeden na cache zostaje w zapasie).
+ *
+ * kmalloc obsługują klasy rozmiarów 16..1024 B; większe żądania dostają
+ * całe strony z allokatora buddy. Gorące struktury mają własne, nazwane
+ * cache (kmem_cache_create) – dokładny rozmiar i osobne statystyki.
+ */
+
+#define KMEM_NAME_MAX 16
+#define KMEM_MAX_CACHES 32
+
+typedef struct kmem_cache kmem_cache_t;
+
+typedef struct {
+  const char *name;
+  uint32_t objsize;  /* rozmiar obiektu z wyrównaniem */
+  uint32_t inuse;    /* obiekty zajęte */
+  uint32_t total;    /* pojemność wszystkich slabów */
+  uint32_t slabs;    /* ramki w użyciu */
+  uint32_t allocs;
+  uint32_t frees;
+} kmem_cache_stats_t;
+
+void kmem_init(void);
+
+/* 'align' musi być potęgą dwójki (0 = 8 B). NULL, gdy obiekt nie mieści
+ * się w slabie albo skończyła się tablica cache. */
+kmem_cache_t *kmem_cache_create(const char *name, size_t size, size_t align);
+void *kmem_cache_alloc(kmem_cache_t *c);
+void *kmem_cache_zalloc(kmem_cache_t *c);
+void kmem_cache_free(kmem_cache_t *c, void *p);
+
+void *kmalloc(size_t size);
+void *kzalloc(size_t size);
+void kfree(void *p);
+
+/* Statystyki: i-ty cache (0 <= i < kmem_cache_count()). */
+uint32_t kmem_cache_count(void);
+void kmem_cache_get_stats(uint32_t i, kmem_cache_stats_t *out);
+
+/* Strony wydane bezpośrednio na duże kmalloc (> 1024 B). */
+uint32_t kmem_large_pages(void);
+
+#endif /* CYGNUS_KMALLOC_H */
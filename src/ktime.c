@@ -0,0 +1,103 @@
+/*
+ * [Cygnus] - [src/ktime.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "ktime.h"
+#include "io.h"
+
+#define PIT_HZ 1193182u
+#define PIT_CH2 0x42
+#define PIT_CMD 0x43
+#define PIT_CH2_MODE0 0xB0 /* kanał 2, lo/hi, tryb 0, binarnie */
+#define PORT_B 0x61
+#define PORT_B_GATE2 0x01
+#define PORT_B_SPEAKER 0x02
+#define PORT_B_OUT2 0x20
+#define PIT_MAX_SPINS 50000000u /* inb ≥ ~0,5 µs, więc to dużo ponad okno */
+
+#define CPUID_EXT_POWER 0x80000007u
+#define CPUID_EDX_INVARIANT_TSC (1u << 8)
+
+uint32_t g_ktime_mult = 1u << KTIME_SHIFT; /* 1 GHz, do kalibracji */
+static ktime_info_t g_info = {1000000000ull, false, false, 0};
+/* w drugą stronę: cykle = ns * g_cyc_mult >> KTIME_SHIFT */
+static uint32_t g_cyc_mult = 1u << KTIME_SHIFT;
+
+/* Jedno okno: TSC od startu licznika do OUT2 = 1 (0, gdy OUT2 się nie
+ * zmienia – brak PIT-a). */
+static uint64_t pit_window(uint32_t count) {
+  uint8_t b = (uint8_t)((inb(PORT_B) & ~PORT_B_SPEAKER) & ~PORT_B_GATE2);
+  outb(PORT_B, b);
+  outb(PIT_CMD, PIT_CH2_MODE0);
+  outb(PIT_CH2, (uint8_t)count);
+  outb(PIT_CH2, (uint8_t)(count >> 8));
+  uint32_t fl = irq_save();
+  outb(PORT_B, b | PORT_B_GATE2); /* zbocze bramki startuje odliczanie */
+  uint64_t t0 = rdtsc();
+  uint32_t spins = 0;
+  while (!(inb(PORT_B) & PORT_B_OUT2) && ++spins < PIT_MAX_SPINS) {
+  }
+  uint64_t t1 = rdtsc();
+  irq_restore(fl);
+  outb(PORT_B, b);
+  return spins < PIT_MAX_SPINS ? t1 - t0 : 0;
+}
+
+void ktime_init(void) {
+  uint32_t a, b, c, d;
+  cpuid(0x80000000u, &a, &b, &c, &d);
+  if (a >= CPUID_EXT_POWER) {
+    cpuid(CPUID_EXT_POWER, &a, &b, &c, &d);
+    g_info.invariant = (d & CPUID_EDX_INVARIANT_TSC) != 0;
+  }
+
+  uint32_t count = PIT_HZ / 1000 * KTIME_CAL_MS;
+  uint64_t best = ~0ull, worst = 0;
+  for (int i = 0; i < KTIME_CAL_ROUNDS; i++) {
+    uint64_t t = pit_window(count);
+    if (!t) return;
+    if (t < best) best = t;
+    if (t > worst) worst = t;
+  }
+
+  g_info.tsc_hz = best * PIT_HZ / count;
+  g_info.cal_spread_ppm = (uint32_t)((worst - best) * 1000000 / best);
+  g_info.calibrated = true;
+  g_ktime_mult = (uint32_t)((1000000000ull << KTIME_SHIFT) / g_info.tsc_hz);
+  g_cyc_mult = (uint32_t)((g_info.tsc_hz << KTIME_SHIFT) / 1000000000ull);
+}
+
+void ktime_get_info(ktime_info_t *out) { *out = g_info; }
+
+uint64_t ktime_ns_to_cycles(uint64_t ns) {
+  /* jak ktime_cycles_to_ns – bez dzielenia 64-bitowego w pętlach
+   * czekania */
+  uint32_t lo = (uint32_t)ns, hi = (uint32_t)(ns >> 32);
+  return (((uint64_t)lo * g_cyc_mult) >> KTIME_SHIFT) +
+         (((uint64_t)hi * g_cyc_mult) << (32 - KTIME_SHIFT));
+}
+
+static void delay_cycles(uint64_t cycles) {
+  uint64_t end = rdtsc() + cycles;
+  while (rdtsc() < end) __asm__ volatile("pause");
+}
+
+void ndelay(uint32_t ns) { delay_cycles(ktime_ns_to_cycles(ns)); }
+void udelay(uint32_t us) { delay_cycles(ktime_ns_to_cycles((uint64_t)us * 1000)); }
+void mdelay(uint32_t ms) { delay_cycles(ktime_ns_to_cycles((uint64_t)ms * 1000000)); }
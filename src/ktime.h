@@ -0,0 +1,85 @@
+/*
+ * [Cygnus] - [src/ktime.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_KTIME_H
+#define CYGNUS_KTIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "cpu.h"
+
+/* Czas monotoniczny z TSC.
+ *
+ * ktime_init mierzy częstotliwość TSC kanałem 2 PIT-a (1,193182 MHz,
+ * bramkowany przez port 0x61, bez przerwań): kilka okien po
+ * KTIME_CAL_MS, bierzemy najkrótsze – SMI albo wywłaszczenie vCPU mogą
+ * pomiar tylko wydłużyć. Przeliczenie cykli na ns to mnożenie i
+ * przesunięcie (bez dzielenia 64-bitowego), więc ktime_ns jest tanie.
+ * Do czasu kalibracji zakładamy 1 GHz.
+ *
+ * Na CPU bez "invariant TSC" (CPUID 0x80000007) zmiana taktowania
+ * przesuwa skalę – ktime_get_info to zgłasza.
+ */
+
+#ifndef KTIME_CAL_MS
+#define KTIME_CAL_MS 10
+#endif
+#define KTIME_CAL_ROUNDS 5
+
+#define KTIME_SHIFT 24
+
+typedef struct {
+  uint64_t tsc_hz;
+  bool calibrated;
+  bool invariant;
+  uint32_t cal_spread_ppm; /* rozrzut między oknami kalibracji */
+} ktime_info_t;
+
+void ktime_init(void);
+void ktime_get_info(ktime_info_t *out);
+
+extern uint32_t g_ktime_mult; /* ns = cykle * mult >> KTIME_SHIFT */
+
+static inline uint64_t ktime_cycles_to_ns(uint64_t c) {
+  uint32_t lo = (uint32_t)c, hi = (uint32_t)(c >> 32);
+  return (((uint64_t)lo * g_ktime_mult) >> KTIME_SHIFT) +
+         (((uint64_t)hi * g_ktime_mult) << (32 - KTIME_SHIFT));
+}
+
+/* Nanosekundy od włączenia zasilania (od zera TSC). */
+static inline uint64_t ktime_ns(void) { return ktime_cycles_to_ns(rdtsc()); }
+
+uint64_t ktime_ns_to_cycles(uint64_t ns);
+
+void ndelay(uint32_t ns);
+void udelay(uint32_t us);
+void mdelay(uint32_t ms);
+
+/* Czeka, aż 'cond' będzie prawdziwe, najwyżej 'us' mikrosekund.
+ * Wartość: true – warunek spełniony, false – minął czas. */
+#define KTIME_POLL_US(cond, us)                                         \
+  ({                                                                    \
+    uint64_t end_ = rdtsc() + ktime_ns_to_cycles((uint64_t)(us) * 1000); \
+    bool ok_;                                                           \
+    while (!(ok_ = (cond)) && rdtsc() < end_) __asm__ volatile("pause"); \
+    ok_ || (cond);                                                      \
+  })
+
+#endif /* CYGNUS_KTIME_H */
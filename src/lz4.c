@@ -0,0 +1,489 @@
+/*
+ * [Cygnus] - [src/lz4.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "lz4.h"
+#include "vm.h"
+#include <stddef.h>
+#include <string.h>
+
+#define LZ4_MAGIC 0x184D2204u
+#define LZ4_SKIP_MAGIC 0x184D2A50u /* 0x184D2A50..5F */
+#define LZ4_HIST (64u * 1024)      /* maksymalny dystans dopasowania */
+
+#ifndef LZ4_INDEX_MAX
+#define LZ4_INDEX_MAX 256 /* wpisy indeksu bloków na strumień */
+#endif
+
+/* ===== xxHash32 ===== */
+
+#define XXH_P1 2654435761u
+#define XXH_P2 2246822519u
+#define XXH_P3 3266489917u
+#define XXH_P4 668265263u
+#define XXH_P5 374761393u
+
+typedef struct {
+  uint32_t total;
+  uint32_t v[4];
+  uint8_t mem[16];
+  uint32_t memsize;
+  uint32_t seed;
+} xxh32_state_t;
+
+static inline uint32_t rotl32(uint32_t x, int r) {
+  return (x << r) | (x >> (32 - r));
+}
+static inline uint32_t rd32le(const uint8_t *p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+static inline uint32_t xxh_round(uint32_t acc, uint32_t in) {
+  acc += in * XXH_P2;
+  acc = rotl32(acc, 13);
+  return acc * XXH_P1;
+}
+
+static void xxh32_reset(xxh32_state_t *st, uint32_t seed) {
+  memset(st, 0, sizeof(*st));
+  st->seed = seed;
+  st->v[0] = seed + XXH_P1 + XXH_P2;
+  st->v[1] = seed + XXH_P2;
+  st->v[2] = seed;
+  st->v[3] = seed - XXH_P1;
+}
+
+static void xxh32_update(xxh32_state_t *st, const void *data, uint32_t len) {
+  const uint8_t *p = (const uint8_t *)data;
+  const uint8_t *end = p + len;
+  st->total += len;
+
+  if (st->memsize + len < 16) {
+    memcpy(st->mem + st->memsize, p, len);
+    st->memsize += len;
+    return;
+  }
+  if (st->memsize) {
+    uint32_t fill = 16 - st->memsize;
+    memcpy(st->mem + st->memsize, p, fill);
+    for (int i = 0; i < 4; i++)
+      st->v[i] = xxh_round(st->v[i], rd32le(st->mem + i * 4));
+    p += fill;
+    st->memsize = 0;
+  }
+  while (end - p >= 16) {
+    for (int i = 0; i < 4; i++)
+      st->v[i] = xxh_round(st->v[i], rd32le(p + i * 4));
+    p += 16;
+  }
+  if (p < end) {
+    memcpy(st->mem, p, (size_t)(end - p));
+    st->memsize = (uint32_t)(end - p);
+  }
+}
+
+static uint32_t xxh32_digest(const xxh32_state_t *st) {
+  uint32_t h;
+  if (st->total >= 16)
+    h = rotl32(st->v[0], 1) + rotl32(st->v[1], 7) + rotl32(st->v[2], 12) +
+        rotl32(st->v[3], 18);
+  else
+    h = st->seed + XXH_P5;
+  h += st->total;
+
+  const uint8_t *p = st->mem;
+  const uint8_t *end = p + st->memsize;
+  while (end - p >= 4) {
+    h += rd32le(p) * XXH_P3;
+    h = rotl32(h, 17) * XXH_P4;
+    p += 4;
+  }
+  while (p < end) {
+    h += (*p++) * XXH_P5;
+    h = rotl32(h, 11) * XXH_P1;
+  }
+  h ^= h >> 15;
+  h *= XXH_P2;
+  h ^= h >> 13;
+  h *= XXH_P3;
+  h ^= h >> 16;
+  return h;
+}
+
+uint32_t xxh32(const void *data, uint32_t len, uint32_t seed) {
+  xxh32_state_t st;
+  xxh32_reset(&st, seed);
+  xxh32_update(&st, data, len);
+  return xxh32_digest(&st);
+}
+
+/* ===== Dekoder bloku ===== */
+
+/* Dekoduje jeden blok do 'dst'. Dopasowania mogą sięgać wstecz do
+ * 'dst_base' (historia poprzednich bloków albo początek bloku). */
+static int decode_block(const uint8_t *src, uint32_t srclen,
+                        const uint8_t *dst_base, uint8_t *dst, uint32_t dstcap,
+                        uint32_t *out_len) {
+  const uint8_t *ip = src;
+  const uint8_t *const iend = src + srclen;
+  uint8_t *op = dst;
+  uint8_t *const oend = dst + dstcap;
+
+  for (;;) {
+    if (ip >= iend) return LZ4_ERR_CORRUPT;
+    uint32_t token = *ip++;
+
+    /* literały */
+    uint32_t lit = token >> 4;
+    if (lit == 15) {
+      uint8_t b;
+      do {
+        if (ip >= iend) return LZ4_ERR_CORRUPT;
+        b = *ip++;
+        lit += b;
+      } while (b == 255);
+    }
+    if (lit > (uint32_t)(iend - ip) || lit > (uint32_t)(oend - op))
+      return LZ4_ERR_CORRUPT;
+    memcpy(op, ip, lit);
+    op += lit;
+    ip += lit;
+    if (ip == iend) break; /* ostatnia sekwencja ma tylko literały */
+
+    /* dopasowanie */
+    if (iend - ip < 2) return LZ4_ERR_CORRUPT;
+    uint32_t off = (uint32_t)ip[0] | ((uint32_t)ip[1] << 8);
+    ip += 2;
+    if (off == 0 || off > (uint32_t)(op - dst_base)) return LZ4_ERR_CORRUPT;
+
+    uint32_t ml = token & 15u;
+    if (ml == 15) {
+      uint8_t b;
+      do {
+        if (ip >= iend) return LZ4_ERR_CORRUPT;
+        b = *ip++;
+        ml += b;
+      } while (b == 255);
+    }
+    ml += 4;
+    if (ml > (uint32_t)(oend - op)) return LZ4_ERR_CORRUPT;
+
+    const uint8_t *match = op - off;
+    if (off >= ml) {
+      memcpy(op, match, ml);
+      op += ml;
+    } else {
+      /* nakładające się kopiowanie (np. powtórzenia) – bajt po bajcie */
+      while (ml--) *op++ = *match++;
+    }
+  }
+  *out_len = (uint32_t)(op - dst);
+  return 0;
+}
+
+/* ===== Strumień ===== */
+
+typedef struct {
+  uint32_t raw; /* offset nagłówka bloku w pliku skompresowanym */
+  uint32_t out; /* offset początku bloku po dekompresji */
+} lz4_index_t;
+
+struct lz4_stream {
+  bool used;
+  lz4_src_fn src;
+  void *ctx;
+  uint32_t src_size;
+
+  /* deskryptor ramki */
+  bool indep, block_csum, content_csum, has_csize;
+  uint32_t block_max;
+  uint64_t content_size;
+  uint32_t data_start; /* offset pierwszego bloku */
+
+  /* bieżący blok */
+  uint32_t next_raw; /* offset nagłówka następnego bloku */
+  uint32_t block_no; /* numer bloku spod next_raw */
+  uint32_t blk_out;  /* offset bieżącego bloku po dekompresji */
+  uint32_t blk_len;  /* zdekodowane bajty bieżącego bloku */
+  uint32_t cur;      /* pozycja w bieżącym bloku */
+  uint32_t hist_len; /* ważna historia przed blokiem (bloki zależne) */
+  bool eof;
+
+  /* suma zawartości – tylko przy czytaniu od zera bez seeków */
+  bool seq;
+  xxh32_state_t xs;
+
+  /* indeks bloków: co 'stride'-ty blok, rośnie sekwencyjnie */
+  lz4_index_t idx[LZ4_INDEX_MAX];
+  uint32_t nidx;
+  uint32_t stride;
+
+  uint8_t *cbuf; /* blok skompresowany */
+  uint8_t *dec;  /* [LZ4_HIST historii][blok] */
+};
+
+/* Bufory wszystkich strumieni (384 KiB przy domyślnych ustawieniach) leżą
+ * w regionie VM rezerwowanym przy pierwszym otwarciu: ramki dochodzą
+ * dopiero dla stron, których dekoder faktycznie dotknie. */
+typedef struct {
+  uint8_t cbuf[LZ4_MAX_STREAMS][LZ4_MAX_BLOCK];
+  uint8_t dec[LZ4_MAX_STREAMS][LZ4_HIST + LZ4_MAX_BLOCK];
+} lz4_bufs_t;
+
+static lz4_bufs_t *g_bufs;
+static lz4_stream_t g_streams[LZ4_MAX_STREAMS];
+
+static int src_read(lz4_stream_t *s, uint32_t off, void *buf, uint32_t n) {
+  if (off > s->src_size || n > s->src_size - off) return LZ4_ERR_IO;
+  return s->src(s->ctx, off, buf, n) ? LZ4_ERR_IO : 0;
+}
+
+static void rewind_to(lz4_stream_t *s, uint32_t raw, uint32_t out,
+                      uint32_t block_no) {
+  s->next_raw = raw;
+  s->block_no = block_no;
+  s->blk_out = out;
+  s->blk_len = 0;
+  s->cur = 0;
+  s->hist_len = 0;
+  s->eof = false;
+  s->seq = (raw == s->data_start);
+  if (s->seq) xxh32_reset(&s->xs, 0);
+}
+
+static void index_record(lz4_stream_t *s, uint32_t raw, uint32_t out) {
+  if (s->block_no != s->nidx * s->stride) return;
+  if (s->nidx && s->idx[s->nidx - 1].raw >= raw) return;
+  if (s->nidx == LZ4_INDEX_MAX) {
+    /* pełny: zostawiamy co drugi wpis i podwajamy krok */
+    for (uint32_t i = 0; i < LZ4_INDEX_MAX / 2; i++) s->idx[i] = s->idx[i * 2];
+    s->nidx = LZ4_INDEX_MAX / 2;
+    s->stride *= 2;
+    if (s->block_no != s->nidx * s->stride) return;
+  }
+  s->idx[s->nidx].raw = raw;
+  s->idx[s->nidx].out = out;
+  s->nidx++;
+}
+
+/* Ładuje następny blok. 0 = OK, 1 = koniec ramki, <0 = błąd. */
+static int load_next_block(lz4_stream_t *s) {
+  if (s->eof) return 1;
+  uint32_t out = s->blk_out + s->blk_len;
+  index_record(s, s->next_raw, out);
+
+  uint8_t hdr[4];
+  int rc = src_read(s, s->next_raw, hdr, 4);
+  if (rc) return rc;
+  uint32_t bsz = rd32le(hdr);
+
+  if (bsz == 0) { /* EndMark */
+    s->eof = true;
+    s->blk_out = out;
+    s->blk_len = 0;
+    s->cur = 0;
+    if (s->seq && s->content_csum) {
+      rc = src_read(s, s->next_raw + 4, hdr, 4);
+      if (rc) return rc;
+      if (rd32le(hdr) != xxh32_digest(&s->xs)) return LZ4_ERR_CHECKSUM;
+    }
+    return 1;
+  }
+
+  bool stored = (bsz & 0x80000000u) != 0;
+  bsz &= 0x7FFFFFFFu;
+  if (bsz > s->block_max) return LZ4_ERR_CORRUPT;
+
+  rc = src_read(s, s->next_raw + 4, s->cbuf, bsz);
+  if (rc) return rc;
+  if (s->block_csum) {
+    rc = src_read(s, s->next_raw + 4 + bsz, hdr, 4);
+    if (rc) return rc;
+    if (rd32le(hdr) != xxh32(s->cbuf, bsz, 0)) return LZ4_ERR_CHECKSUM;
+  }
+
+  /* bloki zależne: przesuwamy ostatnie 64 KiB wyjścia przed nowy blok */
+  if (!s->indep) {
+    uint32_t have = s->hist_len + s->blk_len;
+    uint32_t keep = have < LZ4_HIST ? have : LZ4_HIST;
+    memmove(s->dec + LZ4_HIST - keep, s->dec + LZ4_HIST + s->blk_len - keep,
+            keep);
+    s->hist_len = keep;
+  }
+
+  uint8_t *dst = s->dec + LZ4_HIST;
+  uint32_t n;
+  if (stored) {
+    memcpy(dst, s->cbuf, bsz);
+    n = bsz;
+  } else {
+    const uint8_t *base = s->indep ? dst : dst - s->hist_len;
+    rc = decode_block(s->cbuf, bsz, base, dst, s->block_max, &n);
+    if (rc) return rc;
+  }
+
+  if (s->seq) xxh32_update(&s->xs, dst, n);
+  s->blk_out = out;
+  s->blk_len = n;
+  s->cur = 0;
+  s->next_raw += 4 + bsz + (s->block_csum ? 4 : 0);
+  s->block_no++;
+  return 0;
+}
+
+static int parse_header(lz4_stream_t *s) {
+  uint32_t off = 0;
+  uint8_t b[15];
+
+  /* pomijamy ewentualne ramki "skippable" */
+  for (;;) {
+    int rc = src_read(s, off, b, 4);
+    if (rc) return LZ4_ERR_MAGIC;
+    uint32_t magic = rd32le(b);
+    if (magic == LZ4_MAGIC) break;
+    if ((magic & 0xFFFFFFF0u) != LZ4_SKIP_MAGIC) return LZ4_ERR_MAGIC;
+    if (src_read(s, off + 4, b, 4)) return LZ4_ERR_MAGIC;
+    off += 8 + rd32le(b);
+  }
+  off += 4;
+
+  if (src_read(s, off, b, 2)) return LZ4_ERR_HEADER;
+  uint8_t flg = b[0], bd = b[1];
+  if ((flg >> 6) != 1) return LZ4_ERR_HEADER;   /* wersja 01 */
+  if (flg & 0x02) return LZ4_ERR_HEADER;        /* bit zarezerwowany */
+  if (flg & 0x01) return LZ4_ERR_HEADER;        /* słowniki: nieobsługiwane */
+  if ((bd & 0x8F) != 0) return LZ4_ERR_HEADER;
+
+  s->indep = (flg & 0x20) != 0;
+  s->block_csum = (flg & 0x10) != 0;
+  s->has_csize = (flg & 0x08) != 0;
+  s->content_csum = (flg & 0x04) != 0;
+
+  uint32_t bmax_id = (bd >> 4) & 7u;
+  if (bmax_id < 4) return LZ4_ERR_HEADER;
+  s->block_max = 1u << (8 + 2 * bmax_id); /* 4:64K 5:256K 6:1M 7:4M */
+  if (s->block_max > LZ4_MAX_BLOCK) return LZ4_ERR_BLOCKSIZE;
+
+  uint32_t dlen = 2 + (s->has_csize ? 8 : 0);
+  if (src_read(s, off, b, dlen + 1)) return LZ4_ERR_HEADER;
+  if (((xxh32(b, dlen, 0) >> 8) & 0xFF) != b[dlen]) return LZ4_ERR_HEADER;
+  if (s->has_csize)
+    s->content_size = (uint64_t)rd32le(b + 2) | ((uint64_t)rd32le(b + 6) << 32);
+
+  s->data_start = off + dlen + 1;
+  return 0;
+}
+
+int lz4_stream_open(lz4_src_fn src, void *ctx, uint32_t src_size,
+                    lz4_stream_t **out) {
+  lz4_stream_t *s = NULL;
+  int slot;
+  for (slot = 0; slot < LZ4_MAX_STREAMS; slot++)
+    if (!g_streams[slot].used) { s = &g_streams[slot]; break; }
+  if (!s) return LZ4_ERR_NOMEM;
+  if (!g_bufs && !(g_bufs = vm_reserve(sizeof(*g_bufs), VM_WRITE, "lz4")))
+    return LZ4_ERR_NOMEM;
+
+  memset(s, 0, sizeof(*s));
+  s->src = src;
+  s->ctx = ctx;
+  s->src_size = src_size;
+  s->cbuf = g_bufs->cbuf[slot];
+  s->dec = g_bufs->dec[slot];
+  s->stride = 1;
+
+  int rc = parse_header(s);
+  if (rc) return rc;
+  rewind_to(s, s->data_start, 0, 0);
+  s->used = true;
+  *out = s;
+  return 0;
+}
+
+int lz4_stream_read(lz4_stream_t *s, void *buf, uint32_t n,
+                    uint32_t *out_read) {
+  uint8_t *dst = (uint8_t *)buf;
+  uint32_t done = 0;
+  int rc = 0;
+  while (done < n) {
+    if (s->cur == s->blk_len) {
+      rc = load_next_block(s);
+      if (rc == 1) { rc = 0; break; }
+      if (rc < 0) break;
+      continue;
+    }
+    uint32_t chunk = s->blk_len - s->cur;
+    if (chunk > n - done) chunk = n - done;
+    memcpy(dst + done, s->dec + LZ4_HIST + s->cur, chunk);
+    s->cur += chunk;
+    done += chunk;
+  }
+  if (out_read) *out_read = done;
+  return rc;
+}
+
+int lz4_stream_seek(lz4_stream_t *s, uint32_t pos) {
+  if (pos >= s->blk_out && pos < s->blk_out + s->blk_len) {
+    s->cur = pos - s->blk_out;
+    return 0;
+  }
+
+  if (pos == 0) {
+    rewind_to(s, s->data_start, 0, 0);
+  } else if (s->indep) {
+    /* najbliższy zaindeksowany blok przed 'pos' */
+    uint32_t lo = 0, hi = s->nidx;
+    while (hi - lo > 1) {
+      uint32_t mid = (lo + hi) / 2;
+      if (s->idx[mid].out <= pos) lo = mid; else hi = mid;
+    }
+    if (s->nidx && s->idx[lo].out <= pos &&
+        (pos < s->blk_out || s->idx[lo].out > s->blk_out))
+      rewind_to(s, s->idx[lo].raw, s->idx[lo].out, lo * s->stride);
+    else if (pos < s->blk_out)
+      rewind_to(s, s->data_start, 0, 0);
+    s->seq = false;
+  } else if (pos < s->blk_out) {
+    rewind_to(s, s->data_start, 0, 0);
+    s->seq = false;
+  } else {
+    s->seq = false;
+  }
+
+  /* dekodujemy do przodu aż blok obejmie 'pos' */
+  while (pos >= s->blk_out + s->blk_len) {
+    int rc = load_next_block(s);
+    if (rc == 1) { s->cur = s->blk_len; return 0; } /* za końcem */
+    if (rc < 0) return rc;
+  }
+  s->cur = pos - s->blk_out;
+  return 0;
+}
+
+uint32_t lz4_stream_tell(const lz4_stream_t *s) { return s->blk_out + s->cur; }
+
+bool lz4_stream_size(const lz4_stream_t *s, uint32_t *out) {
+  if (!s->has_csize || s->content_size > 0xFFFFFFFFull) return false;
+  *out = (uint32_t)s->content_size;
+  return true;
+}
+
+void lz4_stream_close(lz4_stream_t *s) {
+  if (s) s->used = false;
+}
@@ -0,0 +1,80 @@
+/*
+ * [Cygnus] - [src/lz4.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_LZ4_H
+#define CYGNUS_LZ4_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Strumieniowy dekoder ramek LZ4 (format ramki v1.6, bez słowników).
+ *
+ * Dane skompresowane pobieramy kawałkami przez 'lz4_src_fn', dekodujemy
+ * blok po bloku do ograniczonego okna: [64 KiB historii][1 blok]. Dla
+ * bloków niezależnych (domyślne w `lz4`) budujemy indeks offsetów bloków,
+ * więc seek wraca od razu do właściwego bloku; przy blokach zależnych seek
+ * wstecz dekoduje od początku ramki. Sumy kontrolne bloków sprawdzamy przy
+ * każdym ładowaniu bloku, sumę całej zawartości – przy czytaniu od
+ * początku do końca bez seeków.
+ */
+
+/* Maksymalny rozmiar bloku, jaki obsługujemy (BD w nagłówku ramki).
+ * 64 KiB odpowiada `lz4 -B4`. */
+#ifndef LZ4_MAX_BLOCK
+#define LZ4_MAX_BLOCK (64u * 1024)
+#endif
+
+/* Ile strumieni może być otwartych jednocześnie (bufory są statyczne). */
+#ifndef LZ4_MAX_STREAMS
+#define LZ4_MAX_STREAMS 2
+#endif
+
+enum {
+  LZ4_OK = 0,
+  LZ4_ERR_IO = -30,        /* źródło nie oddało danych */
+  LZ4_ERR_MAGIC = -31,     /* to nie ramka LZ4 */
+  LZ4_ERR_HEADER = -32,    /* zły deskryptor / suma nagłówka */
+  LZ4_ERR_BLOCKSIZE = -33, /* blok większy niż LZ4_MAX_BLOCK */
+  LZ4_ERR_CORRUPT = -34,   /* uszkodzony blok */
+  LZ4_ERR_CHECKSUM = -35,  /* niezgodna suma xxh32 */
+  LZ4_ERR_NOMEM = -36,     /* brak wolnego strumienia */
+};
+
+/* Czyta dokładnie 'n' bajtów skompresowanych od offsetu 'off'.
+ * Zwraca 0 gdy OK. */
+typedef int (*lz4_src_fn)(void *ctx, uint32_t off, void *buf, uint32_t n);
+
+typedef struct lz4_stream lz4_stream_t;
+
+int lz4_stream_open(lz4_src_fn src, void *ctx, uint32_t src_size,
+                    lz4_stream_t **out);
+/* Zwraca 0 gdy OK (na końcu danych *out_read < n), <0 przy błędzie. */
+int lz4_stream_read(lz4_stream_t *s, void *buf, uint32_t n,
+                    uint32_t *out_read);
+int lz4_stream_seek(lz4_stream_t *s, uint32_t pos);
+uint32_t lz4_stream_tell(const lz4_stream_t *s);
+/* Rozmiar po dekompresji, jeżeli ramka go podaje (flaga C.Size). */
+bool lz4_stream_size(const lz4_stream_t *s, uint32_t *out);
+void lz4_stream_close(lz4_stream_t *s);
+
+/* xxHash32 – używane przez format ramki, przydatne też gdzie indziej. */
+uint32_t xxh32(const void *data, uint32_t len, uint32_t seed);
+
+#endif /* CYGNUS_LZ4_H */
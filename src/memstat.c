@@ -0,0 +1,49 @@
+/*
+ * [Cygnus] - [src/memstat.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "memstat.h"
+
+static const char *const g_names[MEM_TAGS] = {
+    [MEM_RESERVED] = "zarezerwowane", [MEM_KERNEL] = "jądro",          [MEM_PMM_META] = "pmm-meta",
+    [MEM_PAGETABLES] = "tablice-stron", [MEM_ZERO_POOL] = "pula-zer",
+    [MEM_SLAB] = "slaby",            [MEM_HEAP_LARGE] = "kmalloc-duże",
+    [MEM_DMA] = "dma",               [MEM_PCACHE] = "pcache",
+    [MEM_VM] = "vm",                 [MEM_HEAP_OBJECTS] = "obiekty-sterty",
+};
+
+static uint32_t g_cur[MEM_TAGS];
+static uint32_t g_peak[MEM_TAGS];
+
+void mem_account_alloc(mem_tag_t tag, size_t bytes) {
+  g_cur[tag] += (uint32_t)bytes;
+  if (g_cur[tag] > g_peak[tag]) g_peak[tag] = g_cur[tag];
+}
+
+void mem_account_free(mem_tag_t tag, size_t bytes) {
+  /* nie schodzimy poniżej zera, gdy ktoś zwolni coś nierozliczonego */
+  g_cur[tag] -= bytes < g_cur[tag] ? (uint32_t)bytes : g_cur[tag];
+}
+
+void mem_account_get(mem_tag_t tag, mem_tag_stats_t *out) {
+  out->name = g_names[tag];
+  out->cur = g_cur[tag];
+  out->peak = g_peak[tag];
+  out->frames = tag < MEM_FRAME_TAGS;
+}
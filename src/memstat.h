@@ -0,0 +1,66 @@
+/*
+ * [Cygnus] - [src/memstat.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_MEMSTAT_H
+#define CYGNUS_MEMSTAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Rozliczanie pamięci jądra na podsystemy (bieżąco i szczytowo, w bajtach).
+ *
+ * Każdy alokator, który bierze ramki z PMM, zgłasza je pod swoim znacznikiem
+ * – suma znaczników "ramkowych" plus ramki nieprzypisane daje zajętość PMM.
+ * Znaczniki bajtowe (np. obiekty sterty) opisują, ile z tych ramek faktycznie
+ * jest w użyciu, i nie wchodzą do sumy.
+ */
+
+typedef enum {
+  /* ramki */
+  MEM_RESERVED,    /* niedostępne dla PMM: niski 1 MiB, dziury, moduły */
+  MEM_KERNEL,      /* obraz jądra (.text/.data/.bss, w tym statyczne tablice) */
+  MEM_PMM_META,    /* metadane buddy (bitmapy głów bloków) */
+  MEM_PAGETABLES,  /* tablice stron */
+  MEM_ZERO_POOL,   /* wyzerowane ramki czekające na użycie */
+  MEM_SLAB,        /* slaby sterty (kmalloc, kmem_cache_*) */
+  MEM_HEAP_LARGE,  /* duże przydziały kmalloc (całe strony) */
+  MEM_DMA,         /* pule DMA */
+  MEM_PCACHE,      /* strony cache plików */
+  MEM_VM,          /* strony regionów VM dołożone na żądanie */
+  MEM_FRAME_TAGS,
+  /* bajty */
+  MEM_HEAP_OBJECTS = MEM_FRAME_TAGS, /* zajęte obiekty w slabach */
+  MEM_TAGS
+} mem_tag_t;
+
+typedef struct {
+  const char *name;
+  uint32_t cur;  /* bajty teraz */
+  uint32_t peak; /* najwięcej naraz */
+  bool frames;   /* znacznik ramkowy (wchodzi do sumy) */
+} mem_tag_stats_t;
+
+void mem_account_alloc(mem_tag_t tag, size_t bytes);
+void mem_account_free(mem_tag_t tag, size_t bytes);
+
+void mem_account_get(mem_tag_t tag, mem_tag_stats_t *out);
+
+#endif /* CYGNUS_MEMSTAT_H */
@@ -0,0 +1,141 @@
+/*
+ * [Cygnus] - [src/multiboot.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "multiboot.h"
+#include "../inc/std.h"
+#include <stddef.h>
+#include <string.h>
+
+#define LIMIT_4G 0x100000000ull /* PMM widzi tylko pierwsze 4 GiB */
+
+static void add_reserved(boot_mem_t *bm, uint64_t base, uint64_t len) {
+    if (!len) return;
+    if (bm->n_reserved >= MB_MAX_RESERVED) {
+        kprintf("[WARN] Brak miejsca na rezerwację %x - %x\n", (unsigned)base,
+                (unsigned)(base + len - 1));
+        return;
+    }
+    bm->reserved[bm->n_reserved].base = base;
+    bm->reserved[bm->n_reserved].len = len;
+    bm->n_reserved++;
+}
+
+static void add_usable(boot_mem_t *bm, uint64_t base, uint64_t len) {
+    if (base >= LIMIT_4G) return;
+    if (base + len > LIMIT_4G) len = LIMIT_4G - base;
+    if (!len || bm->n_usable >= MB_MAX_RANGES) return;
+    bm->usable[bm->n_usable].base = base;
+    bm->usable[bm->n_usable].len = len;
+    bm->n_usable++;
+    bm->usable_bytes += len;
+}
+
+bool multiboot_parse(uint32_t magic, const multiboot_info_t *mbi,
+                     boot_mem_t *out) {
+    memset(out, 0, sizeof(*out));
+    if (magic != MULTIBOOT_BOOT_MAGIC || !mbi) return false;
+
+    if (mbi->flags & MB_INFO_MMAP) {
+        uintptr_t p = mbi->mmap_addr;
+        uintptr_t end = p + mbi->mmap_length;
+        while (p + sizeof(uint32_t) <= end) {
+            const multiboot_mmap_t *e = (const multiboot_mmap_t *)p;
+            /* dziury ACPI/MMIO zostają zarezerwowane – PMM zaczyna od
+             * "wszystko zajęte" i zwalnia tylko typ 1 */
+            if (e->type == MB_MEM_AVAILABLE) add_usable(out, e->addr, e->len);
+            p += e->size + sizeof(e->size);
+        }
+        add_reserved(out, mbi->mmap_addr, mbi->mmap_length);
+    } else if (mbi->flags & MB_INFO_MEMORY) {
+        add_usable(out, 0, (uint64_t)mbi->mem_lower * 1024);
+        add_usable(out, 0x100000, (uint64_t)mbi->mem_upper * 1024);
+    }
+    if (!out->n_usable) return false;
+
+    add_reserved(out, (uintptr_t)mbi, sizeof(*mbi));
+    if (mbi->flags & MB_INFO_CMDLINE)
+        add_reserved(out, mbi->cmdline, strlen((const char *)mbi->cmdline) + 1);
+    if (mbi->flags & MB_INFO_MODS) {
+        const multiboot_module_t *m = (const multiboot_module_t *)mbi->mods_addr;
+        out->mods = m;
+        out->mods_count = mbi->mods_count;
+        add_reserved(out, mbi->mods_addr, mbi->mods_count * sizeof(*m));
+        /* moduły ponad MB_MAX_MODS (z nazwami) obejmujemy jednym zakresem –
+         * może zatrzymać trochę wolnej pamięci, ale nic nie zginie */
+        uint64_t lo = ~0ull, hi = 0;
+        for (uint32_t i = 0; i < mbi->mods_count; i++) {
+            uint64_t s = m[i].mod_start, e = m[i].mod_end;
+            uint32_t slen = m[i].string ? strlen((const char *)m[i].string) + 1 : 0;
+            if (i < MB_MAX_MODS) {
+                add_reserved(out, s, e - s);
+                add_reserved(out, m[i].string, slen);
+                continue;
+            }
+            if (s < lo) lo = s;
+            if (e > hi) hi = e;
+            if (slen && m[i].string < lo) lo = m[i].string;
+            if (slen && m[i].string + slen > hi) hi = m[i].string + slen;
+        }
+        if (hi) {
+            kprintf("[WARN] %u modułów ponad %u – rezerwujemy je razem: %x - %x\n",
+                    mbi->mods_count - MB_MAX_MODS, MB_MAX_MODS, (unsigned)lo,
+                    (unsigned)(hi - 1));
+            add_reserved(out, lo, hi - lo);
+        }
+    }
+    return true;
+}
+
+static const char *type_name(uint32_t t) {
+    switch (t) {
+        case MB_MEM_AVAILABLE: return "RAM";
+        case MB_MEM_ACPI:      return "ACPI";
+        case MB_MEM_NVS:       return "ACPI NVS";
+        case MB_MEM_BADRAM:    return "uszkodzona";
+        default:               return "zarezerwowana";
+    }
+}
+
+void multiboot_dump(uint32_t magic, const multiboot_info_t *mbi) {
+    if (magic != MULTIBOOT_BOOT_MAGIC || !mbi) {
+        kprintf("[MEM] Brak informacji multiboot (magic=%x)\n", magic);
+        return;
+    }
+    if (mbi->flags & MB_INFO_MMAP) {
+        uintptr_t p = mbi->mmap_addr;
+        uintptr_t end = p + mbi->mmap_length;
+        while (p + sizeof(uint32_t) <= end) {
+            const multiboot_mmap_t *e = (const multiboot_mmap_t *)p;
+            if (e->addr >= LIMIT_4G)
+                kprintf("[MEM] (powyżej 4 GiB, %u MiB) %s\n",
+                        (unsigned)(e->len >> 20), type_name(e->type));
+            else
+                kprintf("[MEM] %x - %x %s\n", (unsigned)e->addr,
+                        (unsigned)(e->addr + e->len - 1), type_name(e->type));
+            p += e->size + sizeof(e->size);
+        }
+    }
+    if (mbi->flags & MB_INFO_MODS) {
+        const multiboot_module_t *m = (const multiboot_module_t *)mbi->mods_addr;
+        for (uint32_t i = 0; i < mbi->mods_count; i++)
+            kprintf("[MEM] moduł %x - %x %s\n", m[i].mod_start, m[i].mod_end,
+                    m[i].string ? (const char *)m[i].string : "");
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * [Cygnus] - [src/multiboot.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_MULTIBOOT_H
+#define CYGNUS_MULTIBOOT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "paging.h"
+
+/* Multiboot v1: informacja od bootloadera (GRUB) przekazana w %ebx. */
+
+#define MULTIBOOT_BOOT_MAGIC 0x2BADB002u
+
+/* bity multiboot_info_t.flags */
+#define MB_INFO_MEMORY  (1u << 0) /* mem_lower/mem_upper */
+#define MB_INFO_CMDLINE (1u << 2)
+#define MB_INFO_MODS    (1u << 3)
+#define MB_INFO_MMAP    (1u << 6)
+
+/* typy wpisów mapy pamięci */
+enum {
+    MB_MEM_AVAILABLE = 1,
+    MB_MEM_RESERVED  = 2,
+    MB_MEM_ACPI      = 3, /* ACPI reclaimable */
+    MB_MEM_NVS       = 4,
+    MB_MEM_BADRAM    = 5,
+};
+
+#pragma pack(push, 1)
+typedef struct {
+    uint32_t flags;
+    uint32_t mem_lower;   /* KiB poniżej 1 MiB */
+    uint32_t mem_upper;   /* KiB od 1 MiB do pierwszej dziury */
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+} multiboot_info_t;
+
+typedef struct {
+    uint32_t size;        /* rozmiar wpisu BEZ tego pola */
+    uint64_t addr;
+    uint64_t len;
+    uint32_t type;
+} multiboot_mmap_t;
+
+typedef struct {
+    uint32_t mod_start;
+    uint32_t mod_end;
+    uint32_t string;
+    uint32_t reserved;
+} multiboot_module_t;
+#pragma pack(pop)
+
+#define MB_MAX_RANGES 32 /* obsługiwane wpisy mapy pamięci */
+#define MB_MAX_MODS   8 /* osobno rezerwowane; dalsze – jednym zakresem */
+/* mapa, mbi, cmdline, tablica modułów, moduł + nazwa na każdy z
+ * MB_MAX_MODS i jeden zakres na resztę */
+#define MB_MAX_RESERVED (2 * MB_MAX_MODS + 5)
+
+typedef struct {
+    pmm_range_t usable[MB_MAX_RANGES];
+    uint32_t    n_usable;
+    /* moduły, struktury bootloadera – leżą w RAM, ale nie wolno ich oddać */
+    pmm_range_t reserved[MB_MAX_RESERVED];
+    uint32_t    n_reserved;
+    uint64_t    usable_bytes;
+    const multiboot_module_t *mods;
+    uint32_t    mods_count;
+} boot_mem_t;
+
+/* Wypełnia 'out' z informacji multiboot. Zwraca false, gdy magic się nie
+ * zgadza albo bootloader nie podał ani mapy, ani mem_upper – wtedy
+ * wołający zostaje przy domyślnym rozmiarze pamięci. */
+bool multiboot_parse(uint32_t magic, const multiboot_info_t *mbi,
+                     boot_mem_t *out);
+
+/* Wypisuje mapę pamięci i moduły. */
+void multiboot_dump(uint32_t magic, const multiboot_info_t *mbi);
+
+#endif /* CYGNUS_MULTIBOOT_H */
@@ -0,0 +1,377 @@
+/*
+ * [Cygnus] - [src/pagecache.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "pagecache.h"
+#include "kmalloc.h"
+#include "memstat.h"
+#include "paging.h"
+#include <stddef.h>
+#include <string.h>
+
+/* ===== Stałe ===== */
+#define PC_RADIX_BITS 6u
+#define PC_RADIX_SLOTS (1u << PC_RADIX_BITS)
+#define PC_RADIX_MASK (PC_RADIX_SLOTS - 1u)
+#define PC_HASH_BUCKETS 64u
+
+enum { PC_LRU_INACTIVE = 0, PC_LRU_ACTIVE = 1 };
+
+/* ===== Struktury ===== */
+
+typedef struct pc_node {
+  void *slots[PC_RADIX_SLOTS]; /* na poziomie 1: pc_page_t*, wyżej: pc_node* */
+  uint32_t count;
+} pc_node_t;
+
+typedef struct pc_mapping {
+  const void *vol;
+  uint32_t key;
+  uint32_t height; /* 0 = puste drzewo, 1 = root trzyma strony */
+  pc_node_t *root;
+  uint32_t nrpages;
+  struct pc_mapping *hnext;
+} pc_mapping_t;
+
+typedef struct pc_page {
+  pc_mapping_t *map;
+  uint32_t index;
+  uint8_t *data; /* ramka z PMM (tożsamościowo) */
+  struct pc_page *prev, *next;
+  uint8_t lru;
+  uint8_t referenced;
+} pc_page_t;
+
+typedef struct {
+  pc_page_t *head, *tail;
+  uint32_t n;
+} pc_list_t;
+
+/* Struktury cache mają własne cache slabów (kmalloc.h) */
+static kmem_cache_t *g_page_cache;
+static kmem_cache_t *g_node_cache;
+static kmem_cache_t *g_map_cache;
+
+static pc_mapping_t *g_buckets[PC_HASH_BUCKETS];
+static pc_list_t g_lru[2];
+static uint32_t g_limit;
+static uint32_t g_files;
+static uint32_t g_hits, g_misses, g_evictions;
+
+/* ===== Listy LRU ===== */
+
+static void lru_unlink(pc_page_t *pg) {
+  pc_list_t *l = &g_lru[pg->lru];
+  if (pg->prev) pg->prev->next = pg->next; else l->head = pg->next;
+  if (pg->next) pg->next->prev = pg->prev; else l->tail = pg->prev;
+  pg->prev = pg->next = NULL;
+  l->n--;
+}
+
+static void lru_push_head(pc_page_t *pg, uint8_t which) {
+  pc_list_t *l = &g_lru[which];
+  pg->lru = which;
+  pg->prev = NULL;
+  pg->next = l->head;
+  if (l->head) l->head->prev = pg; else l->tail = pg;
+  l->head = pg;
+  l->n++;
+}
+
+/* Kolejne odwołanie: strona nieaktywna dostaje bit referenced, a przy
+ * drugim odwołaniu przechodzi na listę aktywną. */
+static void page_touch(pc_page_t *pg) {
+  if (pg->lru == PC_LRU_INACTIVE && !pg->referenced) {
+    pg->referenced = 1;
+    return;
+  }
+  lru_unlink(pg);
+  pg->referenced = 0;
+  lru_push_head(pg, PC_LRU_ACTIVE);
+}
+
+/* ===== Drzewo radix ===== */
+
+static bool radix_fits(uint32_t height, uint32_t idx) {
+  uint32_t bits = height * PC_RADIX_BITS;
+  return bits >= 32 || idx < (1u << bits);
+}
+
+static uint32_t radix_slot(uint32_t idx, uint32_t level) {
+  return (idx >> ((level - 1) * PC_RADIX_BITS)) & PC_RADIX_MASK;
+}
+
+static pc_page_t *radix_lookup(const pc_mapping_t *m, uint32_t idx) {
+  if (!m->height || !radix_fits(m->height, idx)) return NULL;
+  pc_node_t *n = m->root;
+  for (uint32_t h = m->height; h > 1; h--) {
+    n = (pc_node_t *)n->slots[radix_slot(idx, h)];
+    if (!n) return NULL;
+  }
+  return (pc_page_t *)n->slots[idx & PC_RADIX_MASK];
+}
+
+static int radix_insert(pc_mapping_t *m, uint32_t idx, pc_page_t *pg) {
+  if (!m->height) {
+    m->root = (pc_node_t *)kmem_cache_zalloc(g_node_cache);
+    if (!m->root) return -1;
+    m->height = 1;
+  }
+  while (!radix_fits(m->height, idx)) {
+    pc_node_t *top = (pc_node_t *)kmem_cache_zalloc(g_node_cache);
+    if (!top) return -1;
+    top->slots[0] = m->root;
+    top->count = 1;
+    m->root = top;
+    m->height++;
+  }
+  pc_node_t *n = m->root;
+  for (uint32_t h = m->height; h > 1; h--) {
+    uint32_t s = radix_slot(idx, h);
+    if (!n->slots[s]) {
+      pc_node_t *c = (pc_node_t *)kmem_cache_zalloc(g_node_cache);
+      if (!c) return -1;
+      n->slots[s] = c;
+      n->count++;
+    }
+    n = (pc_node_t *)n->slots[s];
+  }
+  n->slots[idx & PC_RADIX_MASK] = pg;
+  n->count++;
+  return 0;
+}
+
+/* Zwraca true, jeżeli węzeł został pusty (wołający go zwalnia). */
+static bool radix_delete_rec(pc_node_t *n, uint32_t level, uint32_t idx) {
+  uint32_t s = radix_slot(idx, level);
+  if (level == 1) {
+    if (n->slots[s]) { n->slots[s] = NULL; n->count--; }
+  } else {
+    pc_node_t *c = (pc_node_t *)n->slots[s];
+    if (c && radix_delete_rec(c, level - 1, idx)) {
+      kmem_cache_free(g_node_cache, c);
+      n->slots[s] = NULL;
+      n->count--;
+    }
+  }
+  return n->count == 0;
+}
+
+static void radix_delete(pc_mapping_t *m, uint32_t idx) {
+  if (!m->height || !radix_fits(m->height, idx)) return;
+  if (radix_delete_rec(m->root, m->height, idx)) {
+    kmem_cache_free(g_node_cache, m->root);
+    m->root = NULL;
+    m->height = 0;
+  }
+}
+
+/* ===== Mapowania (plik -> drzewo) ===== */
+
+static uint32_t map_hash(const void *vol, uint32_t key) {
+  uint32_t h = key * 0x9E3779B1u ^ (uint32_t)(uintptr_t)vol;
+  return (h ^ (h >> 16)) % PC_HASH_BUCKETS;
+}
+
+static pc_mapping_t *mapping_find(const void *vol, uint32_t key) {
+  for (pc_mapping_t *m = g_buckets[map_hash(vol, key)]; m; m = m->hnext)
+    if (m->vol == vol && m->key == key) return m;
+  return NULL;
+}
+
+static pc_mapping_t *mapping_get(const void *vol, uint32_t key) {
+  pc_mapping_t *m = mapping_find(vol, key);
+  if (m) return m;
+  m = (pc_mapping_t *)kmem_cache_zalloc(g_map_cache);
+  if (!m) return NULL;
+  m->vol = vol;
+  m->key = key;
+  uint32_t b = map_hash(vol, key);
+  m->hnext = g_buckets[b];
+  g_buckets[b] = m;
+  g_files++;
+  return m;
+}
+
+static void mapping_destroy(pc_mapping_t *m) {
+  pc_mapping_t **pp = &g_buckets[map_hash(m->vol, m->key)];
+  while (*pp && *pp != m) pp = &(*pp)->hnext;
+  if (*pp) *pp = m->hnext;
+  g_files--;
+  kmem_cache_free(g_map_cache, m);
+}
+
+/* ===== Strony ===== */
+
+static uintptr_t frame_alloc(void) {
+  uintptr_t f = pmm_alloc_frame();
+  if (f) mem_account_alloc(MEM_PCACHE, PAGE_SIZE);
+  return f;
+}
+
+static void frame_free(uintptr_t f) {
+  pmm_free_frame(f);
+  mem_account_free(MEM_PCACHE, PAGE_SIZE);
+}
+
+static void page_release(pc_page_t *pg) {
+  pc_mapping_t *m = pg->map;
+  lru_unlink(pg);
+  radix_delete(m, pg->index);
+  frame_free((uintptr_t)pg->data);
+  kmem_cache_free(g_page_cache, pg);
+  if (--m->nrpages == 0) mapping_destroy(m);
+}
+
+/* Wybiera ofiarę: najpierw równoważymy listy (aktywna nie większa od
+ * nieaktywnej), potem bierzemy ogon nieaktywnej. Strona z bitem referenced
+ * dostaje drugą szansę na liście aktywnej. */
+static bool evict_one(void) {
+  for (;;) {
+    while (g_lru[PC_LRU_ACTIVE].n > g_lru[PC_LRU_INACTIVE].n) {
+      pc_page_t *pg = g_lru[PC_LRU_ACTIVE].tail;
+      lru_unlink(pg);
+      pg->referenced = 0;
+      lru_push_head(pg, PC_LRU_INACTIVE);
+    }
+    pc_page_t *victim = g_lru[PC_LRU_INACTIVE].tail;
+    if (!victim) return false;
+    if (victim->referenced) {
+      lru_unlink(victim);
+      victim->referenced = 0;
+      lru_push_head(victim, PC_LRU_ACTIVE);
+      continue;
+    }
+    page_release(victim);
+    g_evictions++;
+    return true;
+  }
+}
+
+static uint32_t resident(void) {
+  return g_lru[PC_LRU_ACTIVE].n + g_lru[PC_LRU_INACTIVE].n;
+}
+
+/* ===== API ===== */
+
+void pcache_init(uint32_t max_pages) {
+  memset(g_buckets, 0, sizeof(g_buckets));
+  memset(g_lru, 0, sizeof(g_lru));
+  g_limit = max_pages ? max_pages : 1;
+  g_files = 0;
+  g_hits = g_misses = g_evictions = 0;
+  if (!g_page_cache) {
+    g_page_cache = kmem_cache_create("pcache_page", sizeof(pc_page_t), 0);
+    g_node_cache = kmem_cache_create("pcache_node", sizeof(pc_node_t), 0);
+    g_map_cache = kmem_cache_create("pcache_map", sizeof(pc_mapping_t), 0);
+  }
+}
+
+const uint8_t *pcache_get(const void *vol, uint32_t file_key,
+                          uint32_t page_index, bool touch, pcache_fill_fn fill,
+                          void *ctx) {
+  pc_mapping_t *m = mapping_find(vol, file_key);
+  if (m) {
+    pc_page_t *pg = radix_lookup(m, page_index);
+    if (pg) {
+      g_hits++;
+      if (touch) page_touch(pg);
+      return pg->data;
+    }
+  }
+  g_misses++;
+
+  /* Najpierw robimy miejsce (wymiatanie może zwolnić mapowanie 'm'),
+   * dopiero potem szukamy/zakładamy mapowanie i wstawiamy stronę. */
+  while (resident() >= g_limit && evict_one()) { }
+  uintptr_t frame = frame_alloc();
+  while (!frame && evict_one()) frame = frame_alloc();
+  if (!frame) return NULL;
+
+  pc_page_t *pg = (pc_page_t *)kmem_cache_zalloc(g_page_cache);
+  if (!pg) {
+    frame_free(frame);
+    return NULL;
+  }
+  pg->data = (uint8_t *)frame;
+  pg->index = page_index;
+
+  if (fill(ctx, page_index, pg->data)) {
+    frame_free(frame);
+    kmem_cache_free(g_page_cache, pg);
+    return NULL;
+  }
+
+  m = mapping_get(vol, file_key);
+  if (!m || radix_insert(m, page_index, pg)) {
+    frame_free(frame);
+    kmem_cache_free(g_page_cache, pg);
+    if (m && !m->nrpages) mapping_destroy(m);
+    return NULL;
+  }
+  pg->map = m;
+  m->nrpages++;
+  lru_push_head(pg, PC_LRU_INACTIVE);
+  return pg->data;
+}
+
+static void release_tree(pc_node_t *n, uint32_t level) {
+  for (uint32_t s = 0; s < PC_RADIX_SLOTS && n->count; s++) {
+    void *p = n->slots[s];
+    if (!p) continue;
+    if (level == 1) {
+      pc_page_t *pg = (pc_page_t *)p;
+      lru_unlink(pg);
+      frame_free((uintptr_t)pg->data);
+      kmem_cache_free(g_page_cache, pg);
+    } else {
+      release_tree((pc_node_t *)p, level - 1);
+      kmem_cache_free(g_node_cache, p);
+    }
+    n->slots[s] = NULL;
+    n->count--;
+  }
+}
+
+void pcache_invalidate_file(const void *vol, uint32_t file_key) {
+  pc_mapping_t *m = mapping_find(vol, file_key);
+  if (!m) return;
+  if (m->height) {
+    release_tree(m->root, m->height);
+    kmem_cache_free(g_node_cache, m->root);
+  }
+  mapping_destroy(m);
+}
+
+void pcache_drop_all(void) {
+  for (uint32_t b = 0; b < PC_HASH_BUCKETS; b++)
+    while (g_buckets[b])
+      pcache_invalidate_file(g_buckets[b]->vol, g_buckets[b]->key);
+}
+
+void pcache_get_stats(pcache_stats_t *out) {
+  out->resident = resident();
+  out->limit = g_limit;
+  out->active = g_lru[PC_LRU_ACTIVE].n;
+  out->inactive = g_lru[PC_LRU_INACTIVE].n;
+  out->files = g_files;
+  out->hits = g_hits;
+  out->misses = g_misses;
+  out->evictions = g_evictions;
+}
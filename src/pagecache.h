@@ -0,0 +1,73 @@
+/*
+ * [Cygnus] - [src/pagecache.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_PAGECACHE_H
+#define CYGNUS_PAGECACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Wspólny cache stron dla danych plików.
+ *
+ * Kluczem jest para (plik, indeks strony), gdzie plik to (wolumin, klucz
+ * pliku) – dla FAT32 kluczem jest pierwszy klaster łańcucha. Każda strona
+ * to jedna ramka 4 KiB z PMM. Strony jednego pliku trzymamy w drzewie radix
+ * (64 sloty na węzeł), a wymiatamy je polityką dwóch list (inactive/active):
+ * strona trafia najpierw na listę nieaktywną i dopiero ponowne użycie
+ * przenosi ją na aktywną, więc jednorazowy skan dużego pliku nie wypycha
+ * gorących danych.
+ */
+
+/* Wypełnia stronę 'page' (4 KiB) danymi pliku dla indeksu 'page_index'.
+ * Zwraca 0 gdy OK. */
+typedef int (*pcache_fill_fn)(void *ctx, uint32_t page_index, uint8_t *page);
+
+typedef struct {
+  uint32_t resident;  /* strony w cache */
+  uint32_t limit;     /* maksymalna liczba stron */
+  uint32_t active;    /* strony na liście aktywnej */
+  uint32_t inactive;  /* strony na liście nieaktywnej */
+  uint32_t files;     /* pliki z przynajmniej jedną stroną */
+  uint32_t hits;
+  uint32_t misses;
+  uint32_t evictions;
+} pcache_stats_t;
+
+/* Inicjalizacja; 'max_pages' ogranicza liczbę ramek zajętych przez cache. */
+void pcache_init(uint32_t max_pages);
+
+/* Zwraca wskaźnik na dane strony (4 KiB) albo NULL przy błędzie.
+ * Przy chybieniu ramka jest wypełniana przez 'fill'. 'touch' mówi, czy to
+ * nowe odwołanie do strony (false dla kolejnych odczytów tej samej strony
+ * przez ten sam uchwyt – nie promują one strony na listę aktywną).
+ * Wskaźnik jest ważny do następnego wywołania API cache. */
+const uint8_t *pcache_get(const void *vol, uint32_t file_key,
+                          uint32_t page_index, bool touch, pcache_fill_fn fill,
+                          void *ctx);
+
+/* Wyrzuca wszystkie strony danego pliku (np. po przeniesieniu klastrów). */
+void pcache_invalidate_file(const void *vol, uint32_t file_key);
+
+/* Wyrzuca wszystkie strony (np. przed pomiarem odczytu z dysku). */
+void pcache_drop_all(void);
+
+void pcache_get_stats(pcache_stats_t *out);
+
+#endif /* CYGNUS_PAGECACHE_H */
@@ -19,25 +19,10 @@
  * limitations under the Licence.
  */
 #include "paging.h"
-
-/* We avoid libc; provide tiny memset/memset32/memcpy. */
-static void *k_memset(void *dst, int v, size_t n) {
-  uint8_t *d = (uint8_t *)dst;
-  for (size_t i = 0; i < n; ++i)
-    d[i] = (uint8_t)v;
-  return dst;
-}
-static void k_memset32(uint32_t *dst, uint32_t v, size_t n_words) {
-  for (size_t i = 0; i < n_words; ++i)
-    dst[i] = v;
-}
-static void *k_memcpy(void *dst, const void *src, size_t n) {
-  uint8_t *d = (uint8_t *)dst;
-  const uint8_t *s = (const uint8_t *)src;
-  for (size_t i = 0; i < n; ++i)
-    d[i] = s[i];
-  return dst;
-}
+#include "cpu.h"
+#include "memstat.h"
+#include <string.h>
+#include "../inc/std.h"
 
 /* Align helpers */
 static inline uintptr_t align_down(uintptr_t x, uintptr_t a) {
@@ -110,28 +95,285 @@ static size_t fb_find_first_zero_from(size_t start_f) {
   return (size_t)-1;
 }
 
+/* ====== Buddy allocator ======
+   The bitmap above only records reserved regions (low memory, kernel image,
+   holes); allocation state lives in per-order free lists. Free blocks are
+   linked through their own first bytes (frames are reachable by physical
+   address, see get_pte), and a per-order "free head" bitmap tells whether
+   the buddy of a block is free at the same order, so alloc and free are
+   O(PMM_MAX_ORDER).
+*/
+typedef struct free_block {
+  struct free_block *next;
+  struct free_block *prev;
+} free_block_t;
+
+static free_block_t *free_list[PMM_MAX_ORDER + 1];
+static uint32_t free_count[PMM_MAX_ORDER + 1];
+static uint32_t *head_bits[PMM_MAX_ORDER + 1]; /* bit (f >> k) set = free head */
+static size_t free_frames = 0;
+static bool buddy_ready = false;
+
+static inline bool hb_test(unsigned k, size_t f) {
+  size_t i = f >> k;
+  return (head_bits[k][i >> 5] >> (i & 31u)) & 1u;
+}
+static inline void hb_set(unsigned k, size_t f) {
+  size_t i = f >> k;
+  head_bits[k][i >> 5] |= 1u << (i & 31u);
+}
+static inline void hb_clear(unsigned k, size_t f) {
+  size_t i = f >> k;
+  head_bits[k][i >> 5] &= ~(1u << (i & 31u));
+}
+
+static void fl_push(unsigned k, size_t f) {
+  free_block_t *b = (free_block_t *)frame_to_phys(f);
+  b->prev = NULL;
+  b->next = free_list[k];
+  if (b->next)
+    b->next->prev = b;
+  free_list[k] = b;
+  free_count[k]++;
+  hb_set(k, f);
+}
+static void fl_remove(unsigned k, size_t f) {
+  free_block_t *b = (free_block_t *)frame_to_phys(f);
+  if (b->prev)
+    b->prev->next = b->next;
+  else
+    free_list[k] = b->next;
+  if (b->next)
+    b->next->prev = b->prev;
+  free_count[k]--;
+  hb_clear(k, f);
+}
+
+/* Insert a free block of order k at frame f, merging with free buddies. */
+static void buddy_insert(size_t f, unsigned k) {
+  while (k < PMM_MAX_ORDER) {
+    size_t buddy = f ^ ((size_t)1 << k);
+    if (buddy + ((size_t)1 << k) > total_frames || !hb_test(k, buddy))
+      break;
+    fl_remove(k, buddy);
+    f &= ~((size_t)1 << k);
+    k++;
+  }
+  fl_push(k, f);
+}
+
+/* Take frame f out of whichever free block contains it (region marking after
+ * the buddy lists are built). Returns false if f was not free. */
+static bool buddy_take_frame(size_t f) {
+  for (unsigned k = 0; k <= PMM_MAX_ORDER; k++) {
+    size_t head = f & ~(((size_t)1 << k) - 1u);
+    if (head + ((size_t)1 << k) > total_frames || !hb_test(k, head))
+      continue;
+    fl_remove(k, head);
+    /* give back every half that does not contain f */
+    while (k > 0) {
+      k--;
+      size_t half = (size_t)1 << k;
+      if (f >= head + half) {
+        fl_push(k, head);
+        head += half;
+      } else {
+        fl_push(k, head + half);
+      }
+    }
+    free_frames--;
+    return true;
+  }
+  return false;
+}
+
+/* Build free lists from the bitmap: every clear bit becomes free memory. */
+static void buddy_build(void) {
+  size_t f = 0;
+  while (f < total_frames) {
+    if (fb_test(f)) {
+      f++;
+      continue;
+    }
+    /* largest aligned, fully free block starting at f */
+    unsigned k = 0;
+    while (k < PMM_MAX_ORDER && !(f & ((size_t)1 << k)) &&
+           f + ((size_t)2 << k) <= total_frames) {
+      size_t n = (size_t)1 << k, i;
+      for (i = f + n; i < f + 2 * n && !fb_test(i); i++)
+        ;
+      if (i != f + 2 * n)
+        break;
+      k++;
+    }
+    fl_push(k, f);
+    free_frames += (size_t)1 << k;
+    f += (size_t)1 << k;
+  }
+  buddy_ready = true;
+}
+
+/* Carve the per-order head bitmaps out of free frames (found by the old
+ * first-fit scan, only used here at boot). */
+static bool buddy_alloc_meta(void) {
+  size_t words = 0;
+  for (unsigned k = 0; k <= PMM_MAX_ORDER; k++)
+    words += ((total_frames >> k) + 32u) / 32u;
+  size_t need = align_up(words * 4u, PAGE_SIZE) / PAGE_SIZE;
+
+  size_t f = fb_find_first_zero_from(first_usable_frame);
+  while (f != (size_t)-1) {
+    size_t i = f;
+    while (i < f + need && i < total_frames && !fb_test(i))
+      i++;
+    if (i == f + need)
+      break;
+    f = fb_find_first_zero_from(i + 1);
+  }
+  if (f == (size_t)-1)
+    return false;
+
+  uint32_t *p = (uint32_t *)frame_to_phys(f);
+  memset(p, 0, need * PAGE_SIZE);
+  for (unsigned k = 0; k <= PMM_MAX_ORDER; k++) {
+    head_bits[k] = p;
+    p += ((total_frames >> k) + 32u) / 32u;
+  }
+  for (size_t i = f; i < f + need; i++)
+    fb_set(i);
+  mem_account_alloc(MEM_PMM_META, need * PAGE_SIZE);
+  return true;
+}
+
+/* ====== Pre-zeroed frames ======
+   A small stack of frames zeroed ahead of time by pmm_zero_idle (registered
+   as an idle hook), so page tables and demand-zero pages don't pay for a
+   4 KiB clear on the allocation path. The background fill uses non-temporal
+   stores when SSE2 is there: those frames are not touched again soon and
+   shouldn't push hot data out of the cache. The synchronous fallback uses
+   rep stosd, since its frame is written right after. Pool frames count as
+   allocated; pmm_alloc_pages still takes them when the buddy lists run dry.
+*/
+static uintptr_t zero_pool[PMM_ZERO_POOL];
+static uint32_t zero_count = 0;
+static uint32_t zero_hits = 0;
+static uint32_t zero_misses = 0;
+static bool use_movnti = false;
+
+static void zero_frame_stosd(uintptr_t phys) {
+  void *d = (void *)phys;
+  size_t n = PAGE_SIZE / 4;
+  __asm__ volatile("rep stosl" : "+D"(d), "+c"(n) : "a"(0) : "memory");
+}
+
+static void zero_frame_nt(uintptr_t phys) {
+  uint32_t *d = (uint32_t *)phys;
+  for (size_t i = 0; i < PAGE_SIZE / 4; i += 4)
+    __asm__ volatile("movnti %1, (%0)\n\t"
+                     "movnti %1, 4(%0)\n\t"
+                     "movnti %1, 8(%0)\n\t"
+                     "movnti %1, 12(%0)"
+                     :
+                     : "r"(d + i), "r"(0u)
+                     : "memory");
+  /* make the weakly-ordered stores visible before the frame is handed out */
+  __asm__ volatile("sfence" ::: "memory");
+}
+
+static uintptr_t zero_pool_take(void) {
+  if (!zero_count)
+    return 0;
+  mem_account_free(MEM_ZERO_POOL, PAGE_SIZE);
+  return zero_pool[--zero_count];
+}
+
+uintptr_t pmm_alloc_zeroed(void) {
+  uintptr_t phys = zero_pool_take();
+  if (phys) {
+    zero_hits++;
+    return phys;
+  }
+  zero_misses++;
+  phys = pmm_alloc_pages(0);
+  if (phys)
+    zero_frame_stosd(phys);
+  return phys;
+}
+
+bool pmm_zero_idle(void) {
+  bool worked = false;
+  for (unsigned i = 0; i < PMM_ZERO_BATCH && zero_count < PMM_ZERO_POOL;
+       ++i) {
+    /* keep some slack: the pool must not eat the last free frames */
+    if (free_frames <= PMM_ZERO_POOL)
+      break;
+    uintptr_t phys = pmm_alloc_pages(0);
+    if (!phys)
+      break;
+    if (use_movnti)
+      zero_frame_nt(phys);
+    else
+      zero_frame_stosd(phys);
+    zero_pool[zero_count++] = phys;
+    mem_account_alloc(MEM_ZERO_POOL, PAGE_SIZE);
+    worked = true;
+  }
+  return worked;
+}
+
 /* Public PMM API */
-uintptr_t pmm_alloc_frame(void) {
-  size_t idx = fb_find_first_zero_from(first_usable_frame);
-  if (idx == (size_t)-1)
+uintptr_t pmm_alloc_pages(unsigned order) {
+  if (!buddy_ready || order > PMM_MAX_ORDER)
     return 0;
-  fb_set(idx);
-  return frame_to_phys(idx);
+  unsigned k = order;
+  while (k <= PMM_MAX_ORDER && !free_list[k])
+    k++;
+  if (k > PMM_MAX_ORDER)
+    /* last resort: a frame parked in the zero pool is still a free frame */
+    return order == 0 ? zero_pool_take() : 0;
+
+  size_t f = phys_to_frame((uintptr_t)free_list[k]);
+  fl_remove(k, f);
+  /* split: keep the lower half, return upper halves to their lists */
+  while (k > order) {
+    k--;
+    fl_push(k, f + ((size_t)1 << k));
+  }
+  free_frames -= (size_t)1 << order;
+  return frame_to_phys(f);
 }
-void pmm_free_frame(uintptr_t phys) {
-  if (!phys)
+void pmm_free_pages(uintptr_t phys, unsigned order) {
+  if (!phys || order > PMM_MAX_ORDER)
     return;
   size_t f = phys_to_frame(phys);
-  if (f < total_frames)
-    fb_clear(f);
+  if (f + ((size_t)1 << order) > total_frames || (f & (((size_t)1 << order) - 1u)))
+    return;
+  free_frames += (size_t)1 << order;
+  buddy_insert(f, order);
+}
+uintptr_t pmm_alloc_frame(void) { return pmm_alloc_pages(0); }
+void pmm_free_frame(uintptr_t phys) { pmm_free_pages(phys, 0); }
+
+void pmm_get_stats(pmm_stats_t *out) {
+  out->total_frames = (uint32_t)total_frames;
+  out->free_frames = (uint32_t)free_frames;
+  for (unsigned k = 0; k <= PMM_MAX_ORDER; k++)
+    out->free_blocks[k] = free_count[k];
+  out->zero_pool = zero_count;
+  out->zero_hits = zero_hits;
+  out->zero_misses = zero_misses;
 }
+
 void pmm_mark_region_used(uintptr_t start, uintptr_t end) {
   start = align_down(start, PAGE_SIZE);
   end = align_up(end, PAGE_SIZE);
   for (uintptr_t p = start; p < end; p += PAGE_SIZE) {
     size_t f = phys_to_frame(p);
-    if (f < total_frames)
+    if (f < total_frames) {
       fb_set(f);
+      if (buddy_ready)
+        buddy_take_frame(f);
+    }
   }
 }
 void pmm_mark_region_free(uintptr_t start, uintptr_t end) {
@@ -139,8 +381,13 @@ void pmm_mark_region_free(uintptr_t start, uintptr_t end) {
   end = align_up(end, PAGE_SIZE);
   for (uintptr_t p = start; p < end; p += PAGE_SIZE) {
     size_t f = phys_to_frame(p);
-    if (f < total_frames)
+    if (f < total_frames && fb_test(f)) {
       fb_clear(f);
+      if (buddy_ready) {
+        free_frames++;
+        buddy_insert(f, 0);
+      }
+    }
   }
 }
 
@@ -154,41 +401,200 @@ static
 /* We allocate page tables on demand (each is 4KiB, aligned), grabbing frames
  * via PMM. */
 
+/* 4 MiB pages (CR4.PSE) and global pages (CR4.PGE), if the CPU has them */
+#define LARGE_PAGE_SIZE 0x400000u
+#define LARGE_PAGE_MASK (~(LARGE_PAGE_SIZE - 1u))
+#define PAT_TYPE_WC 0x01ull
+static bool use_pse = false;
+static bool use_pge = false;
+static bool use_pat_wc = false; /* PAT entry 1 (PWT=1, PCD=0) = WC */
+static uint32_t pt_frames = 0;   /* frames used by page tables */
+static uint32_t large_pages = 0; /* present 4 MiB PDEs */
+
+/* ====== CRx helpers ====== */
+static inline void write_cr3(uintptr_t phys) {
+  __asm__ volatile("mov %0, %%cr3" ::"r"(phys) : "memory");
+}
+static inline uintptr_t read_cr0(void) {
+  uintptr_t v;
+  __asm__ volatile("mov %%cr0, %0" : "=r"(v));
+  return v;
+}
+static inline void write_cr0(uintptr_t v) {
+  __asm__ volatile("mov %0, %%cr0" ::"r"(v) : "memory");
+}
+static inline uintptr_t read_cr4(void) {
+  uintptr_t v;
+  __asm__ volatile("mov %%cr4, %0" : "=r"(v));
+  return v;
+}
+static inline void write_cr4(uintptr_t v) {
+  __asm__ volatile("mov %0, %%cr4" ::"r"(v) : "memory");
+}
+
+/* Invalidate one page */
+void paging_invalidate(uintptr_t virt) {
+  __asm__ volatile("invlpg (%0)" ::"r"(virt) : "memory");
+}
+
+/* ====== Batched TLB invalidation ======
+   Range operations record the pages they change in a paging_tlb_batch_t and
+   flush once at the end: a few invlpg for a short batch, a full flush past
+   PAGING_TLB_BATCH pages. Frames that were mapped are freed only after the
+   flush, so nothing can reach a reused frame through a stale TLB entry. On
+   SMP, batch_flush is the single place to send one shootdown IPI for the
+   whole batch. */
+static uint32_t tlb_batches = 0;
+static uint32_t tlb_invlpg = 0;
+static uint32_t tlb_full_flushes = 0;
+
+/* Drop every TLB entry. A CR3 reload keeps global entries; toggling CR4.PGE
+ * drops those too. */
+static void tlb_flush_all(bool global) {
+  if (global && use_pge) {
+    uintptr_t cr4 = read_cr4();
+    write_cr4(cr4 & ~CR4_PGE);
+    write_cr4(cr4);
+  } else {
+    write_cr3((uintptr_t)kernel_page_directory);
+  }
+}
+
+static void batch_flush(paging_tlb_batch_t *b) {
+  if (b->full) {
+    tlb_flush_all(b->global);
+    tlb_full_flushes++;
+  } else {
+    for (uint32_t i = 0; i < b->count; ++i)
+      paging_invalidate(b->va[i]);
+    tlb_invlpg += b->count;
+  }
+  if (b->count || b->full)
+    tlb_batches++;
+
+  for (uint32_t i = 0; i < b->n_free; ++i) {
+    uintptr_t p = b->free_phys[i];
+    /* bit 0 marks a 4 MiB block */
+    pmm_free_pages(p & PAGE_MASK, (p & 1u) ? PMM_MAX_ORDER : 0);
+  }
+  b->count = 0;
+  b->n_free = 0;
+  b->full = false;
+  b->global = false;
+}
+
+/* Record that the translation for 'virt' changed. Without a batch the entry
+ * is invalidated right away. */
+static void tlb_add(paging_tlb_batch_t *b, uintptr_t virt, bool global) {
+  if (!b) {
+    paging_invalidate(virt);
+    tlb_invlpg++;
+    return;
+  }
+  b->global |= global;
+  if (b->full)
+    return;
+  if (b->count == PAGING_TLB_BATCH) {
+    b->full = true;
+    return;
+  }
+  b->va[b->count++] = virt;
+}
+
+/* Free a frame that was mapped until now; 'large' = 4 MiB block. */
+static void tlb_free(paging_tlb_batch_t *b, uintptr_t phys, bool large) {
+  if (!b) {
+    pmm_free_pages(phys, large ? PMM_MAX_ORDER : 0);
+    return;
+  }
+  if (b->n_free == PAGING_TLB_FREE_MAX)
+    batch_flush(b);
+  b->free_phys[b->n_free++] = phys | (large ? 1u : 0u);
+}
+
+void paging_batch_begin(paging_tlb_batch_t *b) {
+  b->count = 0;
+  b->n_free = 0;
+  b->full = false;
+  b->global = false;
+}
+
+void paging_batch_finish(paging_tlb_batch_t *b) { batch_flush(b); }
+
 /* Helpers to access PDE/PTE */
 static inline pde_t *current_pdir(void) { return kernel_page_directory; }
 
+/* Allocate and zero a page table frame. */
+static uintptr_t alloc_pt(void) {
+  /* Frames are reachable by physical address: before paging_enable trivially,
+     after it through the direct map built by paging_setup. */
+  uintptr_t pt_phys = pmm_alloc_zeroed();
+  if (!pt_phys)
+    return 0;
+  pt_frames++;
+  mem_account_alloc(MEM_PAGETABLES, PAGE_SIZE);
+  return pt_phys;
+}
+
+/* Replace a 4 MiB PDE with a page table holding the same 1024 mappings, so a
+ * part of it can be changed. Returns false on OOM. */
+static bool split_large(uint32_t pd_index) {
+  pde_t *pdir = current_pdir();
+  pde_t pde = pdir[pd_index];
+  /* every entry gets written below, no need for a zeroed frame */
+  uintptr_t pt_phys = pmm_alloc_frame();
+  if (!pt_phys)
+    return false;
+  pt_frames++;
+  mem_account_alloc(MEM_PAGETABLES, PAGE_SIZE);
+
+  /* PDE bit 7 is PS, PTE bit 7 is PAT: keep only the flags both share */
+  uint32_t flags = pde & (PG_RW | PG_USER | PG_PWT | PG_PCD | PG_GLOBAL);
+  uintptr_t base = (uintptr_t)(pde & LARGE_PAGE_MASK);
+  pte_t *pt = (pte_t *)pt_phys;
+  for (uint32_t i = 0; i < ENTRIES_PER_TABLE; ++i)
+    pt[i] = (pte_t)((base + i * PAGE_SIZE) | flags | PG_PRESENT);
+
+  pdir[pd_index] = (pde_t)(pt_phys | PG_PRESENT | PG_RW | (pde & PG_USER));
+  large_pages--;
+  /* one invlpg drops the whole 4 MiB TLB entry */
+  paging_invalidate((uintptr_t)pd_index << 22);
+  return true;
+}
+
 static pte_t *get_pte(uintptr_t virt, bool create_table) {
   pde_t *pdir = current_pdir();
   uint32_t pd_index = (virt >> 22) & 0x3FFu;
   uint32_t pt_index = (virt >> 12) & 0x3FFu;
 
   pde_t pde = pdir[pd_index];
+  if ((pde & (PG_PRESENT | PG_PS)) == (PG_PRESENT | PG_PS)) {
+    /* 4 MiB page: only split it when the caller wants to change a PTE */
+    if (!create_table || !split_large(pd_index))
+      return NULL;
+    pde = pdir[pd_index];
+  }
   if (!(pde & PG_PRESENT)) {
     if (!create_table)
       return NULL;
 
     /* allocate a physical frame for the PT */
-    uintptr_t pt_phys = pmm_alloc_frame();
+    uintptr_t pt_phys = alloc_pt();
     if (!pt_phys)
       return NULL;
 
-    /* map the PT temporarily to zero it: we'll identity-map PTs to simplify */
-    /* Since paging may not be enabled yet during setup, memset by physical
-       address is fine here because kernel runs identity-mapped during setup.
-       After enable, all PT frames we allocate are also identity-mapped by
-       design of paging_setup's identity range covering kernel end. */
-    k_memset((void *)pt_phys, 0, PAGE_SIZE);
-
     /* present, RW, supervisor */
-    pdir[pd_index] = (pde_t)(pt_phys | PG_PRESENT | PG_RW);
+    pde = (pde_t)(pt_phys | PG_PRESENT | PG_RW);
+    pdir[pd_index] = pde;
   }
 
   uintptr_t pt_phys = (uintptr_t)(pde & PAGE_MASK);
-  pte_t *pt = (pte_t *)pt_phys; /* identity assumption for paging_setup */
+  pte_t *pt = (pte_t *)pt_phys; /* identity / direct map */
   return &pt[pt_index];
 }
 
-void paging_map_page(uintptr_t phys, uintptr_t virt, uint32_t flags) {
+static void map_page(paging_tlb_batch_t *b, uintptr_t phys, uintptr_t virt,
+                     uint32_t flags) {
   phys = align_down(phys, PAGE_SIZE);
   virt = align_down(virt, PAGE_SIZE);
 
@@ -196,48 +602,157 @@ void paging_map_page(uintptr_t phys, uintptr_t virt, uint32_t flags) {
   if (!pte)
     return; /* optionally assert/panic */
 
+  if (!use_pge)
+    flags &= ~PG_GLOBAL;
+  pte_t old = *pte;
   *pte = (pte_t)(phys | (flags | PG_PRESENT));
 
-  /* tlb shootdown for this VA */
-  paging_invalidate(virt);
+  /* not-present entries are never cached, so a fresh mapping needs no flush */
+  if (old & PG_PRESENT)
+    tlb_add(b, virt, (old & PG_GLOBAL) != 0);
 }
 
-void paging_unmap_page(uintptr_t virt, bool own_frame) {
+void paging_map_page(uintptr_t phys, uintptr_t virt, uint32_t flags) {
+  map_page(NULL, phys, virt, flags);
+}
+
+void paging_batch_map_page(paging_tlb_batch_t *b, uintptr_t phys,
+                           uintptr_t virt, uint32_t flags) {
+  map_page(b, phys, virt, flags);
+}
+
+/* Map one 4 MiB page; both addresses must be 4 MiB aligned. */
+static void map_large(paging_tlb_batch_t *b, uintptr_t phys, uintptr_t virt,
+                      uint32_t flags) {
+  pde_t *pdir = current_pdir();
+  uint32_t pd_index = (virt >> 22) & 0x3FFu;
+  pde_t old = pdir[pd_index];
+
+  if (!use_pge)
+    flags &= ~PG_GLOBAL;
+  pdir[pd_index] = (pde_t)(phys | flags | PG_PRESENT | PG_PS);
+  large_pages++;
+  if (!(old & PG_PRESENT))
+    return;
+  if (old & PG_PS) {
+    /* one invlpg drops the whole 4 MiB TLB entry */
+    large_pages--;
+    tlb_add(b, virt, (old & PG_GLOBAL) != 0);
+    return;
+  }
+  /* The page table it replaces may back up to 1024 cached entries, global
+   * ones included: flush everything before its frame can be reused. */
+  if (b) {
+    b->full = true;
+    b->global = true;
+  } else {
+    tlb_flush_all(true);
+    tlb_full_flushes++;
+  }
+  tlb_free(b, (uintptr_t)(old & PAGE_MASK), false);
+  pt_frames--;
+  mem_account_free(MEM_PAGETABLES, PAGE_SIZE);
+}
+
+static void unmap_page(paging_tlb_batch_t *b, uintptr_t virt, bool own_frame) {
   virt = align_down(virt, PAGE_SIZE);
-  pte_t *pte = get_pte(virt, /*create_table=*/false);
+  pde_t pde = current_pdir()[(virt >> 22) & 0x3FFu];
+  /* a 4 MiB page has to be split before one 4 KiB piece can go */
+  pte_t *pte = get_pte(virt, (pde & PG_PS) != 0);
   if (!pte)
     return;
-  if (*pte & PG_PRESENT) {
-    uintptr_t phys = (uintptr_t)(*pte & PAGE_MASK);
+  pte_t old = *pte;
+  if (old & PG_PRESENT) {
     *pte = 0;
-    paging_invalidate(virt);
+    tlb_add(b, virt, (old & PG_GLOBAL) != 0);
     if (own_frame)
-      pmm_free_frame(phys);
+      tlb_free(b, (uintptr_t)(old & PAGE_MASK), false);
   }
 }
 
-void paging_map_range(uintptr_t phys_start, uintptr_t virt_start, size_t size,
-                      uint32_t flags) {
+void paging_unmap_page(uintptr_t virt, bool own_frame) {
+  unmap_page(NULL, virt, own_frame);
+}
+
+void paging_batch_unmap_page(paging_tlb_batch_t *b, uintptr_t virt,
+                             bool own_frame) {
+  unmap_page(b, virt, own_frame);
+}
+
+/* Can [v, end) take a 4 MiB page at v for phys p? */
+static inline bool large_fits(uintptr_t p, uintptr_t v, uintptr_t end) {
+  return use_pse && !(p & ~LARGE_PAGE_MASK) && !(v & ~LARGE_PAGE_MASK) &&
+         end - v >= LARGE_PAGE_SIZE;
+}
+
+void paging_batch_map_range(paging_tlb_batch_t *b, uintptr_t phys_start,
+                            uintptr_t virt_start, size_t size, uint32_t flags) {
   uintptr_t p = align_down(phys_start, PAGE_SIZE);
   uintptr_t v = align_down(virt_start, PAGE_SIZE);
   uintptr_t end = align_up(virt_start + size, PAGE_SIZE);
   while (v < end) {
-    paging_map_page(p, v, flags);
+    if (large_fits(p, v, end)) {
+      map_large(b, p, v, flags);
+      p += LARGE_PAGE_SIZE;
+      v += LARGE_PAGE_SIZE;
+      continue;
+    }
+    map_page(b, p, v, flags);
     p += PAGE_SIZE;
     v += PAGE_SIZE;
   }
 }
 
-void paging_unmap_range(uintptr_t virt_start, size_t size, bool own_frames) {
+void paging_batch_unmap_range(paging_tlb_batch_t *b, uintptr_t virt_start,
+                              size_t size, bool own_frames) {
   uintptr_t v = align_down(virt_start, PAGE_SIZE);
   uintptr_t end = align_up(virt_start + size, PAGE_SIZE);
   while (v < end) {
-    paging_unmap_page(v, own_frames);
+    pde_t *pde = &current_pdir()[(v >> 22) & 0x3FFu];
+    if ((*pde & PG_PS) && !(v & ~LARGE_PAGE_MASK) &&
+        end - v >= LARGE_PAGE_SIZE) {
+      /* whole 4 MiB page goes at once */
+      pde_t old = *pde;
+      *pde = 0;
+      large_pages--;
+      tlb_add(b, v, (old & PG_GLOBAL) != 0);
+      if (own_frames)
+        tlb_free(b, (uintptr_t)(old & LARGE_PAGE_MASK), true);
+      v += LARGE_PAGE_SIZE;
+      continue;
+    }
+    if (!(*pde & PG_PRESENT)) {
+      /* nothing mapped in this 4 MiB slot */
+      uintptr_t next = (v & LARGE_PAGE_MASK) + LARGE_PAGE_SIZE;
+      if (next < v)
+        break; /* wrapped past 4 GiB */
+      v = next;
+      continue;
+    }
+    unmap_page(b, v, own_frames);
     v += PAGE_SIZE;
   }
 }
 
+void paging_map_range(uintptr_t phys_start, uintptr_t virt_start, size_t size,
+                      uint32_t flags) {
+  paging_tlb_batch_t b;
+  paging_batch_begin(&b);
+  paging_batch_map_range(&b, phys_start, virt_start, size, flags);
+  paging_batch_finish(&b);
+}
+
+void paging_unmap_range(uintptr_t virt_start, size_t size, bool own_frames) {
+  paging_tlb_batch_t b;
+  paging_batch_begin(&b);
+  paging_batch_unmap_range(&b, virt_start, size, own_frames);
+  paging_batch_finish(&b);
+}
+
 uintptr_t paging_virt_to_phys(uintptr_t virt) {
+  pde_t pde = current_pdir()[(virt >> 22) & 0x3FFu];
+  if ((pde & (PG_PRESENT | PG_PS)) == (PG_PRESENT | PG_PS))
+    return (uintptr_t)(pde & LARGE_PAGE_MASK) | (virt & ~LARGE_PAGE_MASK);
   pte_t *pte = get_pte(virt, /*create_table=*/false);
   if (!pte)
     return 0;
@@ -247,60 +762,141 @@ uintptr_t paging_virt_to_phys(uintptr_t virt) {
   return phys_page | (virt & (PAGE_SIZE - 1u));
 }
 
-/* ====== CRx helpers ====== */
-static inline void write_cr3(uintptr_t phys) {
-  __asm__ volatile("mov %0, %%cr3" ::"r"(phys) : "memory");
-}
-static inline uintptr_t read_cr0(void) {
-  uintptr_t v;
-  __asm__ volatile("mov %%cr0, %0" : "=r"(v));
-  return v;
-}
-static inline void write_cr0(uintptr_t v) {
-  __asm__ volatile("mov %0, %%cr0" ::"r"(v) : "memory");
-}
-
-/* Invalidate one page */
-void paging_invalidate(uintptr_t virt) {
-  __asm__ volatile("invlpg (%0)" ::"r"(virt) : "memory");
+/* ====== Setup & enable ====== */
+static uintptr_t clamp_phys(uint64_t x) {
+  return x > MAX_PHYS_BYTES - PAGE_SIZE ? (uintptr_t)(MAX_PHYS_BYTES - PAGE_SIZE)
+                                        : (uintptr_t)x;
 }
 
-/* ====== Setup & enable ====== */
-void paging_setup(uintptr_t kernel_phys_start, uintptr_t kernel_phys_end,
-                  uintptr_t phys_mem_top) {
-  /* Initialize PMM bitmap. Everything starts 'used', then we free [0,
-   * phys_mem_top) and re-mark kernel used. */
-  total_frames = (size_t)(phys_mem_top >> PAGE_SHIFT);
+void paging_setup_mmap(uintptr_t kernel_phys_start, uintptr_t kernel_phys_end,
+                       const pmm_range_t *usable, size_t n_usable,
+                       const pmm_range_t *reserved, size_t n_reserved) {
+  /* The bitmap covers frames up to the end of the highest usable range */
+  uint64_t top = 0;
+  for (size_t i = 0; i < n_usable; ++i)
+    if (usable[i].base + usable[i].len > top)
+      top = usable[i].base + usable[i].len;
+  total_frames = (size_t)(top >> PAGE_SHIFT);
   if (total_frames > MAX_FRAMES)
     total_frames = MAX_FRAMES;
 
-  k_memset32(frame_bitmap, 0xFFFFFFFFu, BITMAP_WORDS); /* all used */
-  /* free usable RAM [0, phys_mem_top) */
-  pmm_mark_region_free(0, phys_mem_top);
+  /* Everything starts 'used'; only whole frames inside usable ranges are
+   * freed, so holes between ranges stay reserved. */
+  buddy_ready = false;
+  memset(frame_bitmap, 0xFF, sizeof(frame_bitmap));
+  for (size_t i = 0; i < n_usable; ++i) {
+    uintptr_t b = clamp_phys(align_up(usable[i].base, PAGE_SIZE));
+    uintptr_t e = clamp_phys((usable[i].base + usable[i].len) & PAGE_MASK);
+    if (e > b)
+      pmm_mark_region_free(b, e);
+  }
+  for (size_t i = 0; i < n_reserved; ++i)
+    pmm_mark_region_used(clamp_phys(reserved[i].base),
+                         clamp_phys(reserved[i].base + reserved[i].len));
+
+  /* Low 1 MiB (IVT, BDA, EBDA, VGA, BIOS ROM) is never handed out; this also
+   * keeps frame 0 out of the allocator, since 0 means OOM. */
+  pmm_mark_region_used(0, 0x100000);
 
   /* mark kernel image frames used */
   kernel_phys_start = align_down(kernel_phys_start, PAGE_SIZE);
   kernel_phys_end = align_up(kernel_phys_end, PAGE_SIZE);
   pmm_mark_region_used(kernel_phys_start, kernel_phys_end);
+  mem_account_alloc(MEM_KERNEL, kernel_phys_end - kernel_phys_start);
 
   /* Reserve page directory's physical page (it’s static & in .bss/.data) */
   uintptr_t pdir_phys = (uintptr_t)kernel_page_directory;
   pmm_mark_region_used(align_down(pdir_phys, PAGE_SIZE),
                        align_up(pdir_phys + PAGE_SIZE, PAGE_SIZE));
 
-  /* Identity map [0, kernel_phys_end) so early kernel and PT frames are
-   * reachable by their physical addrs. */
-  k_memset(kernel_page_directory, 0, sizeof(kernel_page_directory));
-  paging_map_range(0, 0, (size_t)kernel_phys_end, PG_RW); /* supervisor RW */
-
-  /* Pick the first usable frame after kernel as a starting hint for allocation
-   */
+  /* Pick the first usable frame after kernel as a starting hint for the
+   * metadata carve-out, then hand all unreserved frames to the buddy lists */
   first_usable_frame = phys_to_frame(kernel_phys_end);
+  free_frames = 0;
+  for (unsigned k = 0; k <= PMM_MAX_ORDER; k++) {
+    free_list[k] = NULL;
+    free_count[k] = 0;
+  }
+  if (buddy_alloc_meta())
+    buddy_build();
+  /* whatever is not free now and not kernel/metadata is firmware, holes
+   * below the top of RAM or boot modules */
+  mem_tag_stats_t kst, mst;
+  mem_account_get(MEM_KERNEL, &kst);
+  mem_account_get(MEM_PMM_META, &mst);
+  size_t used = (total_frames - free_frames) * PAGE_SIZE;
+  if (used > kst.cur + mst.cur)
+    mem_account_alloc(MEM_RESERVED, used - kst.cur - mst.cur);
+
+  /* PSE/PGE: 4 MiB pages for the direct map, global kernel mappings that
+   * survive CR3 reloads. */
+  uint32_t a, b, c, d;
+  cpuid(1, &a, &b, &c, &d);
+  use_pse = (d & CPUID_EDX_PSE) != 0;
+  use_pge = (d & CPUID_EDX_PGE) != 0;
+  use_movnti = (d & CPUID_EDX_SSE2) != 0;
+  uintptr_t cr4 = read_cr4();
+  if (use_pse)
+    cr4 |= CR4_PSE;
+  if (use_pge)
+    cr4 |= CR4_PGE;
+  write_cr4(cr4);
+
+  /* PAT: the power-on layout is WB, WT, UC-, UC repeated; nothing here maps
+   * with PWT alone, so entry 1 (WT) is free to become write-combining. */
+  if (d & CPUID_EDX_PAT) {
+    uint64_t pat = rdmsr(MSR_IA32_PAT);
+    pat = (pat & ~(0xFFull << 8)) | (PAT_TYPE_WC << 8);
+    __asm__ volatile("wbinvd" ::: "memory");
+    wrmsr(MSR_IA32_PAT, pat);
+    __asm__ volatile("wbinvd" ::: "memory");
+    use_pat_wc = true;
+  }
+
+  /* Direct map: identity-map the low 1 MiB (BIOS data, VGA) with 4 KiB pages
+   * and every usable range with 4 MiB pages wherever alignment allows, so
+   * the kernel, PT frames and every PMM frame stay reachable by their
+   * physical address once paging is on. Holes (ACPI, MMIO) stay unmapped. */
+  memset(kernel_page_directory, 0, sizeof(kernel_page_directory));
+  pt_frames = 0;
+  large_pages = 0;
+  paging_map_range(0, 0, 0x100000, PG_RW | PG_GLOBAL);
+  paging_map_range(kernel_phys_start, kernel_phys_start,
+                   kernel_phys_end - kernel_phys_start, PG_RW | PG_GLOBAL);
+  for (size_t i = 0; i < n_usable; ++i) {
+    uintptr_t b0 = clamp_phys(align_up(usable[i].base, PAGE_SIZE));
+    if (b0 < 0x100000)
+      b0 = 0x100000; /* low 1 MiB is already mapped, keep it out of 4 MiB pages */
+    uintptr_t e0 = clamp_phys((usable[i].base + usable[i].len) & PAGE_MASK);
+    if (e0 > b0)
+      paging_map_range(b0, b0, e0 - b0, PG_RW | PG_GLOBAL);
+  }
 
   /* Load CR3 with the page directory physical address (identity assumed) */
   write_cr3((uintptr_t)kernel_page_directory);
 }
 
+void paging_setup(uintptr_t kernel_phys_start, uintptr_t kernel_phys_end,
+                  uintptr_t phys_mem_top) {
+  pmm_range_t all = {0, phys_mem_top};
+  paging_setup_mmap(kernel_phys_start, kernel_phys_end, &all, 1, NULL, 0);
+}
+
+uint32_t paging_wc_flags(void) {
+  return use_pat_wc ? PG_PWT : (PG_PCD | PG_PWT);
+}
+
+void paging_get_stats(paging_stats_t *out) {
+  out->pse = use_pse;
+  out->pge = use_pge;
+  out->pat_wc = use_pat_wc;
+  out->large_pages = large_pages;
+  out->pt_frames = pt_frames;
+  out->tlb_batches = tlb_batches;
+  out->tlb_invlpg = tlb_invlpg;
+  out->tlb_full_flushes = tlb_full_flushes;
+}
+
 void paging_enable(void) {
   /* Enable paging + supervisor write-protect. */
   uintptr_t cr0 = read_cr0();
@@ -336,15 +932,11 @@ static const char *pf_reason(uint32_t err) {
   return buf;
 }
 
-/* You must wire this into your IDT: ISR 14 should call
- * page_fault_isr(read_cr2(), err). */
+/* Called for faults nobody resolved (vm.c handles vector 14 and tries the
+ * demand-zero regions first). Prints the fault and stops. */
 void page_fault_isr(uintptr_t cr2, uint32_t err) {
-  (void)cr2;
-  (void)err;
-  /* For now, just hang. Replace with your kernel's panic/log. */
-  /* Example (if you have a logger): kprintf("PAGE FAULT @%p: %s (err=%#x)\n",
-   * cr2, pf_reason(err), err); */
+  kprintf("PAGE FAULT @%p: %s (err=%x)\n", (void *)cr2, pf_reason(err), err);
   for (;;) {
-    __asm__ volatile("hlt");
+    __asm__ volatile("cli; hlt");
   }
-}
\ No newline at end of file
+}
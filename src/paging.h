@@ -34,6 +34,10 @@
 #define CR0_PG (1u << 31) /* Paging enable */
 #define CR0_WP (1u << 16) /* Write protect in supervisor */
 
+/* CR4 flags */
+#define CR4_PSE (1u << 4) /* 4 MiB pages */
+#define CR4_PGE (1u << 7) /* global pages */
+
 /* PDE/PTE flags (i386) */
 enum {
   PG_PRESENT = 1u << 0,
@@ -43,10 +47,15 @@ enum {
   PG_PCD = 1u << 4, /* cache disable */
   PG_ACCESSED = 1u << 5,
   PG_DIRTY = 1u << 6, /* PTE only */
-  PG_PS = 1u << 7,    /* PDE only (4MiB pages; we don't use) */
+  PG_PS = 1u << 7,    /* PDE only: 4 MiB page (needs CR4.PSE) */
   PG_GLOBAL = 1u << 8
 };
 
+/** Cache-type bits for a write-combining mapping (framebuffers): PWT selects
+ * PAT entry 1, which paging_setup reprograms to WC when the CPU has PAT.
+ * Without PAT this falls back to PCD|PWT (uncached). */
+uint32_t paging_wc_flags(void);
+
 typedef uint32_t pte_t;
 typedef uint32_t pde_t;
 
@@ -62,12 +71,30 @@ typedef uint32_t pde_t;
  * @param phys_mem_top       total usable physical memory top (exclusive), e.g.,
  * from BIOS/e820
  *
- * This performs identity mapping for [0, kernel_phys_end) and enables CR4 PGE
- * if you later add it; currently we set CR0.WP and leave CR4 as-is.
+ * This builds the direct (identity) map: low 1 MiB with 4 KiB pages and all
+ * usable RAM with 4 MiB pages where alignment allows (CR4.PSE), all marked
+ * global (CR4.PGE) when the CPU supports it.
  */
 void paging_setup(uintptr_t kernel_phys_start, uintptr_t kernel_phys_end,
                   uintptr_t phys_mem_top);
 
+/** Physical memory range (base, length in bytes). */
+typedef struct {
+  uint64_t base;
+  uint64_t len;
+} pmm_range_t;
+
+/**
+ * Like paging_setup, but with the real memory map: only the 'usable' ranges
+ * (e.g. multiboot type 1) are handed to the frame allocator, and 'reserved'
+ * ranges inside them (boot modules, loader structures) stay allocated.
+ * Everything else - ACPI tables, MMIO holes - is never handed out. Ranges
+ * above 4 GiB are ignored.
+ */
+void paging_setup_mmap(uintptr_t kernel_phys_start, uintptr_t kernel_phys_end,
+                       const pmm_range_t *usable, size_t n_usable,
+                       const pmm_range_t *reserved, size_t n_reserved);
+
 /** Enable paging (loads CR3 and sets CR0.PG|CR0.WP). Call after paging_setup.
  */
 void paging_enable(void);
@@ -86,18 +113,102 @@ void paging_invalidate(uintptr_t virt);
 /** Translate virtual address to physical. Returns 0 on not-present. */
 uintptr_t paging_virt_to_phys(uintptr_t virt);
 
-/** Map a contiguous range (size rounded up). Convenience around
- * paging_map_page. */
+/** Map a contiguous range (size rounded up). Uses 4 MiB pages where both
+ * addresses are 4 MiB aligned and at least 4 MiB remain. */
 void paging_map_range(uintptr_t phys_start, uintptr_t virt_start, size_t size,
                       uint32_t flags);
 
 /** Unmap a contiguous range (size rounded up). */
 void paging_unmap_range(uintptr_t virt_start, size_t size, bool own_frames);
 
-/** Page fault ISR entry. Pass CR2 (fault VA) and error code from the CPU. */
+/* ====== Batched updates ====== */
+
+/* A batch of up to this many pages is flushed with one invlpg each; a larger
+ * one reloads CR3 (or toggles CR4.PGE if a global entry changed). */
+#ifndef PAGING_TLB_BATCH
+#define PAGING_TLB_BATCH 32
+#endif
+/* Frames waiting for the flush before they go back to the PMM. */
+#define PAGING_TLB_FREE_MAX 64
+
+/**
+ * Pending TLB invalidations of a multi-page update. The *_range functions
+ * above use one internally; callers that change several unrelated pages can
+ * do the same:
+ *
+ *   paging_tlb_batch_t b;
+ *   paging_batch_begin(&b);
+ *   paging_batch_unmap_page(&b, va1, true);
+ *   paging_batch_map_range(&b, phys, va2, len, PG_RW);
+ *   paging_batch_finish(&b);
+ *
+ * Changes are visible in the page tables at once, but the old translations
+ * may stay in the TLB (and unmapped frames stay allocated) until
+ * paging_batch_finish. Mapping a page that was not present needs no flush.
+ */
+typedef struct {
+  uint32_t count; /* entries in va[] */
+  bool full;      /* overflowed: flush the whole TLB */
+  bool global;    /* a global entry changed */
+  uintptr_t va[PAGING_TLB_BATCH];
+  uint32_t n_free;
+  uintptr_t free_phys[PAGING_TLB_FREE_MAX]; /* bit 0 = 4 MiB block */
+} paging_tlb_batch_t;
+
+void paging_batch_begin(paging_tlb_batch_t *b);
+void paging_batch_map_page(paging_tlb_batch_t *b, uintptr_t phys,
+                           uintptr_t virt, uint32_t flags);
+void paging_batch_unmap_page(paging_tlb_batch_t *b, uintptr_t virt,
+                             bool own_frame);
+void paging_batch_map_range(paging_tlb_batch_t *b, uintptr_t phys_start,
+                            uintptr_t virt_start, size_t size, uint32_t flags);
+void paging_batch_unmap_range(paging_tlb_batch_t *b, uintptr_t virt_start,
+                              size_t size, bool own_frames);
+/** Flush the recorded entries and free the frames; 'b' can be reused. */
+void paging_batch_finish(paging_tlb_batch_t *b);
+
+typedef struct {
+  bool pse;             /* 4 MiB pages enabled */
+  bool pge;             /* global pages enabled */
+  bool pat_wc;          /* PAT entry 1 is write-combining */
+  uint32_t large_pages; /* present 4 MiB mappings */
+  uint32_t pt_frames;   /* frames holding page tables */
+  uint32_t tlb_batches;      /* batches that flushed anything */
+  uint32_t tlb_invlpg;       /* single-page invalidations */
+  uint32_t tlb_full_flushes; /* CR3 reloads / CR4.PGE toggles */
+} paging_stats_t;
+
+void paging_get_stats(paging_stats_t *out);
+
+/** Unrecoverable page fault: report CR2 and the error code, then halt. */
 void page_fault_isr(uintptr_t cr2, uint32_t err);
 
-/* ====== Simple Physical Frame Allocator (4KiB frames) ====== */
+/* ====== Physical Frame Allocator (4KiB frames, buddy system) ====== */
+
+/* Largest block is 2^PMM_MAX_ORDER frames (order 10 = 4 MiB). */
+#define PMM_MAX_ORDER 10
+
+/* Pre-zeroed frame pool: capacity and frames zeroed per idle call. */
+#ifndef PMM_ZERO_POOL
+#define PMM_ZERO_POOL 64
+#endif
+#define PMM_ZERO_BATCH 4
+
+typedef struct {
+  uint32_t total_frames;
+  uint32_t free_frames;
+  uint32_t free_blocks[PMM_MAX_ORDER + 1]; /* free blocks per order */
+  uint32_t zero_pool;   /* pre-zeroed frames ready */
+  uint32_t zero_hits;   /* pmm_alloc_zeroed served from the pool */
+  uint32_t zero_misses; /* ... zeroed on the spot */
+} pmm_stats_t;
+
+/** Allocate 2^order physically contiguous frames, aligned to their size.
+ * Returns 0 on OOM. */
+uintptr_t pmm_alloc_pages(unsigned order);
+
+/** Free a block from pmm_alloc_pages; 'order' must match the allocation. */
+void pmm_free_pages(uintptr_t phys, unsigned order);
 
 /** Allocate one free physical frame (4KiB). Returns 0 on OOM. */
 uintptr_t pmm_alloc_frame(void);
@@ -106,6 +217,15 @@ uintptr_t pmm_alloc_frame(void);
  */
 void pmm_free_frame(uintptr_t phys);
 
+/** Allocate one frame filled with zeros: from the pre-zeroed pool if it has
+ * one, otherwise cleared right here. Free it with pmm_free_frame. */
+uintptr_t pmm_alloc_zeroed(void);
+
+/** Idle hook: zero a few frames into the pool. True if it did any work. */
+bool pmm_zero_idle(void);
+
+void pmm_get_stats(pmm_stats_t *out);
+
 /** Mark a physical region [start, end) as used (e.g., MMIO, ACPI, etc.). */
 void pmm_mark_region_used(uintptr_t start, uintptr_t end);
 
@@ -0,0 +1,73 @@
+/*
+ * [Cygnus] - [src/pci.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "pci.h"
+#include "io.h"
+
+#define PCI_CONFIG_ADDR 0xCF8
+#define PCI_CONFIG_DATA 0xCFC
+
+static inline uint32_t cfg_addr(uint32_t bus, uint32_t dev, uint32_t fun,
+                                uint32_t off) {
+  return 0x80000000u | (bus << 16) | (dev << 11) | (fun << 8) | (off & 0xFCu);
+}
+
+uint32_t pci_read32(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off) {
+  outl(PCI_CONFIG_ADDR, cfg_addr(bus, dev, fun, off));
+  return inl(PCI_CONFIG_DATA);
+}
+
+uint16_t pci_read16(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off) {
+  return (uint16_t)(pci_read32(bus, dev, fun, off) >> ((off & 2) * 8));
+}
+
+void pci_write32(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off,
+                 uint32_t v) {
+  outl(PCI_CONFIG_ADDR, cfg_addr(bus, dev, fun, off));
+  outl(PCI_CONFIG_DATA, v);
+}
+
+bool pci_find(uint16_t vendor, uint16_t device, pci_addr_t *out) {
+  uint32_t want = ((uint32_t)device << 16) | vendor;
+  for (uint32_t bus = 0; bus < 256; bus++) {
+    for (uint32_t dev = 0; dev < 32; dev++) {
+      uint32_t id = pci_read32(bus, dev, 0, PCI_VENDOR_ID);
+      if ((id & 0xFFFF) == 0xFFFF) continue;
+      /* funkcje 1..7 tylko dla urządzeń wielofunkcyjnych */
+      uint32_t nfun =
+          (pci_read32(bus, dev, 0, PCI_HEADER_TYPE) >> 16) & 0x80 ? 8 : 1;
+      for (uint32_t fun = 0; fun < nfun; fun++) {
+        if (fun) id = pci_read32(bus, dev, fun, PCI_VENDOR_ID);
+        if (id != want) continue;
+        out->bus = (uint8_t)bus;
+        out->dev = (uint8_t)dev;
+        out->fun = (uint8_t)fun;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+uint32_t pci_bar_mem(const pci_addr_t *a, unsigned bar) {
+  uint32_t v = pci_read32(a->bus, a->dev, a->fun, PCI_BAR0 + 4 * bar);
+  if (v & 1) return 0;
+  return v & ~0xFu;
+}
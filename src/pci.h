@@ -0,0 +1,56 @@
+/*
+ * [Cygnus] - [src/pci.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_PCI_H
+#define CYGNUS_PCI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Przestrzeń konfiguracyjna PCI przez porty 0xCF8/0xCFC (mechanizm #1).
+ * 'off' jest wyrównywany w dół do 4 B; węższe odczyty wycinają z dworda. */
+
+#define PCI_VENDOR_ID 0x00
+#define PCI_COMMAND 0x04
+#define PCI_CLASS 0x08
+#define PCI_HEADER_TYPE 0x0E
+#define PCI_BAR0 0x10
+#define PCI_INTERRUPT_LINE 0x3C
+
+#define PCI_CMD_IO 0x0001
+#define PCI_CMD_MEM 0x0002
+#define PCI_CMD_BUS_MASTER 0x0004
+
+typedef struct {
+  uint8_t bus, dev, fun;
+} pci_addr_t;
+
+uint32_t pci_read32(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off);
+uint16_t pci_read16(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off);
+void pci_write32(uint32_t bus, uint32_t dev, uint32_t fun, uint32_t off,
+                 uint32_t v);
+
+/* Pierwsze urządzenie vendor:device (skan wszystkich szyn). */
+bool pci_find(uint16_t vendor, uint16_t device, pci_addr_t *out);
+
+/* Baza BAR-u pamięciowego (bez bitów typu); 0, gdy to BAR I/O. */
+uint32_t pci_bar_mem(const pci_addr_t *a, unsigned bar);
+
+#endif /* CYGNUS_PCI_H */
@@ -20,6 +20,9 @@
  */
 #include "../inc/serial.h"
 #include "io.h"        /* inb/outb – u nas nagłówek jest w src/ */
+#include "cpu.h"
+#include "idt.h"
+#include "irq.h"
 #include <stdint.h>
 
 /* Rejestry względem bazy */
@@ -29,13 +32,46 @@ enum {
     REG_LCR       = 3, /* Line Control */
     REG_MCR       = 4, /* Modem Control */
     REG_LSR       = 5, /* Line Status */
-    REG_FCR       = 2, /* FIFO Control */
+    REG_MSR       = 6, /* Modem Status */
+    REG_FCR       = 2, /* FIFO Control (zapis) */
+    REG_IIR       = 2, /* Interrupt Identification (odczyt) */
     /* Uwaga: przy DLAB=1, REG_DATA (0) = Divisor Low, REG_IER (1) = Divisor High */
 };
 
 /* Bity w LSR */
 #define LSR_DATA_READY   0x01
 #define LSR_THR_EMPTY    0x20
+#define LSR_TX_IDLE      0x40  /* FIFO i rejestr przesuwny puste */
+
+/* IER / IIR */
+#define IER_RX           0x01
+#define IER_THRE         0x02
+#define IIR_NO_INT       0x01
+#define IIR_ID_MASK      0x0E
+#define IIR_LINE         0x06
+#define IIR_RX           0x04
+#define IIR_RX_TIMEOUT   0x0C
+#define IIR_THRE         0x02
+
+/* MCR: DTR | RTS | OUT2 (OUT2 bramkuje linię IRQ na PC) */
+#define MCR_IRQ          0x0B
+
+/* Głębokość FIFO nadajnika 16550A – tyle bajtów wolno wpisać po jednym
+ * sprawdzeniu THRE */
+#define TX_FIFO_DEPTH    16
+
+/* Bufory pierścieniowe (rozmiary – potęgi dwójki). Każdy ma jednego
+ * producenta i jednego konsumenta: TX – wątek pisze, IRQ wysyła;
+ * RX – IRQ odbiera, wątek czyta. Indeksy rosną bez zawijania, więc
+ * head - tail to liczba bajtów i nie potrzebujemy blokad. */
+#define TX_RING          4096
+#define RX_RING          256
+
+static uint8_t g_tx[TX_RING];
+static uint8_t g_rx[RX_RING];
+static uint32_t g_tx_head, g_tx_tail;
+static uint32_t g_rx_head, g_rx_tail;
+static int g_irq_mode;
 
 static uint16_t g_serial_base = COM1_BASE;
 
@@ -44,7 +80,7 @@ void serial_set_base(uint16_t base) { g_serial_base = base; }
 void serial_init(uint16_t base) {
     g_serial_base = base;
 
-    /* Wyłączamy przerwania z UART (na razie nie używamy IRQ) */
+    /* Wyłączamy przerwania z UART (włącza je dopiero serial_enable_irq) */
     outb(g_serial_base + REG_IER, 0x00);
 
     /* DLAB=1: ustawiamy dzielnik dla 115200 (divisor = 1) */
@@ -70,27 +106,182 @@ static inline void serial_wait_tx_empty(void) {
     while ((inb(g_serial_base + REG_LSR) & LSR_THR_EMPTY) == 0) { /* spin */ }
 }
 
+/* ===== Pierścienie ===== */
+
+static inline uint32_t ld_acq(const uint32_t *p) {
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void st_rel(uint32_t *p, uint32_t v) {
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline int tx_empty(void) { return ld_acq(&g_tx_head) == g_tx_tail; }
+static inline int tx_full(void) { return g_tx_head - ld_acq(&g_tx_tail) == TX_RING; }
+static inline int rx_empty(void) { return ld_acq(&g_rx_head) == g_rx_tail; }
+
+/* Do 16 bajtów z pierścienia do FIFO. Wołane z IRQ THRE albo z wątku,
+ * gdy przerwania są wyłączone (wtedy IRQ nie jest konsumentem). */
+static void tx_fill_fifo(void) {
+    uint32_t t = g_tx_tail, h = ld_acq(&g_tx_head);
+    for (int i = 0; i < TX_FIFO_DEPTH && t != h; i++, t++)
+        outb(g_serial_base + REG_DATA, g_tx[t & (TX_RING - 1)]);
+    st_rel(&g_tx_tail, t);
+}
+
+/* Odbiór wszystkiego, co jest w FIFO; przy pełnym pierścieniu gubimy. */
+static void rx_drain(void) {
+    while (inb(g_serial_base + REG_LSR) & LSR_DATA_READY) {
+        uint8_t c = inb(g_serial_base + REG_DATA);
+        uint32_t h = g_rx_head;
+        if (h - ld_acq(&g_rx_tail) == RX_RING) continue;
+        g_rx[h & (RX_RING - 1)] = c;
+        st_rel(&g_rx_head, h + 1);
+    }
+}
+
+static void serial_irq(void) {
+    for (;;) {
+        uint8_t iir = inb(g_serial_base + REG_IIR);
+        if (iir & IIR_NO_INT) break;
+        switch (iir & IIR_ID_MASK) {
+            case IIR_RX:
+            case IIR_RX_TIMEOUT:
+                rx_drain();
+                break;
+            case IIR_THRE:
+                tx_fill_fifo();
+                if (tx_empty()) outb(g_serial_base + REG_IER, IER_RX);
+                break;
+            case IIR_LINE:
+                (void)inb(g_serial_base + REG_LSR);
+                break;
+            default:
+                (void)inb(g_serial_base + REG_MSR);
+                break;
+        }
+    }
+}
+
+void serial_enable_irq(void) {
+    irq_register(IRQ_COM1, serial_irq, "com1");
+    g_irq_mode = 1;
+    outb(g_serial_base + REG_MCR, MCR_IRQ);
+    outb(g_serial_base + REG_IER, IER_RX);
+}
+
+/* Czy zapis ma iść przez pierścień? Z obsługi przerwania nie – tam
+ * wątek mógł być w połowie dopisywania (pierścień ma jednego producenta),
+ * więc np. komunikat o wyjątku wychodzi bezpośrednio. */
+static inline int tx_ring_usable(void) {
+    return g_irq_mode && !idt_isr_depth();
+}
+
+/* Pełny pierścień: śpimy do przerwania THRE albo, przy wyłączonych
+ * przerwaniach, sami wypychamy porcję do FIFO. Budzi nas dowolne
+ * przerwanie (np. bajt z RX), więc miejsca może nadal nie być –
+ * wołający sprawdza ponownie. */
+static void tx_wait_room(void) {
+    outb(g_serial_base + REG_IER, IER_RX | IER_THRE);
+    if (irqs_enabled()) {
+        CPU_WAIT_WHILE(tx_full());
+    } else {
+        serial_wait_tx_empty();
+        tx_fill_fifo();
+    }
+}
+
+static inline void tx_put(uint8_t c) {
+    while (tx_full()) tx_wait_room();
+    g_tx[g_tx_head & (TX_RING - 1)] = c;
+    st_rel(&g_tx_head, g_tx_head + 1);
+}
+
+/* ===== Odczyt ===== */
+
 int serial_can_read(void) {
+    if (g_irq_mode) {
+        if (!irqs_enabled()) rx_drain();
+        return !rx_empty();
+    }
     return (inb(g_serial_base + REG_LSR) & LSR_DATA_READY) ? 1 : 0;
 }
 
+void serial_wait_rx(void) {
+    if (g_irq_mode && irqs_enabled()) CPU_WAIT_WHILE(rx_empty());
+}
+
 char serial_read(void) {
+    if (g_irq_mode) {
+        while (!serial_can_read()) serial_wait_rx();
+        uint32_t t = g_rx_tail;
+        char c = (char)g_rx[t & (RX_RING - 1)];
+        st_rel(&g_rx_tail, t + 1);
+        return c;
+    }
     while (!serial_can_read()) { /* spin */ }
     return (char)inb(g_serial_base + REG_DATA);
 }
 
+/* ===== Zapis ===== */
+
 void serial_write_char(char c) {
-    /* Konwersja LF → CR+LF dla czytelności na terminalach */
-    if (c == '\n') {
+    serial_write_n(&c, 1);
+}
+
+/* Wspólne dla serial_write_n i serial_write_raw; 'crlf' – LF → CR+LF. */
+static void write_bytes(const char *s, size_t n, int crlf) {
+    if (tx_ring_usable()) {
+        /* THRE włączamy raz na cały zapis – UART zgłosi je od razu,
+         * jeżeli FIFO jest puste */
+        for (size_t i = 0; i < n; i++) {
+            if (crlf && s[i] == '\n') tx_put('\r');
+            tx_put((uint8_t)s[i]);
+        }
+        outb(g_serial_base + REG_IER, IER_RX | IER_THRE);
+        return;
+    }
+
+    /* Jedno czekanie na THRE na całe FIFO zamiast na każdy bajt
+     * (dopisany CR liczy się do porcji). */
+    while (n) {
         serial_wait_tx_empty();
-        outb(g_serial_base + REG_DATA, '\r');
+        int room = TX_FIFO_DEPTH;
+        while (n && room) {
+            if (crlf && *s == '\n') {
+                if (room < 2) break;
+                outb(g_serial_base + REG_DATA, '\r');
+                room--;
+            }
+            outb(g_serial_base + REG_DATA, (uint8_t)*s++);
+            room--; n--;
+        }
     }
-    serial_wait_tx_empty();
-    outb(g_serial_base + REG_DATA, (uint8_t)c);
+}
+
+void serial_write_n(const char *s, size_t n) {
+    write_bytes(s, n, 1);
+}
+
+void serial_write_raw(const void *buf, size_t n) {
+    write_bytes((const char *)buf, n, 0);
 }
 
 void serial_write(const char *s) {
-    while (*s) {
-        serial_write_char(*s++);
+    size_t n = 0;
+    while (s[n]) n++;
+    serial_write_n(s, n);
+}
+
+void serial_flush(void) {
+    if (g_irq_mode) {
+        while (!tx_empty()) {
+            if (irqs_enabled() && !idt_isr_depth()) {
+                CPU_WAIT_WHILE(!tx_empty());
+            } else {
+                serial_wait_tx_empty();
+                tx_fill_fifo();
+            }
+        }
     }
-}
\ No newline at end of file
+    while (!(inb(g_serial_base + REG_LSR) & LSR_TX_IDLE)) { /* spin */ }
+}
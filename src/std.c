@@ -22,11 +22,66 @@
 #include "../inc/serial.h"
 #include <stddef.h>
 
-/* Prosty print na UART (bez formatowania) */
-void print(const char *s) { while (*s) { serial_write_char(*s++); } }
+/* ===== Ujścia ===== */
 
-/* Wypisanie pojedynczego znaku na UART */
-void putchar(char c) { serial_write_char(c); }
+static void serial_sink_write(ksink_t *s, const char *buf, size_t n) {
+    (void)s;
+    serial_write_n(buf, n);
+}
+
+ksink_t g_ksink_serial = { serial_sink_write, NULL };
+
+/* Konsola = wszystkie zarejestrowane ujścia; na start tylko UART */
+static ksink_t *g_console[KPRINTF_MAX_SINKS] = { &g_ksink_serial };
+static int g_nconsole = 1;
+
+int kprintf_add_sink(ksink_t *s) {
+    for (int i = 0; i < g_nconsole; i++) if (g_console[i] == s) return 0;
+    if (g_nconsole >= KPRINTF_MAX_SINKS) return -1;
+    g_console[g_nconsole++] = s;
+    return 0;
+}
+
+void kprintf_remove_sink(ksink_t *s) {
+    for (int i = 0; i < g_nconsole; i++) {
+        if (g_console[i] != s) continue;
+        for (; i + 1 < g_nconsole; i++) g_console[i] = g_console[i + 1];
+        g_nconsole--;
+        return;
+    }
+}
+
+static void console_write(ksink_t *s, const char *buf, size_t n) {
+    (void)s;
+    for (int i = 0; i < g_nconsole; i++) g_console[i]->write(g_console[i], buf, n);
+}
+
+static ksink_t g_console_sink = { console_write, NULL };
+
+/* Ujście do bufora: obcina, ale liczy dalej (semantyka snprintf) */
+typedef struct {
+    ksink_t base;
+    char   *dst;
+    int     cap;   /* bez miejsca na NUL */
+    int     len;
+} buf_sink_t;
+
+static void buf_sink_write(ksink_t *s, const char *buf, size_t n) {
+    buf_sink_t *b = (buf_sink_t*)s;
+    for (size_t i = 0; i < n && b->len < b->cap; i++) b->dst[b->len++] = buf[i];
+}
+
+/* ===== Proste I/O ===== */
+
+/* Prosty print na konsolę (bez formatowania) */
+void print(const char *s) {
+    size_t n = 0;
+    while (s[n]) n++;
+    console_write(&g_console_sink, s, n);
+}
+
+/* Wypisanie pojedynczego znaku na konsolę */
+void putchar(char c) { console_write(&g_console_sink, &c, 1); }
 
 /* Bardzo prosty input – czytamy do \n/\r, backspace działa */
 void gets(char *buf, int max) {
@@ -45,103 +100,214 @@ void gets(char *buf, int max) {
     print("\r\n");
 }
 
-/* --- Pomocnicze: konwersje liczb --- */
-static int utoa_base(unsigned long v, unsigned base, char *out, int outsz, int upper) {
-    static const char digs_l[] = "0123456789abcdef";
-    static const char digs_u[] = "0123456789ABCDEF";
-    const char *digs = upper ? digs_u : digs_l;
-    char tmp[32];
-    int n = 0;
-    if (base < 2 || base > 16) return 0;
-    if (v == 0) tmp[n++] = '0';
-    while (v && n < (int)sizeof(tmp)) { tmp[n++] = digs[v % base]; v /= base; }
-    int w = 0;
-    while (n && w < outsz-1) out[w++] = tmp[--n];
-    out[w] = 0;
-    return w;
-}
-static int itoa10(long v, char *out, int outsz) {
-    if (v < 0) {
-        if (outsz < 2) return 0;
-        *out++ = '-'; outsz--;
-        return 1 + utoa_base((unsigned long)(-(v)), 10, out, outsz, 0);
+/* ===== Wyjście formatera: porcje KPRINTF_CHUNK bajtów ===== */
+
+typedef struct {
+    ksink_t *sink;
+    int      n;       /* zajęte w buf */
+    int      total;   /* wszystkie wyemitowane znaki */
+    char     buf[KPRINTF_CHUNK];
+} kout_t;
+
+static void out_flush(kout_t *o) {
+    if (o->n) { o->sink->write(o->sink, o->buf, (size_t)o->n); o->n = 0; }
+}
+
+static void out_put(kout_t *o, const char *s, size_t n) {
+    o->total += (int)n;
+    /* długie kawałki (np. %s) idą prosto do ujścia, bez kopiowania */
+    if (n >= KPRINTF_CHUNK) {
+        out_flush(o);
+        o->sink->write(o->sink, s, n);
+        return;
     }
-    return utoa_base((unsigned long)v, 10, out, outsz, 0);
+    if ((size_t)(KPRINTF_CHUNK - o->n) < n) out_flush(o);
+    for (size_t i = 0; i < n; i++) o->buf[o->n++] = s[i];
 }
 
-/* --- rdzeń formatowania --- */
-int kvsnprintf(char *dst, int dstsz, const char *fmt, va_list ap) {
-    int written = 0;
-    if (!dst || dstsz <= 0) return 0;
+static void out_pad(kout_t *o, char c, int n) {
+    while (n-- > 0) {
+        if (o->n == KPRINTF_CHUNK) out_flush(o);
+        o->buf[o->n++] = c;
+        o->total++;
+    }
+}
 
-    for (const char *p = fmt; *p; ++p) {
-        if (*p != '%') {
-            if (written < dstsz - 1) dst[written] = *p;
-            written++;
-            continue;
+/* ===== Konwersje liczb ===== */
+
+static const char g_dig2[200] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Cyfry dziesiętne v wpisujemy od końca przed 'end', po dwie na dzielenie.
+ * Zwraca wskaźnik na pierwszą cyfrę. */
+static char *u32_dec(uint32_t v, char *end) {
+    while (v >= 100) {
+        uint32_t r = v % 100;
+        v /= 100;
+        end -= 2;
+        end[0] = g_dig2[2 * r];
+        end[1] = g_dig2[2 * r + 1];
+    }
+    if (v >= 10) {
+        end -= 2;
+        end[0] = g_dig2[2 * v];
+        end[1] = g_dig2[2 * v + 1];
+    } else {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
+
+/* 64 bity: dzielenie 64-bitowe tylko póki górne słowo jest niezerowe,
+ * resztę robimy na 32 bitach po 9 cyfr */
+static char *u64_dec(uint64_t v, char *end) {
+    while (v >> 32) {
+        uint64_t q = v / 1000000000u;
+        uint32_t lo = (uint32_t)(v - q * 1000000000u);
+        v = q;
+        char *p = u32_dec(lo, end);
+        while (p > end - 9) *--p = '0';
+        end -= 9;
+    }
+    return u32_dec((uint32_t)v, end);
+}
+
+static char *u64_hex(uint64_t v, char *end, int upper) {
+    const char *digs = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint32_t lo = (uint32_t)v, hi = (uint32_t)(v >> 32);
+    if (hi) {
+        for (int i = 0; i < 8; i++, lo >>= 4) *--end = digs[lo & 0xF];
+        lo = hi;
+    }
+    do { *--end = digs[lo & 0xF]; lo >>= 4; } while (lo);
+    return end;
+}
+
+/* ===== Rdzeń formatowania ===== */
+
+enum { F_LEFT = 1, F_ZERO = 2 };
+
+static void out_field(kout_t *o, const char *s, int n, const char *sign,
+                      int width, int flags) {
+    int sl = sign ? 1 : 0;
+    int pad = width - n - sl;
+    if (!(flags & F_LEFT) && !(flags & F_ZERO)) out_pad(o, ' ', pad);
+    if (sign) out_put(o, sign, 1);
+    if (!(flags & F_LEFT) && (flags & F_ZERO)) out_pad(o, '0', pad);
+    out_put(o, s, (size_t)n);
+    if (flags & F_LEFT) out_pad(o, ' ', pad);
+}
+
+static int kformat(ksink_t *sink, const char *fmt, va_list ap) {
+    kout_t o;
+    o.sink = sink; o.n = 0; o.total = 0;
+
+    const char *p = fmt;
+    while (*p) {
+        /* dosłowny fragment do następnego '%' – jednym kawałkiem */
+        const char *lit = p;
+        while (*p && *p != '%') p++;
+        if (p > lit) out_put(&o, lit, (size_t)(p - lit));
+        if (!*p) break;
+
+        const char *spec = p++;          /* '%' */
+        int flags = 0, width = 0, prec = -1, lng = 0;
+        for (;; p++) {
+            if (*p == '-') flags |= F_LEFT;
+            else if (*p == '0') flags |= F_ZERO;
+            else break;
+        }
+        if (*p == '*') {
+            width = va_arg(ap, int);
+            if (width < 0) { flags |= F_LEFT; width = -width; }
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') width = width * 10 + (*p++ - '0');
         }
-        /* '%' */
-        ++p;
-        if (*p == 0) break;
+        if (*p == '.') {
+            prec = 0; p++;
+            if (*p == '*') { prec = va_arg(ap, int); p++; }
+            else while (*p >= '0' && *p <= '9') prec = prec * 10 + (*p++ - '0');
+        }
+        while (*p == 'l') { lng++; p++; }
+        if (*p == 'z') p++;              /* size_t == unsigned int */
 
-        int upper = 0;
-        char tmp[64];
+        char tmp[24];
+        char *end = tmp + sizeof(tmp), *s;
+        const char *sign = NULL;
 
         switch (*p) {
             case '%':
-                if (written < dstsz - 1) dst[written] = '%';
-                written++;
+                out_put(&o, "%", 1);
                 break;
             case 'c': {
-                int c = va_arg(ap, int);
-                if (written < dstsz - 1) dst[written] = (char)c;
-                written++;
+                char c = (char)va_arg(ap, int);
+                out_field(&o, &c, 1, NULL, width, flags & F_LEFT);
             } break;
             case 's': {
-                const char *s = va_arg(ap, const char*);
-                if (!s) s = "(null)";
-                while (*s) {
-                    if (written < dstsz - 1) dst[written] = *s;
-                    written++; s++;
-                }
+                const char *str = va_arg(ap, const char*);
+                if (!str) str = "(null)";
+                int n = 0;
+                while (str[n] && (prec < 0 || n < prec)) n++;
+                out_field(&o, str, n, NULL, width, flags & F_LEFT);
             } break;
-            case 'd': {
-                long v = va_arg(ap, int);
-                int n = itoa10(v, tmp, sizeof(tmp));
-                for (int i=0;i<n;i++) { if (written < dstsz - 1) dst[written] = tmp[i]; written++; }
+            case 'd':
+            case 'i': {
+                int64_t v = lng >= 2 ? va_arg(ap, long long) : va_arg(ap, long);
+                uint64_t u = (uint64_t)v;
+                if (v < 0) { sign = "-"; u = 0 - u; }
+                s = u64_dec(u, end);
+                out_field(&o, s, (int)(end - s), sign, width, flags);
             } break;
             case 'u': {
-                unsigned long v = va_arg(ap, unsigned int);
-                int n = utoa_base(v, 10, tmp, sizeof(tmp), 0);
-                for (int i=0;i<n;i++) { if (written < dstsz - 1) dst[written] = tmp[i]; written++; }
+                uint64_t v = lng >= 2 ? va_arg(ap, unsigned long long)
+                                      : va_arg(ap, unsigned long);
+                s = (v >> 32) ? u64_dec(v, end) : u32_dec((uint32_t)v, end);
+                out_field(&o, s, (int)(end - s), NULL, width, flags);
             } break;
-            case 'x': /* hex lower */
+            case 'x':
+            case 'X':
             case 'p': {
-                unsigned long v = (unsigned long)va_arg(ap, unsigned long);
-                int n = utoa_base(v, 16, tmp, sizeof(tmp), upper);
-                for (int i=0;i<n;i++) { if (written < dstsz - 1) dst[written] = tmp[i]; written++; }
+                uint64_t v = (lng >= 2 && *p != 'p') ? va_arg(ap, unsigned long long)
+                                                     : va_arg(ap, unsigned long);
+                s = u64_hex(v, end, *p == 'X');
+                out_field(&o, s, (int)(end - s), NULL, width, flags);
             } break;
-            case 'X':
-                upper = 1;
-                /* fallthrough do 'x' */
-                p--;
-                break;
+            case 0:
+                /* '%' na końcu łańcucha – wypisujemy, co było */
+                out_put(&o, spec, (size_t)(p - spec));
+                continue;
             default:
                 /* nieznany format – wypisujemy dosłownie */
-                if (written < dstsz - 1) dst[written] = '%';
-                written++;
-                if (written < dstsz - 1) dst[written] = *p;
-                written++;
+                out_put(&o, spec, (size_t)(p - spec + 1));
                 break;
         }
+        p++;
     }
+    out_flush(&o);
+    return o.total;
+}
 
-    /* NUL-terminate */
-    if (dstsz > 0) {
-        if (written >= dstsz) dst[dstsz - 1] = 0;
-        else dst[written] = 0;
-    }
-    return written;
+int kvfprintf(ksink_t *sink, const char *fmt, va_list ap) {
+    return kformat(sink, fmt, ap);
+}
+
+int kfprintf(ksink_t *sink, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = kformat(sink, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+int kvsnprintf(char *dst, int dstsz, const char *fmt, va_list ap) {
+    if (!dst || dstsz <= 0) return 0;
+    buf_sink_t b = { { buf_sink_write, NULL }, dst, dstsz - 1, 0 };
+    int n = kformat(&b.base, fmt, ap);
+    dst[b.len] = 0;
+    return n;
 }
 
 int ksnprintf(char *dst, int dstsz, const char *fmt, ...) {
@@ -152,12 +318,13 @@ int ksnprintf(char *dst, int dstsz, const char *fmt, ...) {
     return n;
 }
 
+int kvprintf(const char *fmt, va_list ap) {
+    return kformat(&g_console_sink, fmt, ap);
+}
+
 void kprintf(const char *fmt, ...) {
-    char buf[512];
     va_list ap;
     va_start(ap, fmt);
-    int n = kvsnprintf(buf, (int)sizeof(buf), fmt, ap);
+    kformat(&g_console_sink, fmt, ap);
     va_end(ap);
-    /* wypis na UART */
-    for (int i = 0; i < n && buf[i]; ++i) serial_write_char(buf[i]);
-}
\ No newline at end of file
+}
@@ -18,53 +18,339 @@
  * See the Licence for the specific language governing permissions and
  * limitations under the Licence.
  */
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include "fpu.h"
 
-void *memset(void *s, int c, size_t n) {
+/* Pętle poniżej to implementacje mem*; GCC nie może ich zamienić z
+ * powrotem na wywołania memcpy/memset (rekurencja bez końca). */
+#pragma GCC optimize("no-tree-loop-distribute-patterns")
+
+/* Poniżej tego rozmiaru zwykła pętla jest szybsza niż start rep movs. */
+#define STRING_REP_MIN 16
+/* Od tego rozmiaru opłaca się SSE2 (wyrównanie celu + pętla po 64 B). */
+#define STRING_SIMD_MIN 256
+
+typedef uint32_t __attribute__((may_alias, aligned(1))) u32_unaligned;
+
+static bool g_sse2; /* wybrane przy starcie przez string_init */
+
+/* ===== pętle bajtowe (małe rozmiary, punkt odniesienia w bench) ===== */
+
+static void *memcpy_byte(void *d, const void *s, size_t n) {
+    uint8_t *dp = (uint8_t*)d; const uint8_t *sp = (const uint8_t*)s;
+    while (n--) *dp++ = *sp++;
+    return d;
+}
+static void *memset_byte(void *s, int c, size_t n) {
     uint8_t *p = (uint8_t*)s;
     while (n--) *p++ = (uint8_t)c;
     return s;
 }
+
+/* ===== rep movsd / rep stosd (każdy i386) ===== */
+
+static void *memcpy_rep(void *d, const void *s, size_t n) {
+    void *r = d;
+    /* cel wyrównany do 4 B, potem dwordy, na końcu reszta bajtów */
+    size_t head = (size_t)(-(uintptr_t)d) & 3u;
+    if (head > n) head = n;
+    n -= head;
+    size_t n4 = n >> 2, tail = n & 3u;
+    __asm__ volatile("rep movsb\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep movsl\n\t"
+                     "mov %4, %%ecx\n\t"
+                     "rep movsb"
+                     : "+D"(d), "+S"(s), "+c"(head)
+                     : "rm"(n4), "rm"(tail)
+                     : "memory");
+    return r;
+}
+
+static void *memset_rep(void *s, int c, size_t n) {
+    void *r = s;
+    uint32_t v = (uint8_t)c * 0x01010101u;
+    size_t head = (size_t)(-(uintptr_t)s) & 3u;
+    if (head > n) head = n;
+    n -= head;
+    size_t n4 = n >> 2, tail = n & 3u;
+    __asm__ volatile("rep stosb\n\t"
+                     "mov %3, %%ecx\n\t"
+                     "rep stosl\n\t"
+                     "mov %4, %%ecx\n\t"
+                     "rep stosb"
+                     : "+D"(s), "+c"(head)
+                     : "a"(v), "rm"(n4), "rm"(tail)
+                     : "memory");
+    return r;
+}
+
+/* ===== SSE2: wyrównany zapis po 64 B (4 x movdqa) ===== */
+
+__attribute__((target("sse2")))
+static void *memcpy_sse2(void *d, const void *s, size_t n) {
+    void *r = d;
+    size_t head = (size_t)(-(uintptr_t)d) & 15u;
+    if (head > n) head = n;
+    __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(head) :: "memory");
+    n -= (size_t)((uint8_t*)d - (uint8_t*)r);
+
+    size_t blocks = n >> 6;
+    if (blocks) {
+        __asm__ volatile("1:\n\t"
+                         "movdqu (%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movdqa %%xmm0, (%0)\n\t"
+                         "movdqa %%xmm1, 16(%0)\n\t"
+                         "movdqa %%xmm2, 32(%0)\n\t"
+                         "movdqa %%xmm3, 48(%0)\n\t"
+                         "add $64, %1\n\t"
+                         "add $64, %0\n\t"
+                         "dec %2\n\t"
+                         "jnz 1b"
+                         : "+r"(d), "+r"(s), "+r"(blocks)
+                         :
+                         : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+    }
+    n &= 63u;
+    __asm__ volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) :: "memory");
+    return r;
+}
+
+__attribute__((target("sse2")))
+static void *memset_sse2(void *s, int c, size_t n) {
+    void *r = s;
+    uint32_t v = (uint8_t)c * 0x01010101u;
+    size_t head = (size_t)(-(uintptr_t)s) & 15u;
+    if (head > n) head = n;
+    n -= head;
+    __asm__ volatile("rep stosb" : "+D"(s), "+c"(head) : "a"(v) : "memory");
+
+    size_t blocks = n >> 6;
+    if (blocks) {
+        __asm__ volatile("movd %2, %%xmm0\n\t"
+                         "pshufd $0, %%xmm0, %%xmm0\n"
+                         "1:\n\t"
+                         "movdqa %%xmm0, (%0)\n\t"
+                         "movdqa %%xmm0, 16(%0)\n\t"
+                         "movdqa %%xmm0, 32(%0)\n\t"
+                         "movdqa %%xmm0, 48(%0)\n\t"
+                         "add $64, %0\n\t"
+                         "dec %1\n\t"
+                         "jnz 1b"
+                         : "+r"(s), "+r"(blocks)
+                         : "r"(v)
+                         : "memory", "xmm0");
+    }
+    n &= 63u;
+    __asm__ volatile("rep stosb" : "+D"(s), "+c"(n) : "a"(v) : "memory");
+    return r;
+}
+
+/* ===== wybór przy starcie ===== */
+
+static const mem_impl_t g_impls[] = {
+    {"bajty", memcpy_byte, memset_byte},
+    {"rep movsd/stosd", memcpy_rep, memset_rep},
+    {"sse2", memcpy_sse2, memset_sse2},
+};
+
+void string_init(void) { g_sse2 = fpu_has_sse2(); }
+
+const char *string_impl_name(void) {
+    return g_sse2 ? "sse2 + rep movsd/stosd" : "rep movsd/stosd";
+}
+
+unsigned string_impls(const mem_impl_t **out) {
+    *out = g_impls;
+    return fpu_has_sse2() ? 3u : 2u;
+}
+
+/* ===== API ===== */
+
+void *memset(void *s, int c, size_t n) {
+    if (n < STRING_REP_MIN) return memset_byte(s, c, n);
+    if (n >= STRING_SIMD_MIN && g_sse2 && fpu_simd_usable())
+        return memset_sse2(s, c, n);
+    return memset_rep(s, c, n);
+}
 void *memcpy(void *d, const void *s, size_t n) {
+    if (n < STRING_REP_MIN) return memcpy_byte(d, s, n);
+    if (n >= STRING_SIMD_MIN && g_sse2 && fpu_simd_usable())
+        return memcpy_sse2(d, s, n);
+    return memcpy_rep(d, s, n);
+}
+void *memmove(void *d, const void *s, size_t n) {
     uint8_t *dp = (uint8_t*)d; const uint8_t *sp = (const uint8_t*)s;
-    while (n--) *dp++ = *sp++;
+    /* kopia w przód jest bezpieczna, gdy cel leży przed źródłem */
+    if (dp <= sp || dp >= sp + n) return memcpy(d, s, n);
+
+    /* w tył: najpierw końcowe bajty, potem dwordy z DF=1 */
+    size_t n4 = n >> 2;
+    for (size_t i = n; i > n4 * 4; ) { --i; dp[i] = sp[i]; }
+    if (n4) {
+        void *de = dp + n4 * 4 - 4;
+        const void *se = sp + n4 * 4 - 4;
+        __asm__ volatile("std\n\t"
+                         "rep movsl\n\t"
+                         "cld"
+                         : "+D"(de), "+S"(se), "+c"(n4)
+                         :
+                         : "memory");
+    }
     return d;
 }
 int memcmp(const void *a, const void *b, size_t n) {
     const uint8_t *pa = (const uint8_t*)a, *pb = (const uint8_t*)b;
+    /* po 4 bajty, dopóki się zgadzają; różnicę ustalamy bajtowo */
+    while (n >= 4 && *(const u32_unaligned*)pa == *(const u32_unaligned*)pb) {
+        pa += 4; pb += 4; n -= 4;
+    }
     for (; n; --n, ++pa, ++pb) {
         if (*pa != *pb) return (int)*pa - (int)*pb;
     }
     return 0;
 }
 
+/* ===== str*: słowo naraz (SWAR) =====
+ * Bajt zerowy w słowie wykrywamy klasycznie: (w - 0x01..01) & ~w & 0x80..80
+ * jest niezerowe dokładnie wtedy, gdy któryś bajt w 'w' to 0. Słowo to
+ * uintptr_t, więc na 32 bitach idziemy po 4 bajty, na 64 – po 8.
+ *
+ * Czytamy całe słowo, choć napis może kończyć się w jego środku. Wyrównane
+ * słowo nigdy nie przekracza granicy strony; tam, gdzie wyrównania nie da się
+ * zapewnić (dwa napisy naraz), bierzemy słowo tylko wtedy, gdy mieści się
+ * w bieżącej stronie – inaczej krok bajtowy. Dzięki temu nie dotykamy
+ * niezmapowanej strony za końcem napisu. */
+
+typedef uintptr_t word_t;
+typedef word_t __attribute__((may_alias, aligned(1))) word_unaligned;
+
+#define WSIZE sizeof(word_t)
+#define ONES ((word_t)-1 / 0xFF)
+#define HIGHS (ONES * 0x80)
+#define HAS_ZERO(w) (((w) - ONES) & ~(w) & HIGHS)
+#define STR_PAGE 4096u
+
+static inline bool word_safe(const void *p) {
+    return ((uintptr_t)p & (STR_PAGE - 1)) <= STR_PAGE - WSIZE;
+}
+static inline word_t load_word(const void *p) {
+    return *(const word_unaligned*)p;
+}
+
+/* ASCII 'a'..'z' -> 'A'..'Z' w każdym bajcie słowa (reszta bez zmian) */
+static inline word_t upcase_word(word_t w) {
+    word_t low7 = w & ~HIGHS; /* bez najwyższych bitów dodawanie nie przenosi */
+    word_t ge_a = low7 + ONES * (0x80 - 'a');
+    word_t gt_z = low7 + ONES * (0x80 - 'z' - 1);
+    word_t lower = ge_a & ~gt_z & ~w & HIGHS;
+    return w ^ (lower >> 2); /* 0x80 >> 2 = 0x20 */
+}
+
+static inline int upcase(int c) {
+    return (c >= 'a' && c <= 'z') ? c - 32 : c;
+}
+
 size_t strlen(const char *s) {
-    const char *p = s; while (*p) ++p; return (size_t)(p - s);
+    const char *p = s;
+    for (; (uintptr_t)p & (WSIZE - 1); ++p)
+        if (!*p) return (size_t)(p - s);
+    while (!HAS_ZERO(load_word(p))) p += WSIZE; /* wyrównane: w obrębie strony */
+    while (*p) ++p;
+    return (size_t)(p - s);
 }
 char *strcpy(char *d, const char *s) {
     char *r = d; while ((*d++ = *s++)); return r;
 }
 char *strncpy(char *d, const char *s, size_t n) {
-    size_t i=0; for (; i<n && s[i]; ++i) d[i]=s[i];
-    for (; i<n; ++i) d[i]=0;
+    size_t i = 0;
+    while (n - i >= WSIZE && word_safe(s + i)) {
+        word_t w = load_word(s + i);
+        if (HAS_ZERO(w)) break;
+        *(word_unaligned*)(d + i) = w;
+        i += WSIZE;
+    }
+    for (; i < n && s[i]; ++i) d[i] = s[i];
+    if (i < n) memset(d + i, 0, n - i);
     return d;
 }
 int strcmp(const char *a, const char *b) {
-    while (*a && *b && *a == *b) { ++a; ++b; }
-    return (int)((unsigned char)*a) - (int)((unsigned char)*b);
+    for (;;) {
+        if (word_safe(a) && word_safe(b)) {
+            word_t wa = load_word(a);
+            if (wa == load_word(b) && !HAS_ZERO(wa)) {
+                a += WSIZE; b += WSIZE;
+                continue;
+            }
+        }
+        /* różnica albo koniec w tym słowie (albo granica strony) */
+        for (size_t k = 0; k < WSIZE; ++k, ++a, ++b) {
+            unsigned char ca = (unsigned char)*a, cb = (unsigned char)*b;
+            if (ca != cb || ca == 0) return (int)ca - (int)cb;
+        }
+    }
 }
 int strncmp(const char *a, const char *b, size_t n) {
-    for (size_t i=0; i<n; ++i) {
-        unsigned char ca = (unsigned char)a[i];
-        unsigned char cb = (unsigned char)b[i];
-        if (ca != cb || ca == 0 || cb == 0) return (int)ca - (int)cb;
+    while (n) {
+        if (n >= WSIZE && word_safe(a) && word_safe(b)) {
+            word_t wa = load_word(a);
+            if (wa == load_word(b) && !HAS_ZERO(wa)) {
+                a += WSIZE; b += WSIZE; n -= WSIZE;
+                continue;
+            }
+        }
+        for (size_t k = 0; k < WSIZE && n; ++k, ++a, ++b, --n) {
+            unsigned char ca = (unsigned char)*a, cb = (unsigned char)*b;
+            if (ca != cb || ca == 0) return (int)ca - (int)cb;
+        }
+    }
+    return 0;
+}
+int strncasecmp(const char *a, const char *b, size_t n) {
+    while (n) {
+        if (n >= WSIZE && word_safe(a) && word_safe(b)) {
+            word_t wa = load_word(a);
+            if (!HAS_ZERO(wa) &&
+                (wa == load_word(b) || upcase_word(wa) == upcase_word(load_word(b)))) {
+                a += WSIZE; b += WSIZE; n -= WSIZE;
+                continue;
+            }
+        }
+        for (size_t k = 0; k < WSIZE && n; ++k, ++a, ++b, --n) {
+            int ca = upcase((unsigned char)*a), cb = upcase((unsigned char)*b);
+            if (ca != cb || ca == 0) return ca - cb;
+        }
     }
     return 0;
 }
 char *strchr(const char *s, int c) {
-    while (*s) { if (*s == (char)c) return (char*)s; ++s; }
-    return (c == 0) ? (char*)s : NULL;
+    char ch = (char)c;
+    for (; (uintptr_t)s & (WSIZE - 1); ++s) {
+        if (*s == ch) return (char*)s;
+        if (!*s) return NULL;
+    }
+    word_t pat = ONES * (unsigned char)ch;
+    for (;;) {
+        word_t w = load_word(s);
+        if (HAS_ZERO(w) || HAS_ZERO(w ^ pat)) break;
+        s += WSIZE;
+    }
+    for (; *s != ch; ++s)
+        if (!*s) return NULL;
+    return (char*)s;
+}
+/* ostatnie wystąpienie: kolejne strchr, więc też słowo naraz */
+char *strrchr(const char *s, int c) {
+    if ((char)c == 0) return (char*)s + strlen(s);
+    char *last = NULL;
+    for (char *p; (p = strchr(s, c)) != NULL; s = p + 1) last = p;
+    return last;
 }
 
 /* Prosty strtok bez wsparcia dla wielu delimiterów – wystarcza na whitespace */
@@ -21,6 +21,8 @@
 #include "../../inc/usb/ehci.h"
 #include "../../inc/usb/usb_types.h"
 #include "../../inc/usb/usb_core.h"
+#include "../kmalloc.h"
+#include "../ktime.h"
 
 #define PCI_CLASS_SERIAL_BUS 0x0C
 #define PCI_SUBCLASS_USB     0x03
@@ -67,11 +69,13 @@ static void ehci_bringup(u32 b,u32 d,u32 f){
     volatile ehci_cap_t* cap = (volatile ehci_cap_t*)map_mmio(bar);
     volatile ehci_op_t*  op  = (volatile ehci_op_t*)((volatile u8*)cap + cap->CAPLENGTH);
 
-    // Zatrzymaj + reset
+    // Zatrzymaj + reset (EHCI: HCHalted do 16 mikroramek, czyli 2 ms)
     op->USBCMD &= ~1u;
-    for (volatile int i=0;i<100000;i++);
+    if (!KTIME_POLL_US(op->USBSTS & (1u<<12), 2000))
+        klog("ehci","HCHalted nie ustawiony\n");
     op->USBCMD |= (1u<<1); // HCReset
-    for (volatile int i=0;i<100000;i++);
+    if (!KTIME_POLL_US(!(op->USBCMD & (1u<<1)), 100000))
+        klog("ehci","HCReset nie zakończony\n");
 
     // Ustaw CONFIGFLAG = 1 (przekieruj porty do EHCI)
     op->CONFIGFLAG = 1;
@@ -83,6 +87,8 @@ static void ehci_bringup(u32 b,u32 d,u32 f){
         *ps |= (1u<<12); // PP — zasilanie portu
         *ps |= (1u<<8);  // PR — reset portu
     }
+    mdelay(50); // PR trzymamy min. 50 ms (USB 2.0, 7.1.7.5), potem zdejmujemy
+    for (u32 p=0;p<nports;p++) op->PORTSC[p] &= ~(1u<<8);
 
     // Uruchom
     op->USBCMD |= 1u;
@@ -21,6 +21,9 @@
 #include "../../inc/usb/xhci.h"
 #include "../../inc/usb/usb_types.h"
 #include "../../inc/usb/usb_core.h"
+#include "../kmalloc.h"
+#include "../dma.h"
+#include "../ktime.h"
 
 // ========= Pomocnicze =========
 static inline void write64(volatile u64* r, u64 v){ *r = v; __asm__ __volatile__("":::"memory"); }
@@ -125,14 +128,13 @@ static void xhci_reset(xhci_t* x) {
     if (!(mmio32_read(&x->op->USBSTS,0) & XHCI_USBSTS_HCH)) {
         u32 cmd = mmio32_read(&x->op->USBCMD,0);
         mmio32_write(&x->op->USBCMD,0, cmd & ~1u);
-        for (int i=0;i<1000000;i++){
-            if (mmio32_read(&x->op->USBSTS,0) & XHCI_USBSTS_HCH) break;
-        }
+        // xHCI: HCH najpóźniej po 16 ms od zdjęcia R/S
+        if (!KTIME_POLL_US(mmio32_read(&x->op->USBSTS,0) & XHCI_USBSTS_HCH, 20000))
+            klog("xhci","HCH nie ustawiony\n");
     }
     mmio32_write(&x->op->USBCMD,0, XHCI_USBCMD_HCRST);
-    for (int i=0;i<1000000;i++){
-        if (!(mmio32_read(&x->op->USBCMD,0) & XHCI_USBCMD_HCRST)) break;
-    }
+    if (!KTIME_POLL_US(!(mmio32_read(&x->op->USBCMD,0) & XHCI_USBCMD_HCRST), 1000000))
+        klog("xhci","HCRST nie zakończony\n");
 }
 
 static void xhci_start(xhci_t* x) {
@@ -144,7 +146,9 @@ static void event_ring_init(xhci_t* x){
     ring_init(&x->evt, XHCI_RING_TRBS);
     ring_alloc_dma(&x->evt);
 
-    xhci_erst_entry_t* erst = (xhci_erst_entry_t*)kzalloc(sizeof(xhci_erst_entry_t));
+    // ERST czyta kontroler – musi leżeć w pamięci DMA (wyrównanie 64 B)
+    u64 erst_phys = 0;
+    xhci_erst_entry_t* erst = (xhci_erst_entry_t*)kalloc_dma(sizeof(xhci_erst_entry_t), &erst_phys);
     erst->ring_base = x->evt.phys;
     erst->ring_size = x->evt.count;
 
@@ -156,7 +160,7 @@ static void event_ring_init(xhci_t* x){
     volatile u64* ERDP   = (volatile u64*)(rt + 0x40);
 
     *ERSTSZ = 1;
-    *ERSTBA = (u64)(uintptr_t)erst;
+    *ERSTBA = erst_phys;
     *ERDP   = x->evt.phys | 1ull; // EHB=1
     *IMOD   = 0;
     *IMAN   = 2; // IE
@@ -196,7 +200,7 @@ static void ports_power_and_reset(xhci_t* x){
         volatile u32* PORTSC = (volatile u32*)(opb + 0x400 + p*0x10);
         *PORTSC |= PORTSC_PR; // reset
     }
-    for (volatile int i=0;i<1000000;i++);
+    mdelay(50); // sam zdejmuje PR, dajemy portom czas na reset
 }
 
 static void log_ports(xhci_t* x){
@@ -397,10 +401,11 @@ static bool ep0_get_device_descriptor(xhci_t* x, u32 slotid, usb_device_desc_t*
             // inne eventy olewamy w tym demie
         }
     }
-    if (!got_data) return false;
+    if (!got_data) return false; // bufor zostaje – kontroler może jeszcze pisać
 
-    // Skopiuj wynik
+    // Skopiuj wynik, bufor wraca do puli DMA
     *out = *dbuf;
+    kfree_dma(dbuf, 64);
     return true;
 }
 
@@ -0,0 +1,437 @@
+/*
+ * [Cygnus] - [src/vcon.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "vcon.h"
+#include "cpu.h"
+#include "dma.h"
+#include "idt.h"
+#include "io.h"
+#include "irq.h"
+#include "klog.h"
+#include "ktime.h"
+#include "virtio.h"
+#include <string.h>
+
+#define VCON_PCI_DEVICE 0x1003 /* legacy / transitional */
+
+#define VCON_F_MULTIPORT (1u << 1)
+
+/* konfiguracja urządzenia */
+#define VCON_CFG_MAX_PORTS 4
+
+/* kolejki: port 0 – 0/1, sterowanie – 2/3, port n>0 – 2n+2 / 2n+3 */
+#define Q_CTRL_RX 2
+#define Q_CTRL_TX 3
+
+enum {
+  VCON_DEVICE_READY = 0,
+  VCON_DEVICE_ADD = 1,
+  VCON_DEVICE_REMOVE = 2,
+  VCON_PORT_READY = 3,
+  VCON_CONSOLE_PORT = 4,
+  VCON_RESIZE = 5,
+  VCON_PORT_OPEN = 6,
+  VCON_PORT_NAME = 7,
+};
+
+typedef struct __attribute__((packed)) {
+  uint32_t id;
+  uint16_t event;
+  uint16_t value;
+} vcon_ctrl_t;
+
+#define CTRL_RX_BUFS 4
+#define CTRL_TX_BUFS 4
+#define CTRL_BUF_SIZE 256
+#define CTRL_TX_TIMEOUT_US 100000 /* na zwrot bufora sterującego */
+
+typedef struct {
+  uint8_t *virt;
+  uint64_t phys;
+  uint32_t len; /* TX: zapisane; RX: odebrane */
+  uint32_t off; /* RX: przeczytane */
+} vbuf_t;
+
+typedef struct {
+  vcon_port_info_t info;
+  bool ready;                     /* kolejki i bufory założone */
+  virtq_t rx, tx;
+  vbuf_t rxb[VCON_RX_BUFS];
+  vbuf_t txb[VCON_TX_BUFS];
+  vbuf_t *tx_free[VCON_TX_BUFS];
+  int n_tx_free;
+  vbuf_t *tx_cur;                 /* wypełniany */
+  vbuf_t *rx_ready[VCON_RX_BUFS]; /* odebrane, kolejka */
+  uint32_t rx_head, rx_tail;
+  ksink_t sink;
+} vport_t;
+
+static virtio_dev_t g_dev;
+static bool g_on, g_multiport;
+static vport_t g_ports[VCON_MAX_PORTS];
+static virtq_t g_crx, g_ctx;
+static vbuf_t g_cbuf[CTRL_RX_BUFS + CTRL_TX_BUFS]; /* odbiór, potem wysyłanie */
+static vbuf_t *g_ctx_free[CTRL_TX_BUFS];
+static int g_n_ctx_free;
+
+static inline uint16_t q_rx(int port) {
+  return (uint16_t)(port ? 2 * port + 2 : 0);
+}
+
+/* ===== bufory ===== */
+
+static bool bufs_alloc(vbuf_t *b, int n, uint32_t size) {
+  uint64_t phys;
+  uint8_t *mem = dma_alloc((size_t)n * size, 4096, 0, &phys);
+  if (!mem) return false;
+  for (int i = 0; i < n; i++) {
+    b[i].virt = mem + i * size;
+    b[i].phys = phys + (uint64_t)i * size;
+    b[i].len = b[i].off = 0;
+  }
+  return true;
+}
+
+static void rx_post(virtq_t *q, vbuf_t *b, uint32_t size) {
+  b->len = b->off = 0;
+  virtq_add(q, b->phys, size, true, b);
+}
+
+/* ===== sterowanie ===== */
+
+/* Odbiera zwrócone bufory sterujące; true, jeżeli jest wolny. */
+static bool ctrl_reclaim(void) {
+  vbuf_t *b;
+  while ((b = virtq_get(&g_ctx, NULL))) g_ctx_free[g_n_ctx_free++] = b;
+  return g_n_ctx_free > 0;
+}
+
+static void ctrl_send(uint32_t id, uint16_t event, uint16_t value) {
+  /* QEMU odbiera komunikat sterujący od razu przy powiadomieniu, więc
+   * czekanie jest rzadkie; bufora, którego host nie oddał, nie ruszamy */
+  if (!KTIME_POLL_US(ctrl_reclaim(), CTRL_TX_TIMEOUT_US)) {
+    klogf(KLOG_WARN, "vcon: brak bufora sterującego, gubimy zdarzenie %u portu %u",
+          event, id);
+    return;
+  }
+  vbuf_t *b = g_ctx_free[--g_n_ctx_free];
+  vcon_ctrl_t *m = (vcon_ctrl_t *)b->virt;
+  m->id = id;
+  m->event = event;
+  m->value = value;
+  if (!virtq_add(&g_ctx, b->phys, sizeof(*m), false, b)) {
+    g_ctx_free[g_n_ctx_free++] = b;
+    return;
+  }
+  virtq_kick(&g_ctx);
+}
+
+static void port_start(int id) {
+  vport_t *p = &g_ports[id];
+  for (int i = 0; i < VCON_RX_BUFS; i++) rx_post(&p->rx, &p->rxb[i], VCON_BUF_SIZE);
+  virtq_kick(&p->rx);
+  p->info.present = true;
+}
+
+static void ctrl_handle(const vcon_ctrl_t *m, uint32_t len) {
+  vport_t *p = m->id < VCON_MAX_PORTS ? &g_ports[m->id] : NULL;
+  switch (m->event) {
+  case VCON_DEVICE_ADD:
+    if (p && p->ready) {
+      port_start((int)m->id);
+      ctrl_send(m->id, VCON_PORT_READY, 1);
+      ctrl_send(m->id, VCON_PORT_OPEN, 1); /* otwieramy od razu */
+    } else {
+      ctrl_send(m->id, VCON_PORT_READY, 0);
+    }
+    break;
+  case VCON_DEVICE_REMOVE:
+    if (p) p->info.present = false;
+    break;
+  case VCON_CONSOLE_PORT:
+    if (p) p->info.console = true;
+    break;
+  case VCON_PORT_OPEN:
+    if (p) p->info.host_open = m->value != 0;
+    break;
+  case VCON_PORT_NAME:
+    if (p) {
+      uint32_t n = len - sizeof(*m);
+      if (n >= VCON_NAME_MAX) n = VCON_NAME_MAX - 1;
+      memcpy(p->info.name, m + 1, n);
+      p->info.name[n] = 0;
+    }
+    break;
+  default: /* RESIZE itp. */
+    break;
+  }
+}
+
+/* ===== obsługa kolejek (przerwania wyłączone) ===== */
+
+static void poll_port(vport_t *p) {
+  vbuf_t *b;
+  uint32_t len;
+  while ((b = virtq_get(&p->tx, NULL)) != NULL) p->tx_free[p->n_tx_free++] = b;
+  bool repost = false;
+  while ((b = virtq_get(&p->rx, &len)) != NULL) {
+    if (!len) {
+      rx_post(&p->rx, b, VCON_BUF_SIZE);
+      repost = true;
+      continue;
+    }
+    b->len = len;
+    b->off = 0;
+    p->rx_ready[p->rx_head++ % VCON_RX_BUFS] = b;
+    p->info.rx_bytes += len;
+  }
+  if (repost) virtq_kick(&p->rx);
+}
+
+static void poll_all(void) {
+  if (g_multiport) {
+    vbuf_t *b;
+    uint32_t len;
+    bool repost = false;
+    while ((b = virtq_get(&g_crx, &len)) != NULL) {
+      if (len >= sizeof(vcon_ctrl_t)) ctrl_handle((const vcon_ctrl_t *)b->virt, len);
+      rx_post(&g_crx, b, CTRL_BUF_SIZE);
+      repost = true;
+    }
+    if (repost) virtq_kick(&g_crx);
+  }
+  for (int i = 0; i < VCON_MAX_PORTS; i++)
+    if (g_ports[i].ready) poll_port(&g_ports[i]);
+}
+
+static void vcon_irq(void) {
+  virtio_isr(&g_dev);
+  poll_all();
+}
+
+/* Czy wolno spać w hlt czekając na przerwanie urządzenia? */
+static inline bool can_sleep(void) {
+  return g_dev.irq != 0xFF && irqs_enabled() && !idt_isr_depth();
+}
+
+/* ===== init ===== */
+
+static bool port_setup(int id) {
+  vport_t *p = &g_ports[id];
+  if (virtq_setup(&g_dev, &p->rx, q_rx(id)) || virtq_setup(&g_dev, &p->tx, q_rx(id) + 1))
+    return false;
+  if (!p->rx.size || !p->tx.size) return false;
+  if (!bufs_alloc(p->rxb, VCON_RX_BUFS, VCON_BUF_SIZE) ||
+      !bufs_alloc(p->txb, VCON_TX_BUFS, VCON_BUF_SIZE))
+    return false;
+  for (int i = 0; i < VCON_TX_BUFS; i++) p->tx_free[i] = &p->txb[i];
+  p->n_tx_free = VCON_TX_BUFS;
+  p->sink.write = NULL; /* ustawiane w vcon_sink */
+  p->ready = true;
+  return true;
+}
+
+bool vcon_init(void) {
+  pci_addr_t pa;
+  if (!pci_find(VIRTIO_VENDOR, VCON_PCI_DEVICE, &pa)) return false;
+  if (virtio_legacy_init(&g_dev, &pa, VCON_F_MULTIPORT)) return false;
+  g_multiport = (g_dev.features & VCON_F_MULTIPORT) != 0;
+
+  uint32_t nports = 1;
+  if (g_multiport) {
+    nports = virtio_cfg32(&g_dev, VCON_CFG_MAX_PORTS);
+    if (nports > VCON_MAX_PORTS) nports = VCON_MAX_PORTS;
+    if (virtq_setup(&g_dev, &g_crx, Q_CTRL_RX) || virtq_setup(&g_dev, &g_ctx, Q_CTRL_TX) ||
+        !g_crx.size || !g_ctx.size || !bufs_alloc(g_cbuf, CTRL_RX_BUFS + CTRL_TX_BUFS, CTRL_BUF_SIZE))
+      goto fail;
+  }
+  for (uint32_t i = 0; i < nports; i++)
+    if (!port_setup((int)i) && i == 0) goto fail;
+
+  if (g_dev.irq != 0xFF) irq_register(g_dev.irq, vcon_irq, "virtio-console");
+  virtio_driver_ok(&g_dev);
+  g_on = true;
+
+  uint32_t fl = irq_save();
+  if (g_multiport) {
+    for (int i = 0; i < CTRL_RX_BUFS; i++) rx_post(&g_crx, &g_cbuf[i], CTRL_BUF_SIZE);
+    for (int i = 0; i < CTRL_TX_BUFS; i++) g_ctx_free[i] = &g_cbuf[CTRL_RX_BUFS + i];
+    g_n_ctx_free = CTRL_TX_BUFS;
+    virtq_kick(&g_crx);
+    ctrl_send(0, VCON_DEVICE_READY, 1); /* host odpowie DEVICE_ADD dla portów */
+    poll_all();
+  } else {
+    port_start(0);
+    g_ports[0].info.host_open = true;
+  }
+  irq_restore(fl);
+  return true;
+
+fail:
+  outb(g_dev.io + VIRTIO_REG_STATUS, VIRTIO_STATUS_FAILED);
+  return false;
+}
+
+bool vcon_present(void) { return g_on; }
+
+static vport_t *port_get(int port) {
+  if (!g_on || port < 0 || port >= VCON_MAX_PORTS) return NULL;
+  vport_t *p = &g_ports[port];
+  return p->info.present ? p : NULL;
+}
+
+bool vcon_port_info(int port, vcon_port_info_t *out) {
+  if (!g_on || port < 0 || port >= VCON_MAX_PORTS || !g_ports[port].ready) return false;
+  uint32_t fl = irq_save();
+  *out = g_ports[port].info;
+  out->kicks = g_ports[port].tx.kicks;
+  irq_restore(fl);
+  return true;
+}
+
+/* ===== nadawanie ===== */
+
+static void tx_submit(vport_t *p) {
+  vbuf_t *b = p->tx_cur;
+  p->tx_cur = NULL;
+  if (!b->len) {
+    p->tx_free[p->n_tx_free++] = b;
+    return;
+  }
+  virtq_add(&p->tx, b->phys, b->len, false, b);
+  virtq_kick(&p->tx);
+  p->info.tx_bytes += b->len;
+  p->info.tx_bufs++;
+}
+
+/* Czeka, aż host zwróci choć jeden bufor nadawczy. */
+static void tx_wait(vport_t *p) {
+  if (can_sleep()) CPU_WAIT_WHILE(p->tx.last_used == p->tx.used->idx);
+  uint32_t fl = irq_save();
+  poll_all();
+  irq_restore(fl);
+}
+
+void vcon_write(int port, const void *buf, size_t n) {
+  vport_t *p = port_get(port);
+  if (!p) return;
+  const uint8_t *s = buf;
+  while (n) {
+    uint32_t fl = irq_save();
+    if (!p->tx_cur) {
+      poll_port(p);
+      if (!p->n_tx_free) {
+        irq_restore(fl);
+        tx_wait(p);
+        continue;
+      }
+      p->tx_cur = p->tx_free[--p->n_tx_free];
+      p->tx_cur->len = 0;
+    }
+    vbuf_t *b = p->tx_cur;
+    uint32_t k = VCON_BUF_SIZE - b->len;
+    if (k > n) k = (uint32_t)n;
+    memcpy(b->virt + b->len, s, k);
+    b->len += k;
+    s += k;
+    n -= k;
+    if (b->len == VCON_BUF_SIZE) tx_submit(p);
+    irq_restore(fl);
+  }
+}
+
+void vcon_flush(int port) {
+  vport_t *p = port_get(port);
+  if (!p) return;
+  uint32_t fl = irq_save();
+  if (p->tx_cur) tx_submit(p);
+  irq_restore(fl);
+  for (;;) {
+    fl = irq_save();
+    poll_port(p);
+    bool done = p->n_tx_free == VCON_TX_BUFS;
+    irq_restore(fl);
+    if (done || !p->info.present) return;
+    tx_wait(p);
+  }
+}
+
+bool vcon_idle(void) {
+  if (!g_on) return false;
+  bool worked = false;
+  uint32_t fl = irq_save();
+  poll_all();
+  for (int i = 0; i < VCON_MAX_PORTS; i++) {
+    if (g_ports[i].tx_cur) {
+      tx_submit(&g_ports[i]);
+      worked = true;
+    }
+  }
+  irq_restore(fl);
+  return worked;
+}
+
+/* ===== odbiór ===== */
+
+int vcon_can_read(int port) {
+  vport_t *p = port_get(port);
+  if (!p) return 0;
+  uint32_t fl = irq_save();
+  poll_port(p);
+  int r = p->rx_head != p->rx_tail;
+  irq_restore(fl);
+  return r;
+}
+
+void vcon_wait(int port) {
+  vport_t *p = port_get(port);
+  if (p && can_sleep())
+    CPU_WAIT_WHILE(p->rx_head == p->rx_tail && p->rx.last_used == p->rx.used->idx);
+}
+
+char vcon_read(int port) {
+  vport_t *p = port_get(port);
+  if (!p) return 0;
+  while (!vcon_can_read(port)) vcon_wait(port);
+  uint32_t fl = irq_save();
+  vbuf_t *b = p->rx_ready[p->rx_tail % VCON_RX_BUFS];
+  char c = (char)b->virt[b->off++];
+  if (b->off == b->len) {
+    p->rx_tail++;
+    rx_post(&p->rx, b, VCON_BUF_SIZE);
+    virtq_kick(&p->rx);
+  }
+  irq_restore(fl);
+  return c;
+}
+
+/* ===== ujście ===== */
+
+static void vcon_sink_write(ksink_t *s, const char *buf, size_t n) {
+  vcon_write((int)(uintptr_t)s->ctx, buf, n);
+}
+
+ksink_t *vcon_sink(int port) {
+  if (!g_on || port < 0 || port >= VCON_MAX_PORTS || !g_ports[port].ready) return NULL;
+  vport_t *p = &g_ports[port];
+  p->sink.write = vcon_sink_write;
+  p->sink.ctx = (void *)(uintptr_t)port;
+  return &p->sink;
+}
@@ -0,0 +1,81 @@
+/*
+ * [Cygnus] - [src/vcon.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_VCON_H
+#define CYGNUS_VCON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../inc/std.h"
+
+/* virtio-console (virtio-serial) – porty jako strumienie bajtów.
+ *
+ * Zapis kopiuje do bufora DMA portu (VCON_BUF_SIZE); pełny bufor od razu
+ * idzie do kolejki nadawczej, niepełny – przy vcon_flush albo z hooka
+ * bezczynności. Do VCON_TX_BUFS buforów może być u hosta jednocześnie.
+ * Odbiór: VCON_RX_BUFS buforów czeka w kolejce odbiorczej, odebrane
+ * czytamy bajt po bajcie i oddajemy urządzeniu, gdy się skończą.
+ *
+ * Z VIRTIO_CONSOLE_F_MULTIPORT porty ogłasza host przez kolejkę
+ * sterującą (QEMU: -device virtserialport,name=...); bez niej jest tylko
+ * port 0. Kolejki dla VCON_MAX_PORTS portów zakładamy przy starcie.
+ */
+
+#define VCON_MAX_PORTS 4
+#define VCON_BUF_SIZE 4096
+#define VCON_TX_BUFS 16
+#define VCON_RX_BUFS 8
+#define VCON_NAME_MAX 32
+
+typedef struct {
+  bool present;      /* host dodał port */
+  bool host_open;    /* po stronie hosta ktoś jest podłączony */
+  bool console;      /* port konsoli (virtconsole) */
+  char name[VCON_NAME_MAX];
+  uint64_t rx_bytes;
+  uint64_t tx_bytes;
+  uint32_t tx_bufs;  /* buforów oddanych urządzeniu */
+  uint32_t kicks;    /* powiadomień kolejki nadawczej */
+} vcon_port_info_t;
+
+/* Szuka urządzenia (1AF4:1003), zakłada kolejki, włącza przerwanie.
+ * false, gdy urządzenia nie ma. Po irq_init i kmem_init. */
+bool vcon_init(void);
+bool vcon_present(void);
+
+bool vcon_port_info(int port, vcon_port_info_t *out);
+
+void vcon_write(int port, const void *buf, size_t n);
+/* Wysyła niepełny bufor i czeka, aż host odbierze wszystko. */
+void vcon_flush(int port);
+
+int vcon_can_read(int port);
+char vcon_read(int port); /* blokujący */
+/* Usypia do przerwania, jeżeli nie ma czego czytać. */
+void vcon_wait(int port);
+
+/* Hook bezczynności: wysyła niepełne bufory; true, jeżeli coś wysłał. */
+bool vcon_idle(void);
+
+/* Ujście kprintf/cat dla portu (NULL dla złego numeru). */
+ksink_t *vcon_sink(int port);
+
+#endif /* CYGNUS_VCON_H */
@@ -0,0 +1,145 @@
+/*
+ * [Cygnus] - [src/virtio.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "virtio.h"
+#include "dma.h"
+#include "io.h"
+#include "kmalloc.h"
+#include <stddef.h>
+#include <string.h>
+
+#define VIRTQ_ALIGN 4096u
+
+static inline void barrier(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+
+int virtio_legacy_init(virtio_dev_t *d, const pci_addr_t *pa, uint32_t want) {
+  uint32_t bar = pci_read32(pa->bus, pa->dev, pa->fun, PCI_BAR0);
+  if (!(bar & 1)) return -1;
+  d->io = (uint16_t)(bar & ~3u);
+  uint32_t line = pci_read32(pa->bus, pa->dev, pa->fun, PCI_INTERRUPT_LINE) & 0xFF;
+  d->irq = line < 16 ? (uint8_t)line : 0xFF;
+
+  uint32_t cmd = pci_read32(pa->bus, pa->dev, pa->fun, PCI_COMMAND);
+  pci_write32(pa->bus, pa->dev, pa->fun, PCI_COMMAND,
+              cmd | PCI_CMD_IO | PCI_CMD_BUS_MASTER);
+
+  outb(d->io + VIRTIO_REG_STATUS, 0); /* reset */
+  outb(d->io + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK);
+  outb(d->io + VIRTIO_REG_STATUS, VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER);
+  d->features = inl(d->io + VIRTIO_REG_HOST_FEATURES) & want;
+  outl(d->io + VIRTIO_REG_GUEST_FEATURES, d->features);
+  return 0;
+}
+
+void virtio_driver_ok(virtio_dev_t *d) {
+  outb(d->io + VIRTIO_REG_STATUS,
+       VIRTIO_STATUS_ACK | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+}
+
+uint8_t virtio_isr(virtio_dev_t *d) { return inb(d->io + VIRTIO_REG_ISR); }
+
+uint8_t virtio_cfg8(virtio_dev_t *d, uint32_t off) {
+  return inb((uint16_t)(d->io + VIRTIO_REG_CONFIG + off));
+}
+uint16_t virtio_cfg16(virtio_dev_t *d, uint32_t off) {
+  return inw((uint16_t)(d->io + VIRTIO_REG_CONFIG + off));
+}
+uint32_t virtio_cfg32(virtio_dev_t *d, uint32_t off) {
+  return inl((uint16_t)(d->io + VIRTIO_REG_CONFIG + off));
+}
+
+static inline uint32_t align_up(uint32_t v, uint32_t a) {
+  return (v + a - 1) & ~(a - 1);
+}
+
+int virtq_setup(virtio_dev_t *d, virtq_t *q, uint16_t index) {
+  memset(q, 0, sizeof(*q));
+  q->dev = d;
+  q->index = index;
+  outw(d->io + VIRTIO_REG_QUEUE_SEL, index);
+  uint16_t n = inw(d->io + VIRTIO_REG_QUEUE_SIZE);
+  if (!n) return 0;
+
+  /* układ legacy: desc | avail (+used_event), wyrównanie do 4 KiB | used */
+  uint32_t used_off = align_up(16u * n + 6u + 2u * n, VIRTQ_ALIGN);
+  uint32_t total = used_off + align_up(6u + 8u * n, VIRTQ_ALIGN);
+  uint64_t phys;
+  uint8_t *mem = dma_alloc(total, VIRTQ_ALIGN, 0, &phys);
+  q->cookie = kzalloc(n * sizeof(void *));
+  if (!mem || !q->cookie) {
+    if (mem) dma_free(mem, total, VIRTQ_ALIGN);
+    if (q->cookie) kfree(q->cookie);
+    q->cookie = NULL;
+    return -1;
+  }
+  memset(mem, 0, total);
+  q->mem = mem;
+  q->mem_size = total;
+  q->size = n;
+  q->desc = (virtq_desc_t *)mem;
+  q->avail = (virtq_avail_t *)(mem + 16u * n);
+  q->used = (volatile virtq_used_t *)(mem + used_off);
+  for (uint16_t i = 0; i < n; i++) q->desc[i].next = (uint16_t)(i + 1);
+  q->free_head = 0;
+  q->num_free = n;
+
+  outl(d->io + VIRTIO_REG_QUEUE_PFN, (uint32_t)(phys / VIRTQ_ALIGN));
+  return 0;
+}
+
+bool virtq_add(virtq_t *q, uint64_t phys, uint32_t len, bool dev_writes,
+               void *cookie) {
+  if (!q->num_free) return false;
+  uint16_t i = q->free_head;
+  q->free_head = q->desc[i].next;
+  q->num_free--;
+  q->desc[i].addr = phys;
+  q->desc[i].len = len;
+  q->desc[i].flags = dev_writes ? VIRTQ_DESC_F_WRITE : 0;
+  q->cookie[i] = cookie;
+  q->avail->ring[q->avail->idx % q->size] = i;
+  barrier(); /* deskryptor i wpis widoczne przed idx */
+  q->avail->idx++;
+  q->pending++;
+  return true;
+}
+
+void virtq_kick(virtq_t *q) {
+  if (!q->pending) return;
+  q->pending = 0;
+  barrier();
+  if (q->used->flags & VIRTQ_USED_F_NO_NOTIFY) return;
+  outw(q->dev->io + VIRTIO_REG_QUEUE_NOTIFY, q->index);
+  q->kicks++;
+}
+
+void *virtq_get(virtq_t *q, uint32_t *len) {
+  if (!q->size || q->last_used == q->used->idx) return NULL;
+  barrier();
+  volatile virtq_used_elem_t *e = &q->used->ring[q->last_used % q->size];
+  uint16_t i = (uint16_t)e->id;
+  if (len) *len = e->len;
+  q->last_used++;
+  void *c = q->cookie[i];
+  q->desc[i].next = q->free_head;
+  q->free_head = i;
+  q->num_free++;
+  return c;
+}
@@ -0,0 +1,131 @@
+/*
+ * [Cygnus] - [src/virtio.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_VIRTIO_H
+#define CYGNUS_VIRTIO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pci.h"
+
+/* Urządzenia virtio przez PCI w trybie legacy (rejestry w BAR0 I/O) i
+ * kolejki virtqueue w układzie "split": deskryptory + avail + used w
+ * jednym fizycznie ciągłym bloku DMA.
+ *
+ * Każdy bufor to jeden deskryptor (bez łańcuchów) z dowolnym wskaźnikiem
+ * 'cookie', który wraca przy odbiorze z kolejki used. Powiadomienie
+ * urządzenia (virtq_kick) jest osobno, żeby kilka buforów szło jednym
+ * zapisem do portu – o ile urządzenie w ogóle chce powiadomień.
+ */
+
+#define VIRTIO_VENDOR 0x1AF4
+
+/* rejestry legacy względem BAR0 */
+enum {
+  VIRTIO_REG_HOST_FEATURES = 0x00,
+  VIRTIO_REG_GUEST_FEATURES = 0x04,
+  VIRTIO_REG_QUEUE_PFN = 0x08,
+  VIRTIO_REG_QUEUE_SIZE = 0x0C,
+  VIRTIO_REG_QUEUE_SEL = 0x0E,
+  VIRTIO_REG_QUEUE_NOTIFY = 0x10,
+  VIRTIO_REG_STATUS = 0x12,
+  VIRTIO_REG_ISR = 0x13,
+  VIRTIO_REG_CONFIG = 0x14, /* bez MSI-X */
+};
+
+#define VIRTIO_STATUS_ACK 0x01
+#define VIRTIO_STATUS_DRIVER 0x02
+#define VIRTIO_STATUS_DRIVER_OK 0x04
+#define VIRTIO_STATUS_FAILED 0x80
+
+typedef struct {
+  uint16_t io;         /* baza BAR0 */
+  uint8_t irq;         /* linia INTx (0xFF = brak) */
+  uint32_t features;   /* wynegocjowane */
+} virtio_dev_t;
+
+typedef struct __attribute__((packed)) {
+  uint64_t addr;
+  uint32_t len;
+  uint16_t flags;
+  uint16_t next;
+} virtq_desc_t;
+
+#define VIRTQ_DESC_F_WRITE 2 /* bufor zapisuje urządzenie */
+#define VIRTQ_USED_F_NO_NOTIFY 1
+
+typedef struct {
+  uint16_t flags;
+  uint16_t idx;
+  uint16_t ring[];
+} virtq_avail_t;
+
+typedef struct {
+  uint32_t id;
+  uint32_t len;
+} virtq_used_elem_t;
+
+typedef struct {
+  uint16_t flags;
+  uint16_t idx;
+  virtq_used_elem_t ring[];
+} virtq_used_t;
+
+typedef struct {
+  virtio_dev_t *dev;
+  uint16_t index;
+  uint16_t size;       /* 0 = kolejki nie ma */
+  virtq_desc_t *desc;
+  virtq_avail_t *avail;
+  volatile virtq_used_t *used;
+  uint16_t free_head;  /* lista wolnych deskryptorów po 'next' */
+  uint16_t num_free;
+  uint16_t last_used;
+  uint16_t pending;    /* dodane od ostatniego kick */
+  void **cookie;
+  void *mem;
+  uint32_t mem_size;
+  uint32_t kicks;
+} virtq_t;
+
+/* Reset, ACK|DRIVER i negocjacja cech (host & want). Włącza bus master.
+ * Zwraca 0 albo -1, gdy BAR0 nie jest portem I/O. */
+int virtio_legacy_init(virtio_dev_t *d, const pci_addr_t *pa, uint32_t want);
+void virtio_driver_ok(virtio_dev_t *d);
+/* Odczyt ISR – jednocześnie potwierdza przerwanie. */
+uint8_t virtio_isr(virtio_dev_t *d);
+
+uint8_t virtio_cfg8(virtio_dev_t *d, uint32_t off);
+uint16_t virtio_cfg16(virtio_dev_t *d, uint32_t off);
+uint32_t virtio_cfg32(virtio_dev_t *d, uint32_t off);
+
+/* Przydziela i rejestruje kolejkę 'index'; 0 gdy OK (q->size == 0, gdy
+ * urządzenie jej nie ma), -1 przy braku pamięci. */
+int virtq_setup(virtio_dev_t *d, virtq_t *q, uint16_t index);
+
+/* Dodaje bufor ('cookie' != NULL); false, gdy brak wolnych deskryptorów. */
+bool virtq_add(virtq_t *q, uint64_t phys, uint32_t len, bool dev_writes,
+               void *cookie);
+/* Powiadamia urządzenie o dodanych buforach (jeżeli o to prosi). */
+void virtq_kick(virtq_t *q);
+/* Następny bufor zwrócony przez urządzenie albo NULL; *len = ile zapisało. */
+void *virtq_get(virtq_t *q, uint32_t *len);
+
+#endif /* CYGNUS_VIRTIO_H */
@@ -0,0 +1,259 @@
+/*
+ * [Cygnus] - [src/vm.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "vm.h"
+#include "idt.h"
+#include "kmalloc.h"
+#include "memstat.h"
+#include "paging.h"
+#include "../inc/std.h"
+#include <string.h>
+
+typedef struct vm_region {
+  uintptr_t start, end; /* [start, end), wyrównane do stron */
+  uint32_t flags;
+  uint32_t resident;
+  uint32_t faults;
+  char name[VM_NAME_MAX];
+  /* drzewo przedziałów */
+  struct vm_region *left, *right;
+  uintptr_t max_end; /* największy 'end' w poddrzewie */
+  int height;
+} vm_region_t;
+
+static kmem_cache_t *g_region_cache;
+static vm_region_t *g_root;
+static uint32_t g_regions, g_reserved_pages, g_faults;
+static bool g_ready;
+
+/* ===== drzewo AVL z rozszerzeniem max_end ===== */
+
+static int height(const vm_region_t *n) { return n ? n->height : 0; }
+
+static void update(vm_region_t *n) {
+  int hl = height(n->left), hr = height(n->right);
+  n->height = 1 + (hl > hr ? hl : hr);
+  n->max_end = n->end;
+  if (n->left && n->left->max_end > n->max_end) n->max_end = n->left->max_end;
+  if (n->right && n->right->max_end > n->max_end) n->max_end = n->right->max_end;
+}
+
+static vm_region_t *rot_right(vm_region_t *n) {
+  vm_region_t *l = n->left;
+  n->left = l->right;
+  l->right = n;
+  update(n);
+  update(l);
+  return l;
+}
+
+static vm_region_t *rot_left(vm_region_t *n) {
+  vm_region_t *r = n->right;
+  n->right = r->left;
+  r->left = n;
+  update(n);
+  update(r);
+  return r;
+}
+
+static vm_region_t *rebalance(vm_region_t *n) {
+  update(n);
+  int bal = height(n->left) - height(n->right);
+  if (bal > 1) {
+    if (height(n->left->left) < height(n->left->right))
+      n->left = rot_left(n->left);
+    return rot_right(n);
+  }
+  if (bal < -1) {
+    if (height(n->right->right) < height(n->right->left))
+      n->right = rot_right(n->right);
+    return rot_left(n);
+  }
+  return n;
+}
+
+static vm_region_t *tree_insert(vm_region_t *n, vm_region_t *r) {
+  if (!n) return r;
+  if (r->start < n->start) n->left = tree_insert(n->left, r);
+  else n->right = tree_insert(n->right, r);
+  return rebalance(n);
+}
+
+/* Odpina najmniejszy węzeł poddrzewa; zwraca nowy korzeń, węzeł w *min. */
+static vm_region_t *tree_pop_min(vm_region_t *n, vm_region_t **min) {
+  if (!n->left) {
+    *min = n;
+    return n->right;
+  }
+  n->left = tree_pop_min(n->left, min);
+  return rebalance(n);
+}
+
+static vm_region_t *tree_remove(vm_region_t *n, const vm_region_t *r) {
+  if (!n) return NULL;
+  if (r->start < n->start) {
+    n->left = tree_remove(n->left, r);
+  } else if (r->start > n->start) {
+    n->right = tree_remove(n->right, r);
+  } else {
+    if (!n->left || !n->right) return n->left ? n->left : n->right;
+    vm_region_t *succ;
+    vm_region_t *right = tree_pop_min(n->right, &succ);
+    succ->left = n->left;
+    succ->right = right;
+    n = succ;
+  }
+  return rebalance(n);
+}
+
+/* Pierwszy region, który nachodzi na [start, end). */
+static vm_region_t *tree_overlap(uintptr_t start, uintptr_t end) {
+  vm_region_t *n = g_root;
+  while (n) {
+    if (n->start < end && start < n->end) return n;
+    /* lewe poddrzewo ma szansę tylko, gdy coś w nim sięga za 'start' */
+    if (n->left && n->left->max_end > start) n = n->left;
+    else n = n->right;
+  }
+  return NULL;
+}
+
+/* ===== rezerwacja ===== */
+
+/* Pierwsza luka >= 'len' (plus strona odstępu) przy przejściu in-order. */
+static bool find_gap(vm_region_t *n, uintptr_t len, uintptr_t *cursor) {
+  if (!n) return false;
+  if (find_gap(n->left, len, cursor)) return true;
+  if (n->start >= *cursor && n->start - *cursor >= len + PAGE_SIZE) return true;
+  *cursor = n->end + PAGE_SIZE;
+  return find_gap(n->right, len, cursor);
+}
+
+void *vm_reserve(size_t size, uint32_t flags, const char *name) {
+  if (!g_ready || !size) return NULL;
+  uintptr_t len = (size + PAGE_SIZE - 1u) & PAGE_MASK;
+
+  uintptr_t at = VM_ARENA_BASE;
+  find_gap(g_root, len, &at);
+  if (at > VM_ARENA_END || VM_ARENA_END - at < len) return NULL;
+  if (tree_overlap(at, at + len)) return NULL; /* nie powinno się zdarzyć */
+
+  vm_region_t *r = kmem_cache_zalloc(g_region_cache);
+  if (!r) return NULL;
+  r->start = at;
+  r->end = at + len;
+  r->flags = flags;
+  strncpy(r->name, name ? name : "?", VM_NAME_MAX - 1);
+  r->height = 1;
+  r->max_end = r->end;
+  g_root = tree_insert(g_root, r);
+  g_regions++;
+  g_reserved_pages += len / PAGE_SIZE;
+  return (void *)at;
+}
+
+int vm_release(void *base) {
+  vm_region_t *r = tree_overlap((uintptr_t)base, (uintptr_t)base + 1);
+  if (!r || r->start != (uintptr_t)base) return -1;
+
+  /* jedna partia: puste sloty 4 MiB są pomijane, ramki wracają po flushu */
+  if (r->resident) paging_unmap_range(r->start, r->end - r->start, true);
+  mem_account_free(MEM_VM, (size_t)r->resident * PAGE_SIZE);
+  g_root = tree_remove(g_root, r);
+  g_regions--;
+  g_reserved_pages -= (r->end - r->start) / PAGE_SIZE;
+  kmem_cache_free(g_region_cache, r);
+  return 0;
+}
+
+/* ===== page fault ===== */
+
+bool vm_handle_fault(uintptr_t addr, uint32_t err) {
+  if (err & 1u) return false; /* naruszenie uprawnień, nie brak strony */
+  vm_region_t *r = tree_overlap(addr, addr + 1);
+  if (!r) return false;
+  if ((err & 2u) && !(r->flags & VM_WRITE)) return false;
+
+  uintptr_t frame = pmm_alloc_zeroed();
+  if (!frame) return false;
+  paging_map_page(frame, addr & PAGE_MASK,
+                  (r->flags & VM_WRITE) ? PG_RW : 0);
+  mem_account_alloc(MEM_VM, PAGE_SIZE);
+  r->resident++;
+  r->faults++;
+  g_faults++;
+  return true;
+}
+
+static uintptr_t read_cr2(void) {
+  uintptr_t v;
+  __asm__ volatile("mov %%cr2, %0" : "=r"(v));
+  return v;
+}
+
+static void vm_fault_isr(isr_frame_t *f) {
+  uintptr_t addr = read_cr2();
+  if (vm_handle_fault(addr, f->err)) return;
+  kprintf("\n[PANIC] Page fault poza regionem VM, eip=%x\n", f->eip);
+  page_fault_isr(addr, f->err);
+}
+
+void vm_init(void) {
+  g_region_cache = kmem_cache_create("vm_region", sizeof(vm_region_t), 0);
+  idt_set_handler(VEC_PAGE_FAULT, vm_fault_isr);
+  if (!g_region_cache) return;
+  /* okno musi być wolne – mapa bezpośrednia obejmuje tylko RAM */
+  if (paging_virt_to_phys(VM_ARENA_BASE) ||
+      paging_virt_to_phys(VM_ARENA_END - PAGE_SIZE)) {
+    kprintf("[WARN] VM: okno 0x%x zajęte przez mapę RAM, regiony wyłączone\n",
+            VM_ARENA_BASE);
+    return;
+  }
+  g_ready = true;
+}
+
+/* ===== statystyki ===== */
+
+static void walk(const vm_region_t *n,
+                 void (*fn)(const vm_region_stats_t *, void *), void *ctx) {
+  if (!n) return;
+  walk(n->left, fn, ctx);
+  vm_region_stats_t st = {n->name, n->start,
+                          (uint32_t)((n->end - n->start) / PAGE_SIZE),
+                          n->resident, n->faults};
+  fn(&st, ctx);
+  walk(n->right, fn, ctx);
+}
+
+void vm_walk(void (*fn)(const vm_region_stats_t *st, void *ctx), void *ctx) {
+  walk(g_root, fn, ctx);
+}
+
+static void sum_resident(const vm_region_stats_t *st, void *ctx) {
+  *(uint32_t *)ctx += st->resident;
+}
+
+void vm_get_stats(vm_stats_t *out) {
+  out->regions = g_regions;
+  out->reserved_pages = g_reserved_pages;
+  out->resident_pages = 0;
+  vm_walk(sum_resident, &out->resident_pages);
+  out->faults = g_faults;
+}
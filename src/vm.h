@@ -0,0 +1,89 @@
+/*
+ * [Cygnus] - [src/vm.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_VM_H
+#define CYGNUS_VM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Regiony pamięci wirtualnej z leniwym przydziałem (demand-zero).
+ *
+ * vm_reserve rezerwuje tylko przestrzeń adresową w oknie
+ * [VM_ARENA_BASE, VM_ARENA_END) – bez ramek i bez wpisów w tablicach stron.
+ * Pierwsze dotknięcie strony kończy się page faultem "not-present"; jeżeli
+ * adres leży w regionie, dokładamy wyzerowaną ramkę z PMM, mapujemy ją
+ * i wracamy do przerwanej instrukcji (minor fault). Dzięki temu duże bufory
+ * i cache kosztują tylko tyle ramek, ile stron faktycznie użyto.
+ *
+ * Regiony trzymamy w drzewie przedziałów (AVL po początku regionu,
+ * w węzłach maksymalny koniec poddrzewa), więc wyszukanie regionu dla
+ * adresu z CR2 i sprawdzenie kolizji przy rezerwacji to O(log n).
+ * Między regionami zostaje jedna niezmapowana strona – wyjście poza bufor
+ * kończy się paniką, a nie cichym zapisem do sąsiada.
+ */
+
+#ifndef VM_ARENA_BASE
+#define VM_ARENA_BASE 0xC0000000u
+#endif
+#ifndef VM_ARENA_END
+#define VM_ARENA_END 0xD0000000u
+#endif
+
+#define VM_NAME_MAX 16
+
+/* flagi regionu */
+#define VM_WRITE (1u << 0) /* strony zapisywalne */
+
+typedef struct {
+  const char *name;
+  uintptr_t start;
+  uint32_t pages;    /* rozmiar regionu w stronach */
+  uint32_t resident; /* strony z ramką */
+  uint32_t faults;   /* minor faulty (strony dołożone na żądanie) */
+} vm_region_stats_t;
+
+typedef struct {
+  uint32_t regions;
+  uint32_t reserved_pages;
+  uint32_t resident_pages;
+  uint32_t faults;
+} vm_stats_t;
+
+/* Po kmem_init: tworzy cache węzłów i podpina obsługę wektora 14. */
+void vm_init(void);
+
+/* Rezerwuje 'size' bajtów (w górę do stron). Zwraca początek regionu albo
+ * NULL, gdy w oknie nie ma miejsca. */
+void *vm_reserve(size_t size, uint32_t flags, const char *name);
+
+/* Zwalnia region zaczynający się w 'base' razem z jego ramkami.
+ * Zwraca 0 gdy OK, -1 gdy to nie jest początek regionu. */
+int vm_release(void *base);
+
+/* Obsługa page faultu; true, jeżeli strona została dołożona. */
+bool vm_handle_fault(uintptr_t addr, uint32_t err);
+
+/* Regiony w kolejności adresów. */
+void vm_walk(void (*fn)(const vm_region_stats_t *st, void *ctx), void *ctx);
+void vm_get_stats(vm_stats_t *out);
+
+#endif /* CYGNUS_VM_H */
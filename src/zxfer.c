@@ -0,0 +1,388 @@
+/*
+ * [Cygnus] - [src/zxfer.c]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#include "zxfer.h"
+#include "checksum.h"
+#include "cpu.h"
+#include "fat16.h"
+#include "ktime.h"
+#include "../inc/serial.h"
+#include <string.h>
+
+#define ZDLE 0x18
+#define MARK 0x100 /* get_esc: ZDLE + typ ramki */
+
+enum {
+  RD_TIMEOUT = -1,
+  RD_CANCEL = -2,
+  RD_BAD = -3,
+};
+
+typedef struct {
+  uint8_t type;
+  uint32_t pos;
+  uint16_t len;
+} zx_hdr_t;
+
+static uint8_t g_data[ZX_MAX_BLOCK];                /* dane odebranej ramki */
+static uint8_t g_block[ZX_MAX_BLOCK];               /* blok do wysłania */
+static uint8_t g_frame[2 + 2 * (10 + ZX_MAX_BLOCK)]; /* ramka po escapowaniu */
+
+/* ===== ramki ===== */
+
+static inline int needs_esc(uint8_t b) {
+  return b == ZDLE || (b & 0x7F) == 0x11 || (b & 0x7F) == 0x13;
+}
+
+static uint8_t *put_esc(uint8_t *o, const uint8_t *p, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    if (needs_esc(p[i])) {
+      *o++ = ZDLE;
+      *o++ = p[i] ^ 0x40;
+    } else {
+      *o++ = p[i];
+    }
+  }
+  return o;
+}
+
+static inline void put_le32(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint32_t get_le32(const uint8_t *p) {
+  return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+/* Jedna ramka jednym zapisem – pierścień nadawczy UART dostaje ją w
+ * całości i wypycha z przerwania, a my w tym czasie szykujemy następną. */
+static void send_frame(uint8_t type, uint32_t pos, const void *data, uint16_t len) {
+  uint8_t h[6], c[4];
+  put_le32(h, pos);
+  h[4] = (uint8_t)len;
+  h[5] = (uint8_t)(len >> 8);
+  uint32_t crc = crc32_update(0, &type, 1);
+  crc = crc32_update(crc, h, sizeof(h));
+  crc = crc32_update(crc, data, len);
+  put_le32(c, crc);
+
+  uint8_t *o = g_frame;
+  *o++ = ZDLE;
+  *o++ = type;
+  o = put_esc(o, h, sizeof(h));
+  o = put_esc(o, data, len);
+  o = put_esc(o, c, sizeof(c));
+  serial_write_raw(g_frame, (size_t)(o - g_frame));
+}
+
+static int get_byte(void) {
+  if (!KTIME_POLL_US(serial_can_read(), ZX_TIMEOUT_MS * 1000u)) return RD_TIMEOUT;
+  return (uint8_t)serial_read();
+}
+
+/* Bajt danych, MARK | typ na początku ramki albo RD_*. */
+static int get_esc(void) {
+  int c = get_byte();
+  if (c != ZDLE) return c;
+  c = get_byte();
+  if (c < 0) return c;
+  if (c == ZDLE) return RD_CANCEL;
+  if (c >= 'a' && c <= 'z') return MARK | c;
+  return c ^ 0x40;
+}
+
+/* 0 gdy przeczytane 'n' bajtów, inaczej to, co przerwało (RD_* albo
+ * początek nowej ramki). */
+static int get_n(uint8_t *p, uint32_t n) {
+  for (uint32_t i = 0; i < n; i++) {
+    int c = get_esc();
+    if (c < 0 || (c & MARK)) return c;
+    p[i] = (uint8_t)c;
+  }
+  return 0;
+}
+
+/* Następna poprawna ramka (dane w g_data). Śmieci przed ramką – np. echo
+ * wpisanej komendy – pomijamy; ucięta ramka kończy się na początku
+ * następnej. */
+static int read_frame(zx_hdr_t *f, zx_stats_t *st) {
+  int c;
+  do {
+    c = get_esc();
+  } while (c >= 0 && !(c & MARK));
+
+  while (c > 0) {
+    uint8_t h[6], cb[4];
+    f->type = (uint8_t)c;
+    if ((c = get_n(h, sizeof(h))) != 0) continue;
+    f->pos = get_le32(h);
+    f->len = (uint16_t)(h[4] | h[5] << 8);
+    if (f->len > ZX_MAX_BLOCK) {
+      st->bad_frames++;
+      return RD_BAD;
+    }
+    if ((c = get_n(g_data, f->len)) != 0) continue;
+    if ((c = get_n(cb, sizeof(cb))) != 0) continue;
+    uint32_t crc = crc32_update(0, &f->type, 1);
+    crc = crc32_update(crc, h, sizeof(h));
+    crc = crc32_update(crc, g_data, f->len);
+    if (crc != get_le32(cb)) {
+      st->bad_frames++;
+      return RD_BAD;
+    }
+    return 0;
+  }
+  if (c == RD_TIMEOUT) st->timeouts++;
+  return c;
+}
+
+static void send_abort(void) {
+  send_frame('x', 0, NULL, 0);
+  serial_flush();
+}
+
+/* ===== odbiór ===== */
+
+/* Plik docelowy: 'path', a gdy to katalog – katalog + nazwa nadawcy. */
+static int open_dest(const char *path, const char *name) {
+  char full[FAT16_MAX_NAME];
+  size_t n = strlen(path);
+  if (!n || path[n - 1] == '/') {
+    const char *slash = strrchr(name, '/');
+    if (slash) name = slash + 1;
+    if (!n) path = "/", n = 1;
+    if (n + strlen(name) >= sizeof(full) || !*name) return -1;
+    memcpy(full, path, n);
+    strcpy(full + n, name);
+  } else {
+    if (n >= sizeof(full)) return -1;
+    strcpy(full, path);
+  }
+  /* nadpisujemy – fat16_open nie skraca istniejącego pliku */
+  int fd = fat16_open(full, 0);
+  if (fd >= 0) {
+    fat16_close(fd);
+    if (fat16_unlink(full)) return -1;
+  }
+  return fat16_open(full, 1);
+}
+
+int zx_receive(const char *path, zx_stats_t *st) {
+  memset(st, 0, sizeof(*st));
+  uint64_t t0 = rdtsc();
+  uint8_t init[2] = {(uint8_t)ZX_MAX_BLOCK, (uint8_t)(ZX_MAX_BLOCK >> 8)};
+  uint32_t size = 0, expected = 0, acked = 0, crc = 0;
+  int fd = -1, tries = 0, rc = 0;
+  int nak = 0; /* prośba o powtórkę wysłana, czekamy na 'expected' */
+
+  send_frame('i', ZX_WINDOW, init, sizeof(init));
+  for (;;) {
+    zx_hdr_t f;
+    int r = read_frame(&f, st);
+    if (r == RD_CANCEL) { rc = ZX_ERR_CANCEL; break; }
+    if (r == RD_TIMEOUT) {
+      if (++tries > (fd < 0 ? ZX_START_RETRIES : ZX_RETRIES)) { rc = ZX_ERR_TIMEOUT; break; }
+      if (fd < 0) send_frame('i', ZX_WINDOW, init, sizeof(init));
+      else send_frame('r', expected, NULL, 0);
+      continue;
+    }
+    if (r == RD_BAD) {
+      if (fd >= 0 && !nak) {
+        send_frame('r', expected, NULL, 0);
+        nak = 1;
+      }
+      continue;
+    }
+    tries = 0;
+
+    if (f.type == 'x') { rc = ZX_ERR_CANCEL; break; }
+    if (f.type == 'f') {
+      if (fd < 0) {
+        if (f.pos > FAT16_MAX_FILESIZE) { send_abort(); rc = ZX_ERR_TOOBIG; break; }
+        uint32_t n = f.len < ZX_NAME_MAX - 1 ? f.len : ZX_NAME_MAX - 1;
+        memcpy(st->name, g_data, n);
+        st->name[n] = 0;
+        fd = open_dest(path, st->name);
+        if (fd < 0) { send_abort(); rc = ZX_ERR_FS; break; }
+        size = f.pos;
+      }
+      send_frame('r', expected, NULL, 0); /* także gdy zginęła nasza odpowiedź */
+      continue;
+    }
+    if (fd < 0) continue;
+
+    if (f.type == 'd') {
+      if (f.pos != expected) {
+        /* dziura (zgubiona ramka) – raz prosimy o powtórkę; starsze,
+         * już przyjęte dane po cofnięciu nadawcy pomijamy */
+        if (f.pos > expected && !nak) {
+          send_frame('r', expected, NULL, 0);
+          st->rewinds++;
+          nak = 1;
+        }
+        continue;
+      }
+      if (expected + f.len > size || fat16_write(fd, g_data, f.len) != f.len) {
+        send_abort();
+        rc = ZX_ERR_FS;
+        break;
+      }
+      crc = crc32_update(crc, g_data, f.len);
+      expected += f.len;
+      st->frames++;
+      nak = 0;
+      if (expected - acked >= ZX_ACK_EVERY) {
+        send_frame('a', expected, NULL, 0);
+        acked = expected;
+      }
+      continue;
+    }
+    if (f.type == 'e') {
+      if (f.pos != expected || expected != size) {
+        send_frame('r', expected, NULL, 0);
+        continue;
+      }
+      uint8_t c[4];
+      put_le32(c, crc);
+      send_frame('k', crc, c, sizeof(c));
+      if (f.len == 4 && get_le32(g_data) != crc) { rc = ZX_ERR_CRC; break; }
+      /* czekamy na 'z'; zgubione 'k' nadawca wymusi powtórzonym 'e' */
+      for (int i = 0; i < 3; i++) {
+        r = read_frame(&f, st);
+        if (r == RD_TIMEOUT || r == RD_CANCEL || (r == 0 && (f.type == 'z' || f.type == 'x'))) break;
+        if (r == 0 && f.type == 'e') send_frame('k', crc, c, sizeof(c));
+      }
+      break;
+    }
+  }
+  if (fd >= 0) fat16_close(fd);
+  if (rc == ZX_ERR_TIMEOUT) send_abort();
+  serial_flush();
+  st->bytes = expected;
+  st->crc32 = crc;
+  st->ticks = rdtsc() - t0;
+  return rc;
+}
+
+/* ===== nadawanie ===== */
+
+int zx_send(const char *path, zx_stats_t *st) {
+  memset(st, 0, sizeof(*st));
+  int fd = fat16_open(path, 0);
+  if (fd < 0) return ZX_ERR_FS;
+  uint32_t size = (uint32_t)fat16_size(fd);
+  const char *name = strrchr(path, '/');
+  name = name ? name + 1 : path;
+  strncpy(st->name, name, ZX_NAME_MAX - 1);
+
+  /* CRC całości z góry – plik i tak leży w RAM */
+  uint32_t crc = 0;
+  for (;;) {
+    int n = fat16_read(fd, g_block, ZX_MAX_BLOCK);
+    if (n <= 0) break;
+    crc = crc32_update(crc, g_block, (uint32_t)n);
+  }
+  uint64_t t0 = rdtsc();
+  uint32_t window = ZX_WINDOW, block = ZX_BLOCK;
+  uint32_t pos = 0, acked = 0;
+  int rc = 0, tries = 0, stage = 0; /* 0 – czekamy na 'i', 1 – na 'r' */
+  zx_hdr_t f;
+
+  while (stage < 2) {
+    int r = read_frame(&f, st);
+    if (r == RD_CANCEL || (r == 0 && f.type == 'x')) { rc = ZX_ERR_CANCEL; goto out; }
+    if (r == RD_TIMEOUT) {
+      if (++tries > (stage ? ZX_RETRIES : ZX_START_RETRIES)) { rc = ZX_ERR_TIMEOUT; goto out; }
+      if (stage) send_frame('f', size, st->name, (uint16_t)strlen(st->name));
+      continue;
+    }
+    if (r) continue;
+    if (f.type == 'i') {
+      if (f.pos && f.pos < window) window = f.pos;
+      if (f.len >= 2) {
+        uint32_t b = g_data[0] | (uint32_t)g_data[1] << 8;
+        if (b && b < block) block = b;
+      }
+      if (block > window) block = window;
+      send_frame('f', size, st->name, (uint16_t)strlen(st->name));
+      stage = 1;
+    } else if (f.type == 'r' && stage == 1) {
+      stage = 2;
+    }
+  }
+
+  pos = acked = f.pos <= size ? f.pos : 0;
+  int eof_sent = 0;
+  tries = 0;
+  for (;;) {
+    /* okno otwarte – ramka za ramką; potwierdzenia zbieramy po drodze */
+    while (pos < size && pos - acked < window && !serial_can_read()) {
+      uint32_t n = size - pos < block ? size - pos : block;
+      fat16_seek(fd, (int)pos);
+      if (fat16_read(fd, g_block, (int)n) != (int)n) { send_abort(); rc = ZX_ERR_FS; goto out; }
+      send_frame('d', pos, g_block, (uint16_t)n);
+      pos += n;
+      st->frames++;
+    }
+    if (pos == size && !eof_sent) {
+      uint8_t c[4];
+      put_le32(c, crc);
+      send_frame('e', size, c, sizeof(c));
+      eof_sent = 1;
+    }
+    if (pos < size && pos - acked < window && !serial_can_read()) continue;
+
+    int r = read_frame(&f, st);
+    if (r == RD_CANCEL) { rc = ZX_ERR_CANCEL; break; }
+    if (r == RD_TIMEOUT) {
+      if (++tries > ZX_RETRIES) { send_abort(); rc = ZX_ERR_TIMEOUT; break; }
+      pos = acked; /* nic nie wróciło – powtarzamy od potwierdzonego */
+      eof_sent = 0;
+      continue;
+    }
+    if (r) continue;
+    tries = 0;
+    if (f.type == 'a' && f.pos > acked && f.pos <= size) {
+      acked = f.pos;
+    } else if (f.type == 'r' && f.pos <= size) {
+      acked = pos = f.pos; /* odbiorca ma wszystko przed f.pos */
+      eof_sent = 0;
+      st->rewinds++;
+    } else if (f.type == 'k') {
+      send_frame('z', 0, NULL, 0);
+      if (f.pos != crc) rc = ZX_ERR_CRC;
+      acked = size;
+      break;
+    } else if (f.type == 'x') {
+      rc = ZX_ERR_CANCEL;
+      break;
+    }
+  }
+out:
+  fat16_close(fd);
+  serial_flush();
+  st->bytes = acked;
+  st->crc32 = crc;
+  st->ticks = rdtsc() - t0;
+  return rc;
+}
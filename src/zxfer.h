@@ -0,0 +1,96 @@
+/*
+ * [Cygnus] - [src/zxfer.h]
+ *
+ * Copyright (C) [2025] [Szymon Grajner]
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+ * soon as they will be approved by the European Commission - subsequent
+ * versions of the EUPL (the "Licence").
+ *
+ * You may not use this work except in compliance with the Licence.
+ * You may obtain a copy of the Licence at:
+ * https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the Licence is distributed on an "AS IS" basis,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the Licence for the specific language governing permissions and
+ * limitations under the Licence.
+ */
+#ifndef CYGNUS_ZXFER_H
+#define CYGNUS_ZXFER_H
+
+#include <stdint.h>
+
+/* Przesyłanie plików przez COM1 w stylu ZMODEM, do/z dysku RAM (fat16.c).
+ *
+ * Ramka: ZDLE (0x18), typ ('a'..'z'), potem z escapowaniem: pozycja
+ * (u32 LE), długość danych (u16 LE), dane, CRC32 (u32 LE) liczone po
+ * typie, nagłówku i danych. Escapujemy ZDLE oraz XON/XOFF (też z bitem
+ * 7) jako ZDLE, b ^ 0x40, więc ZDLE + mała litera zawsze zaczyna ramkę,
+ * a ZDLE ZDLE (dwa razy Ctrl-X) przerywa transfer.
+ *
+ * Nadawca wysyła bloki jeden za drugim, dopóki niepotwierdzonych danych
+ * jest mniej niż okno odbiorcy – nie czeka na każde potwierdzenie, więc
+ * nadajnik UART cały czas ma co robić. Odbiorca potwierdza co
+ * ZX_ACK_EVERY bajtów, a przy błędzie CRC albo dziurze prosi o
+ * powtórzenie od pierwszego brakującego bajtu (jak ZRPOS w ZMODEM).
+ *
+ * Przebieg (odbiorca / nadawca):
+ *   i  okno i największy blok odbiorcy    →
+ *   f  rozmiar pliku, nazwa               ←
+ *   r  pozycja startowa                   →
+ *   d  dane od 'pos' ...                  ←   a / r  potwierdzenia, powtórki →
+ *   e  koniec, CRC32 całego pliku         ←
+ *   k  CRC32 odebranego pliku             →
+ *   z  koniec sesji                       ←
+ *   x  przerwanie (w obie strony)
+ *
+ * Strona hosta: tools/zxfer.py.
+ */
+
+#ifndef ZX_BLOCK
+#define ZX_BLOCK 2048u          /* domyślny blok nadawcy */
+#endif
+#define ZX_MAX_BLOCK 4096u      /* największy blok, jaki przyjmujemy */
+#ifndef ZX_WINDOW
+#define ZX_WINDOW (16u * 1024)  /* niepotwierdzone bajty w drodze */
+#endif
+#define ZX_ACK_EVERY (ZX_WINDOW / 4)
+#define ZX_NAME_MAX 64
+
+/* Czas bez żadnego bajtu, po którym ponawiamy (ms) */
+#ifndef ZX_TIMEOUT_MS
+#define ZX_TIMEOUT_MS 1000
+#endif
+#define ZX_RETRIES 10
+#define ZX_START_RETRIES 60     /* na uruchomienie programu po stronie hosta */
+
+enum {
+  ZX_ERR_CANCEL = -60,  /* przerwane (Ctrl-X Ctrl-X albo 'x' od drugiej strony) */
+  ZX_ERR_TIMEOUT = -61, /* druga strona milczy */
+  ZX_ERR_FS = -62,      /* błąd dysku RAM */
+  ZX_ERR_TOOBIG = -63,  /* plik większy niż FAT16_MAX_FILESIZE */
+  ZX_ERR_CRC = -64,     /* CRC32 całego pliku się nie zgadza */
+};
+
+typedef struct {
+  char name[ZX_NAME_MAX];
+  uint32_t bytes;
+  uint32_t crc32;
+  uint32_t frames;      /* ramki danych wysłane / przyjęte */
+  uint32_t rewinds;     /* powtórki od wskazanej pozycji */
+  uint32_t bad_frames;  /* odrzucone (CRC, za długie) */
+  uint32_t timeouts;
+  uint64_t ticks;
+} zx_stats_t;
+
+/* Odbiera jeden plik do 'path' na dysku RAM; pusta ścieżka albo katalog
+ * (kończy się '/') – nazwa od nadawcy. 0 gdy OK. */
+int zx_receive(const char *path, zx_stats_t *st);
+
+/* Wysyła plik 'path' z dysku RAM. 0 gdy OK. */
+int zx_send(const char *path, zx_stats_t *st);
+
+#endif /* CYGNUS_ZXFER_H */
@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+#
+# [Cygnus] - [tools/zxfer.py]
+#
+# Copyright (C) [2025] [Szymon Grajner]
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the European Union Public Licence (EUPL) V.1.2 or - as
+# soon as they will be approved by the European Commission - subsequent
+# versions of the EUPL (the "Licence").
+#
+# You may not use this work except in compliance with the Licence.
+# You may obtain a copy of the Licence at:
+# https://joinup.ec.europa.eu/software/page/eupl/licence-eupl
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the Licence is distributed on an "AS IS" basis,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the Licence for the specific language governing permissions and
+# limitations under the Licence.
+#
+"""Host side of the Cygnus rz/sz serial transfer (see src/zxfer.h).
+
+  zxfer.py --pipe /tmp/cyg send FILE [/ram/DEST]   # guest runs `rz DEST`
+  zxfer.py --unix /tmp/cyg.sock recv /ram/FILE [OUT]
+
+Connections:
+  --pipe BASE      QEMU -serial pipe:BASE (BASE.in / BASE.out fifos)
+  --unix PATH      QEMU -serial unix:PATH,server,nowait
+  --tcp HOST:PORT  QEMU -serial tcp::PORT,server,nowait
+
+By default the matching shell command (rz/sz) is typed first; --no-cmd
+skips that when it was already entered by hand.
+"""
+
+import argparse
+import os
+import random
+import select
+import socket
+import struct
+import sys
+import time
+import zlib
+
+ZDLE = 0x18
+MAX_BLOCK = 4096
+WINDOW = 16 * 1024
+ACK_EVERY = WINDOW // 4
+RETRIES = 10
+
+
+class Cancel(Exception):
+    pass
+
+
+class Timeout(Exception):
+    pass
+
+
+class Link:
+    def __init__(self, rfd, wfd, timeout, corrupt=0.0):
+        self.rfd, self.wfd = rfd, wfd
+        self.timeout = timeout
+        self.corrupt = corrupt
+        self.buf = bytearray()
+        self.pos = 0
+
+    def write(self, data):
+        if self.corrupt and random.random() < self.corrupt and len(data) > 8:
+            data = bytearray(data)
+            data[random.randrange(2, len(data))] ^= 0x01
+        view = memoryview(bytes(data))
+        while view:
+            n = os.write(self.wfd, view)
+            view = view[n:]
+
+    def pending(self):
+        if self.pos < len(self.buf):
+            return True
+        return bool(select.select([self.rfd], [], [], 0)[0])
+
+    def byte(self):
+        if self.pos == len(self.buf):
+            if not select.select([self.rfd], [], [], self.timeout)[0]:
+                raise Timeout()
+            data = os.read(self.rfd, 65536)
+            if not data:
+                raise Cancel("connection closed")
+            self.buf, self.pos = bytearray(data), 0
+        b = self.buf[self.pos]
+        self.pos += 1
+        return b
+
+
+def needs_esc(b):
+    return b == ZDLE or (b & 0x7F) in (0x11, 0x13)
+
+
+def frame(ftype, pos, data=b""):
+    body = struct.pack("<IH", pos, len(data)) + bytes(data)
+    crc = zlib.crc32(bytes([ord(ftype)]) + body)
+    out = bytearray([ZDLE, ord(ftype)])
+    for b in body + struct.pack("<I", crc):
+        if needs_esc(b):
+            out += bytes([ZDLE, b ^ 0x40])
+        else:
+            out.append(b)
+    return out
+
+
+MARK = 0x100
+
+
+def get_esc(link):
+    c = link.byte()
+    if c != ZDLE:
+        return c
+    c = link.byte()
+    if c == ZDLE:
+        raise Cancel("cancelled by peer")
+    if ord("a") <= c <= ord("z"):
+        return MARK | c
+    return c ^ 0x40
+
+
+def read_frame(link, stats):
+    """Returns (type, pos, data) or None for a damaged frame."""
+    c = get_esc(link)
+    while not c & MARK:
+        c = get_esc(link)
+    while True:
+        ftype, raw, need, restart = c & 0xFF, bytearray(), 6, False
+        while len(raw) < need:
+            c = get_esc(link)
+            if c & MARK:
+                restart = True
+                break
+            raw.append(c)
+            if len(raw) == 6:
+                length = raw[4] | raw[5] << 8
+                if length > MAX_BLOCK:
+                    stats["bad"] += 1
+                    return None
+                need = 6 + length + 4
+        if restart:
+            continue
+        body, crc = bytes(raw[:-4]), struct.unpack("<I", raw[-4:])[0]
+        if zlib.crc32(bytes([ftype]) + body) != crc:
+            stats["bad"] += 1
+            return None
+        pos = struct.unpack("<I", body[:4])[0]
+        return chr(ftype), pos, body[6:]
+
+
+def recv_frame(link, stats):
+    """read_frame with timeouts counted instead of raised."""
+    try:
+        return read_frame(link, stats)
+    except Timeout:
+        stats["timeouts"] += 1
+        return "timeout"
+
+
+def send_file(link, data, name, block, stats):
+    crc = zlib.crc32(data)
+    size = len(data)
+    window, tries, stage = WINDOW, 0, 0
+    # handshake: wait for 'i', answer 'f', wait for 'r'
+    while True:
+        f = recv_frame(link, stats)
+        if f == "timeout":
+            tries += 1
+            if tries > 60:
+                raise Timeout()
+            if stage:
+                link.write(frame("f", size, name))
+            continue
+        if f is None:
+            continue
+        t, pos, payload = f
+        if t == "x":
+            raise Cancel("receiver aborted")
+        if t == "i":
+            window = min(window, pos or window)
+            if len(payload) >= 2:
+                block = min(block, struct.unpack("<H", payload[:2])[0] or block)
+            block = min(block, window)
+            link.write(frame("f", size, name))
+            stage = 1
+        elif t == "r" and stage:
+            break
+    pos = acked = min(pos, size)
+    eof_sent, tries = False, 0
+    while True:
+        while pos < size and pos - acked < window and not link.pending():
+            n = min(block, size - pos)
+            link.write(frame("d", pos, data[pos:pos + n]))
+            pos += n
+            stats["frames"] += 1
+        if pos == size and not eof_sent:
+            link.write(frame("e", size, struct.pack("<I", crc)))
+            eof_sent = True
+        if pos < size and pos - acked < window and not link.pending():
+            continue
+        f = recv_frame(link, stats)
+        if f == "timeout":
+            tries += 1
+            if tries > RETRIES:
+                link.write(frame("x", 0))
+                raise Timeout()
+            pos, eof_sent = acked, False
+            continue
+        if f is None:
+            continue
+        tries = 0
+        t, fpos, payload = f
+        if t == "a" and acked < fpos <= size:
+            acked = fpos
+        elif t == "r" and fpos <= size:
+            acked = pos = fpos
+            eof_sent = False
+            stats["rewinds"] += 1
+        elif t == "k":
+            link.write(frame("z", 0))
+            if fpos != crc:
+                raise Cancel("CRC mismatch: sent %08x, guest has %08x" % (crc, fpos))
+            return crc
+        elif t == "x":
+            raise Cancel("receiver aborted")
+
+
+def recv_file(link, stats):
+    init = struct.pack("<H", MAX_BLOCK)
+    out, name, size = bytearray(), None, 0
+    acked, tries, nak = 0, 0, False
+    link.write(frame("i", WINDOW, init))
+    while True:
+        f = recv_frame(link, stats)
+        if f == "timeout":
+            tries += 1
+            if tries > (60 if name is None else RETRIES):
+                link.write(frame("x", 0))
+                raise Timeout()
+            link.write(frame("i", WINDOW, init) if name is None else frame("r", len(out)))
+            continue
+        if f is None:
+            if name is not None and not nak:
+                link.write(frame("r", len(out)))
+                nak = True
+            continue
+        tries = 0
+        t, pos, payload = f
+        if t == "x":
+            raise Cancel("sender aborted")
+        if t == "f":
+            if name is None:
+                name, size = payload.decode("utf-8", "replace"), pos
+            link.write(frame("r", len(out)))
+        elif name is None:
+            continue
+        elif t == "d":
+            if pos != len(out):
+                if pos > len(out) and not nak:
+                    link.write(frame("r", len(out)))
+                    stats["rewinds"] += 1
+                    nak = True
+                continue
+            out += payload
+            stats["frames"] += 1
+            nak = False
+            if len(out) - acked >= ACK_EVERY:
+                link.write(frame("a", len(out)))
+                acked = len(out)
+        elif t == "e":
+            if pos != len(out) or len(out) != size:
+                link.write(frame("r", len(out)))
+                continue
+            crc = zlib.crc32(out)
+            link.write(frame("k", crc, struct.pack("<I", crc)))
+            if len(payload) == 4 and struct.unpack("<I", payload)[0] != crc:
+                raise Cancel("CRC mismatch")
+            # linger for 'z'; a lost 'k' shows up as a repeated 'e'
+            try:
+                for _ in range(3):
+                    f = recv_frame(link, stats)
+                    if f == "timeout" or (f and f[0] in "zx"):
+                        break
+                    if f and f[0] == "e":
+                        link.write(frame("k", crc, struct.pack("<I", crc)))
+            except Cancel:
+                pass
+            return name, bytes(out)
+
+
+def connect(args):
+    if args.pipe:
+        wfd = os.open(args.pipe + ".in", os.O_WRONLY)
+        rfd = os.open(args.pipe + ".out", os.O_RDONLY)
+        return rfd, wfd
+    if args.unix or args.tcp:
+        if args.unix:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(args.unix)
+        else:
+            host, port = args.tcp.rsplit(":", 1)
+            s = socket.create_connection((host or "localhost", int(port)))
+        args.sock = s  # keep it open
+        return s.fileno(), s.fileno()
+    if args.fd:
+        r, w = args.fd.split(",")
+        return int(r), int(w)
+    sys.exit("zxfer: choose --pipe, --unix or --tcp")
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+                                 formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("--pipe")
+    ap.add_argument("--unix")
+    ap.add_argument("--tcp")
+    ap.add_argument("--fd", help=argparse.SUPPRESS)  # "R,W" – tests
+    ap.add_argument("--no-cmd", action="store_true", help="do not type rz/sz into the shell")
+    ap.add_argument("--block", type=int, default=MAX_BLOCK, help="data block size (<= 4096)")
+    ap.add_argument("--timeout", type=float, default=2.0, help="seconds without a byte")
+    ap.add_argument("--corrupt", type=float, default=0.0,
+                    help="probability of flipping a bit in each sent frame (testing)")
+    ap.add_argument("mode", choices=["send", "recv"])
+    ap.add_argument("path")
+    ap.add_argument("dest", nargs="?")
+    args = ap.parse_args()
+
+    rfd, wfd = connect(args)
+    link = Link(rfd, wfd, args.timeout, args.corrupt)
+    stats = {"frames": 0, "rewinds": 0, "bad": 0, "timeouts": 0}
+    t0 = time.monotonic()
+    try:
+        if args.mode == "send":
+            with open(args.path, "rb") as fh:
+                data = fh.read()
+            dest = args.dest or "/ram/"
+            if not args.no_cmd:
+                link.write(("rz %s\r" % dest).encode())
+            crc = send_file(link, data, os.path.basename(args.path).encode(),
+                            max(1, min(args.block, MAX_BLOCK)), stats)
+            nbytes = len(data)
+        else:
+            if not args.no_cmd:
+                link.write(("sz %s\r" % args.path).encode())
+            name, data = recv_file(link, stats)
+            with open(args.dest or os.path.basename(name), "wb") as fh:
+                fh.write(data)
+            crc, nbytes = zlib.crc32(data), len(data)
+    except (Cancel, Timeout) as e:
+        sys.exit("zxfer: %s" % (str(e) or "timeout"))
+    dt = max(time.monotonic() - t0, 1e-6)
+    print("zxfer: %d B in %.2f s (%.1f KiB/s), CRC32 %08x, frames %d, rewinds %d, bad %d, timeouts %d"
+          % (nbytes, dt, nbytes / dt / 1024, crc, stats["frames"], stats["rewinds"],
+             stats["bad"], stats["timeouts"]), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()